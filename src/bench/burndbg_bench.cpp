@@ -0,0 +1,1036 @@
+//----------------------------------------------------------------------------
+// Throughput benchmark for the scan engine.
+//
+// Runs first scans, value predicates, BCD scans, refines and hit listing formatting
+// over synthetic memory images the size of a small RAM bank, Neo Geo work RAM
+// and a large ROM, and prints the best time of several runs for each case.
+// Every case also checks its hits, index for index, against the values planted
+// in the image or a plain loop over it, and the kernels are checked on their own
+// over awkward lengths and alignments first, so a quick single-iteration run
+// doubles as a smoke test of the core.
+//----------------------------------------------------------------------------
+
+#include <algorithm>
+#include <chrono>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bcd.h"
+#include "bitutils.h"
+#include "buffermemorysource.h"
+#include "hitformat.h"
+#include "m68kregion.h"
+#include "memscanslot.h"
+#include "scankernels.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    constexpr uint64_t kImageHostBase = 0x10000000;
+    constexpr uint32_t kImageM68KBase = 0x100000;
+
+    // Filler bytes never take this value, so planted values are the only hits
+    constexpr uint8_t kMarkerByte = 0xA5;
+
+    struct ImageDesc
+    {
+        const char* pName;
+        uint32_t Size;
+    };
+
+    constexpr ImageDesc kImages[] =
+    {
+        { "64K", 0x10000 },
+        { "128K", 0x20000 },
+        { "4M", 0x400000 },
+    };
+
+    constexpr uint8_t kWidths[] = { 1, 2, 4 };
+
+    // One planted value per this many elements for the scans that aren't about hit density
+    constexpr uint32_t kDefaultPlantStride = 1024;
+
+    // Hit densities for the refine cost curve, as one planted value per this many elements
+    constexpr uint32_t kRefinePlantStrides[] = { 1, 4, 16, 64, 256, 4096, 65536 };
+
+    constexpr int kDefaultIterations = 20;
+
+    int s_numFailures = 0;
+
+    void Fail(const char* pFormat, ...)
+    {
+        va_list args;
+        va_start(args, pFormat);
+        fprintf(stderr, "FAILED: ");
+        vfprintf(stderr, pFormat, args);
+        fprintf(stderr, "\n");
+        va_end(args);
+        ++s_numFailures;
+    }
+
+    // xorshift64*, so every run scans the same images
+    class Random
+    {
+    public:
+        explicit Random(uint64_t seed)
+            : m_state(seed ? seed : 1)
+        {
+        }
+
+        uint64_t Next()
+        {
+            m_state ^= m_state >> 12;
+            m_state ^= m_state << 25;
+            m_state ^= m_state >> 27;
+            return m_state * 0x2545F4914F6CDD1Dull;
+        }
+
+    private:
+        uint64_t m_state;
+    };
+
+    // Work RAM is mostly zero with the live values scattered through it, so three quarters of
+    // the filler is zero and the rest random. One value of width bytes of kMarkerByte is then
+    // planted at a random element within every plantStride elements. Longs are read at every
+    // even address, so two planted back to back would make a third match across them; the last
+    // element of each stride is left out for them. Adds the hit index a scan reports for each
+    // planted value to plantedHitsOut and returns the number planted.
+    uint32_t FillImage(uint8_t* pImage, uint32_t size, uint8_t width, uint32_t plantStride, uint64_t seed,
+        std::vector<uint32_t>& plantedHitsOut)
+    {
+        Random random(seed);
+        for (uint32_t i = 0; i < size; ++i)
+        {
+            const uint64_t Bits = random.Next();
+            uint8_t value = (Bits & 3) == 0 ? static_cast<uint8_t>(Bits >> 8) : 0;
+            if (value == kMarkerByte)
+            {
+                value = 0x5A;
+            }
+            pImage[i] = value;
+        }
+
+        const uint32_t NumElements = size / width;
+        uint32_t numPlanted = 0;
+        for (uint32_t strideStart = 0; strideStart < NumElements; strideStart += plantStride)
+        {
+            const uint32_t StrideLength = std::min(plantStride, NumElements - strideStart);
+            const uint32_t NumChoices = width > 2 && StrideLength > 1 ? StrideLength - 1 : StrideLength;
+            const uint32_t Element = strideStart + static_cast<uint32_t>(random.Next() % NumChoices);
+            memset(pImage + static_cast<size_t>(Element) * width, kMarkerByte, width);
+            plantedHitsOut.push_back(width == 1 ? Element : Element * width / 2);
+            ++numPlanted;
+        }
+
+        return numPlanted;
+    }
+
+    uint32_t MarkerValue(uint8_t width)
+    {
+        return width == 4 ? 0xA5A5A5A5u : width == 2 ? 0xA5A5u : 0xA5u;
+    }
+
+    bool ScanForValue(MemScanSlot& slot, IMemorySource& memory, const M68KRegion& region, uint8_t width, uint32_t value, ScanPredicate predicate)
+    {
+        switch (width)
+        {
+        case 1:
+            return slot.ScanForByte(memory, region, kImageHostBase, static_cast<uint8_t>(value), predicate);
+        case 2:
+            return slot.ScanForHalfWord(memory, region, kImageHostBase, static_cast<uint16_t>(value), predicate);
+        default:
+            return slot.ScanForWord(memory, region, kImageHostBase, value, predicate);
+        }
+    }
+
+    // A value predicate with its values, truncated to the scan width when used
+    struct ValuePredicateCase
+    {
+        const char* pName;
+        ScanPredicate Predicate;
+        uint32_t Values[kMaxScanOperandValues];
+        uint32_t NumValues;
+    };
+
+    // The filler is mostly zero, so none of these match everywhere
+    constexpr ValuePredicateCase kValuePredicateCases[] =
+    {
+        { "eq", ScanPredicate::Equal, { 0xA5A5A5A5 }, 1 },
+        { "range", ScanPredicate::InRange, { 0x40, 0xC0 }, 2 },
+        { "mask", ScanPredicate::MaskEqual, { 0xF0F0F0F0, 0xA0A0A0A0 }, 2 },
+        { "any", ScanPredicate::AnyOf, { 0xA5A5A5A5, 0x01, 0x5A, 0x80, 0x7F, 0xFE, 0x33, 0x10 }, 8 },
+    };
+
+    template<typename TScanType>
+    ScanOperand<TScanType> MakeCaseOperand(const ValuePredicateCase& predicateCase)
+    {
+        TScanType values[kMaxScanOperandValues];
+        for (uint32_t i = 0; i < kMaxScanOperandValues; ++i)
+        {
+            values[i] = static_cast<TScanType>(predicateCase.Values[i]);
+        }
+
+        return MakeScanOperand(values, predicateCase.NumValues);
+    }
+
+    // Plain loop over the image as the 68000 sees it, for checking the kernels against. Lists
+    // the hit index of every match the way a slot numbers them: bytes by host offset, words and
+    // longs by even address.
+    template<typename TScanType>
+    std::vector<uint32_t> FindMatchesReference(const uint8_t* pImage, uint32_t size, const ValuePredicateCase& predicateCase)
+    {
+        const ScanOperand<TScanType> Operand = MakeCaseOperand<TScanType>(predicateCase);
+        const uint32_t Stride = sizeof(TScanType) == 1 ? 1 : 2;
+        std::vector<uint32_t> hits;
+        for (uint32_t index = 0; index * Stride + sizeof(TScanType) <= size; ++index)
+        {
+            const TScanType Value = ReadM68KValue<TScanType>(pImage, sizeof(TScanType) == 1 ? index ^ 1 : index * Stride);
+            if (MatchesPredicate(predicateCase.Predicate, Value, Value, Operand))
+            {
+                hits.push_back(index);
+            }
+        }
+
+        return hits;
+    }
+
+    std::vector<uint32_t> FindMatchesReference(const uint8_t* pImage, uint32_t size, uint8_t width, const ValuePredicateCase& predicateCase)
+    {
+        switch (width)
+        {
+        case 1:
+            return FindMatchesReference<uint8_t>(pImage, size, predicateCase);
+        case 2:
+            return FindMatchesReference<uint16_t>(pImage, size, predicateCase);
+        default:
+            return FindMatchesReference<uint32_t>(pImage, size, predicateCase);
+        }
+    }
+
+    std::vector<uint32_t> GetHitIndices(const MemScanSlot& slot)
+    {
+        std::vector<uint32_t> hits;
+        hits.reserve(slot.GetNumEntries());
+        slot.GetHits().ForEach([&hits](uint32_t hitIndex) { hits.push_back(hitIndex); });
+        return hits;
+    }
+
+    // Index of the first hit where two lists differ, for failure messages
+    size_t FirstDifference(const std::vector<uint32_t>& left, const std::vector<uint32_t>& right)
+    {
+        size_t i = 0;
+        while (i < left.size() && i < right.size() && left[i] == right[i])
+        {
+            ++i;
+        }
+
+        return i;
+    }
+
+    bool ScanForCase(MemScanSlot& slot, IMemorySource& memory, const M68KRegion& region, uint8_t width, const ValuePredicateCase& predicateCase)
+    {
+        switch (width)
+        {
+        case 1:
+            return slot.ScanForByte(memory, region, kImageHostBase, MakeCaseOperand<uint8_t>(predicateCase), predicateCase.Predicate);
+        case 2:
+            return slot.ScanForHalfWord(memory, region, kImageHostBase, MakeCaseOperand<uint16_t>(predicateCase), predicateCase.Predicate);
+        default:
+            return slot.ScanForWord(memory, region, kImageHostBase, MakeCaseOperand<uint32_t>(predicateCase), predicateCase.Predicate);
+        }
+    }
+
+    // BCD scans of 1 to 4 bytes. "valid" is an unchanged refine of an unknown value scan, which
+    // keeps every element that is valid BCD.
+    struct BcdCase
+    {
+        const char* pName;
+        ScanPredicate Predicate;
+        uint32_t Values[2];
+        uint32_t NumValues;
+    };
+
+    constexpr BcdCase kBcdCases[] =
+    {
+        { "eq", ScanPredicate::Equal, { 12 }, 1 },
+        { "range", ScanPredicate::InRange, { 10, 60 }, 2 },
+        { "valid", ScanPredicate::Unchanged, {}, 0 },
+    };
+
+    constexpr uint8_t kBcdWidths[] = { 1, 2, 3, 4 };
+
+    // Plain loop decoding every element of the image, for checking BCD scans against
+    std::vector<uint32_t> FindBcdMatchesReference(const uint8_t* pImage, uint32_t size, uint8_t width, const BcdCase& bcdCase)
+    {
+        const ScanOperand<uint32_t> Operand = MakeScanOperand(bcdCase.Values, bcdCase.NumValues);
+        const uint32_t Stride = width == 1 ? 1 : 2;
+        std::vector<uint32_t> hits;
+        for (uint32_t index = 0; index * Stride + width <= size; ++index)
+        {
+            const uint32_t Value = ReadM68KBcd(pImage, width == 1 ? index ^ 1 : index * Stride, width);
+            if (Value != kInvalidBcd && MatchesPredicate(bcdCase.Predicate, Value, Value, Operand))
+            {
+                hits.push_back(index);
+            }
+        }
+
+        return hits;
+    }
+
+    // Runs setup then run, iterations times over, and returns the fastest run in seconds
+    template<typename TSetup, typename TRun>
+    double TimeBest(int iterations, TSetup&& setup, TRun&& run)
+    {
+        Clock::duration best = Clock::duration::max();
+        for (int i = 0; i < iterations; ++i)
+        {
+            setup();
+            const Clock::time_point Start = Clock::now();
+            run();
+            best = std::min(best, Clock::now() - Start);
+        }
+
+        return std::chrono::duration<double>(best).count();
+    }
+
+    double MegabytesPerSecond(uint64_t numBytes, double seconds)
+    {
+        return seconds > 0 ? numBytes / seconds / (1024.0 * 1024.0) : 0;
+    }
+
+    // A synthetic image mapped at kImageHostBase, standing in for one region of the target
+    struct BenchImage
+    {
+        BufferMemorySource Memory;
+        M68KRegion Region;
+        uint8_t* pBytes;
+        uint32_t NumPlanted;
+        std::vector<uint32_t> PlantedHits;
+
+        BenchImage(const ImageDesc& desc, uint8_t width, uint32_t plantStride)
+            : Region{ desc.pName, kImageM68KBase, desc.Size }
+        {
+            pBytes = Memory.AddRegion(kImageHostBase, desc.Size);
+            NumPlanted = FillImage(pBytes, desc.Size, width, plantStride, desc.Size ^ width, PlantedHits);
+        }
+    };
+
+    std::vector<ScanKernels::KernelLevel> GetKernelLevels()
+    {
+        std::vector<ScanKernels::KernelLevel> levels;
+        const int Supported = static_cast<int>(ScanKernels::GetSupportedKernelLevel());
+        for (int level = 0; level <= Supported; ++level)
+        {
+            levels.push_back(static_cast<ScanKernels::KernelLevel>(level));
+        }
+
+        return levels;
+    }
+
+    // New scans for a value planted once per kDefaultPlantStride elements, i.e. the read of the
+    // whole region plus one kernel pass over it
+    void BenchFirstScan(int iterations)
+    {
+        printf("First scan\n");
+        printf("  %-6s %5s  %-7s %9s %11s %10s\n", "image", "width", "kernel", "hits", "best (us)", "MB/s");
+
+        for (const ImageDesc& Image : kImages)
+        {
+            for (const uint8_t Width : kWidths)
+            {
+                BenchImage image(Image, Width, kDefaultPlantStride);
+                for (const ScanKernels::KernelLevel Level : GetKernelLevels())
+                {
+                    ScanKernels::SetKernelLevel(Level);
+
+                    MemScanSlot slot;
+                    bool scanned = true;
+                    const double Seconds = TimeBest(iterations,
+                        [&slot]() { slot.Clear(); },
+                        [&]() { scanned &= ScanForValue(slot, image.Memory, image.Region, Width, MarkerValue(Width), ScanPredicate::Equal); });
+
+                    const std::vector<uint32_t> Hits = GetHitIndices(slot);
+                    if (!scanned || Hits != image.PlantedHits)
+                    {
+                        Fail("first scan of %s/%u with %s found %u hits, expected %u, differing from hit %zu on", Image.pName, Width,
+                            ScanKernels::GetKernelLevelName(Level), slot.GetNumEntries(), image.NumPlanted,
+                            FirstDifference(Hits, image.PlantedHits));
+                    }
+
+                    printf("  %-6s %5u  %-7s %9u %11.1f %10.1f\n", Image.pName, Width, ScanKernels::GetKernelLevelName(Level),
+                        slot.GetNumEntries(), Seconds * 1e6, MegabytesPerSecond(Image.Size, Seconds));
+                }
+            }
+        }
+
+        ScanKernels::SetKernelLevel(ScanKernels::GetSupportedKernelLevel());
+        printf("\n");
+    }
+
+    // Every value predicate both as a first scan, which collects hit indices, and as a refine
+    // of an unknown value scan, which filters the dense bitmap. Both must agree with a plain loop.
+    void BenchValuePredicates(int iterations)
+    {
+        printf("Value predicates (first scan, and refine of an unknown value scan)\n");
+        printf("  %-6s %5s  %-6s %-7s %9s %11s %11s\n", "image", "width", "op", "kernel", "hits", "first (us)", "refine (us)");
+
+        for (const ImageDesc& Image : kImages)
+        {
+            for (const uint8_t Width : kWidths)
+            {
+                BenchImage image(Image, Width, kDefaultPlantStride);
+                const uint8_t* pImage = image.Memory.GetDirectPointer(kImageHostBase, Image.Size);
+                for (const ValuePredicateCase& Case : kValuePredicateCases)
+                {
+                    const std::vector<uint32_t> Expected = FindMatchesReference(pImage, Image.Size, Width, Case);
+                    for (const ScanKernels::KernelLevel Level : GetKernelLevels())
+                    {
+                        ScanKernels::SetKernelLevel(Level);
+
+                        MemScanSlot slot;
+                        bool scanned = true;
+                        const double FirstSeconds = TimeBest(iterations,
+                            [&slot]() { slot.Clear(); },
+                            [&]() { scanned &= ScanForCase(slot, image.Memory, image.Region, Width, Case); });
+                        const std::vector<uint32_t> FirstHits = GetHitIndices(slot);
+
+                        const double RefineSeconds = TimeBest(iterations,
+                            [&]() { scanned &= slot.BeginUnknownScan(image.Memory, image.Region, kImageHostBase, Width); },
+                            [&]() { scanned &= ScanForCase(slot, image.Memory, image.Region, Width, Case); });
+                        const std::vector<uint32_t> RefineHits = GetHitIndices(slot);
+
+                        if (!scanned || FirstHits != Expected || RefineHits != Expected)
+                        {
+                            Fail("%s scan of %s/%u with %s found %zu hits first and %zu refining, expected %zu, differing from hits %zu and %zu on",
+                                Case.pName, Image.pName, Width, ScanKernels::GetKernelLevelName(Level), FirstHits.size(), RefineHits.size(),
+                                Expected.size(), FirstDifference(FirstHits, Expected), FirstDifference(RefineHits, Expected));
+                        }
+
+                        printf("  %-6s %5u  %-6s %-7s %9zu %11.1f %11.1f\n", Image.pName, Width, Case.pName,
+                            ScanKernels::GetKernelLevelName(Level), FirstHits.size(), FirstSeconds * 1e6, RefineSeconds * 1e6);
+                    }
+                }
+            }
+        }
+
+        ScanKernels::SetKernelLevel(ScanKernels::GetSupportedKernelLevel());
+        printf("\n");
+    }
+
+    // "Unchanged" refines of an unknown value scan, where every element of the region is still a
+    // hit. This is the dense worst case: a full read plus a vectorized pass over old and new copies.
+    void BenchDenseRefine(int iterations)
+    {
+        printf("Dense refine (unknown value, unchanged)\n");
+        printf("  %-6s %5s  %-7s %9s %11s %10s\n", "image", "width", "kernel", "hits", "best (us)", "MB/s");
+
+        for (const ImageDesc& Image : kImages)
+        {
+            for (const uint8_t Width : kWidths)
+            {
+                BenchImage image(Image, Width, kDefaultPlantStride);
+                for (const ScanKernels::KernelLevel Level : GetKernelLevels())
+                {
+                    ScanKernels::SetKernelLevel(Level);
+
+                    MemScanSlot slot;
+                    bool scanned = slot.BeginUnknownScan(image.Memory, image.Region, kImageHostBase, Width);
+                    const double Seconds = TimeBest(iterations,
+                        []() {},
+                        [&]() { scanned &= ScanForValue(slot, image.Memory, image.Region, Width, 0, ScanPredicate::Unchanged); });
+
+                    const uint32_t NumElements = MemScanSlot::GetNumElements(Image.Size, Width, ScanAlignment::Even);
+                    if (!scanned || slot.GetNumEntries() != NumElements)
+                    {
+                        Fail("dense refine of %s/%u with %s kept %u hits, expected %u", Image.pName, Width,
+                            ScanKernels::GetKernelLevelName(Level), slot.GetNumEntries(), NumElements);
+                    }
+
+                    printf("  %-6s %5u  %-7s %9u %11.1f %10.1f\n", Image.pName, Width, ScanKernels::GetKernelLevelName(Level),
+                        slot.GetNumEntries(), Seconds * 1e6, MegabytesPerSecond(Image.Size, Seconds));
+                }
+            }
+        }
+
+        ScanKernels::SetKernelLevel(ScanKernels::GetSupportedKernelLevel());
+        printf("\n");
+    }
+
+    // BCD scans, where eq looks for the encoded value with the plain integer scans and
+    // everything else decodes each element through the byte table first
+    void BenchBcdScans(int iterations)
+    {
+        printf("BCD scans (eq and range first scans, valid as an unchanged refine of an unknown scan)\n");
+        printf("  %-6s %5s  %-6s %-7s %9s %11s %10s\n", "image", "width", "op", "kernel", "hits", "best (us)", "MB/s");
+
+        for (const ImageDesc& Image : kImages)
+        {
+            for (const uint8_t Width : kBcdWidths)
+            {
+                BenchImage image(Image, 1, kDefaultPlantStride);
+                const uint8_t* pImage = image.Memory.GetDirectPointer(kImageHostBase, Image.Size);
+                for (const BcdCase& Case : kBcdCases)
+                {
+                    const std::vector<uint32_t> Expected = FindBcdMatchesReference(pImage, Image.Size, Width, Case);
+                    const ScanOperand<uint32_t> Operand = MakeScanOperand(Case.Values, Case.NumValues);
+                    const bool Refines = PredicateUsesSnapshot(Case.Predicate);
+                    for (const ScanKernels::KernelLevel Level : GetKernelLevels())
+                    {
+                        ScanKernels::SetKernelLevel(Level);
+
+                        MemScanSlot slot;
+                        bool scanned = true;
+                        const double Seconds = TimeBest(iterations,
+                            [&]()
+                            {
+                                slot.Clear();
+                                if (Refines)
+                                {
+                                    scanned &= slot.BeginUnknownScan(image.Memory, image.Region, kImageHostBase, Width,
+                                        ScanAlignment::Even, ScanEncoding::Bcd);
+                                }
+                            },
+                            [&]() { scanned &= slot.ScanForBcd(image.Memory, image.Region, kImageHostBase, Width, Operand, Case.Predicate); });
+
+                        const std::vector<uint32_t> Hits = GetHitIndices(slot);
+                        if (!scanned || Hits != Expected)
+                        {
+                            Fail("BCD %s scan of %s/%u with %s found %zu hits, expected %zu, differing from hit %zu on", Case.pName,
+                                Image.pName, Width, ScanKernels::GetKernelLevelName(Level), Hits.size(), Expected.size(),
+                                FirstDifference(Hits, Expected));
+                        }
+
+                        printf("  %-6s %5u  %-6s %-7s %9u %11.1f %10.1f\n", Image.pName, Width, Case.pName,
+                            ScanKernels::GetKernelLevelName(Level), slot.GetNumEntries(), Seconds * 1e6,
+                            MegabytesPerSecond(Image.Size, Seconds));
+                    }
+                }
+            }
+        }
+
+        ScanKernels::SetKernelLevel(ScanKernels::GetSupportedKernelLevel());
+        printf("\n");
+    }
+
+    // The old swap and sort refine costs the square of the hits, so it's only timed up to here
+    constexpr uint32_t kMaxSwapAndSortHits = 16384;
+
+    // A refine the way the fixed size slot did it before hit sets, for comparison: walk the
+    // word entries from the back, swap each one that changed out past the kept ones, then put
+    // the kept ones back in address order with a quadratic sort. Values are read straight from
+    // the host copies, so only the compaction differs from the slot's own refine. Returns the
+    // number kept, at the front of pEntries.
+    uint32_t RefineSwapAndSort(uint32_t* pEntries, uint32_t numEntries, const uint8_t* pImage, const uint8_t* pSnapshot)
+    {
+        uint32_t numKept = 0;
+        int64_t lastGoodIndex = static_cast<int64_t>(numEntries) - 1;
+        for (int64_t i = lastGoodIndex; i >= 0; --i)
+        {
+            const size_t Offset = static_cast<size_t>(pEntries[i]) * 2;
+            uint16_t value;
+            uint16_t previous;
+            memcpy(&value, pImage + Offset, sizeof(value));
+            memcpy(&previous, pSnapshot + Offset, sizeof(previous));
+            if (value == previous)
+            {
+                ++numKept;
+            }
+            else
+            {
+                std::swap(pEntries[lastGoodIndex], pEntries[i]);
+                --lastGoodIndex;
+            }
+        }
+
+        if (numKept && numKept < numEntries)
+        {
+            for (uint32_t i = 0; i < numKept - 1; ++i)
+            {
+                for (uint32_t j = i + 1; j < numKept; ++j)
+                {
+                    if (pEntries[i] > pEntries[j])
+                    {
+                        std::swap(pEntries[i], pEntries[j]);
+                    }
+                }
+            }
+        }
+
+        return numKept;
+    }
+
+    // Cost of one refine against the number of hits it has to check, from every element down
+    // to a handful. Shows where the hit set switching between a bitmap and an index list pays
+    // off, and that sparse refines scale with the hits rather than the region. The first
+    // planted value changes before each refine, so one hit drops out and the old swap and
+    // sort refine, timed alongside up to kMaxSwapAndSortHits, has to sort what's left.
+    void BenchRefineByHitCount(int iterations)
+    {
+        const uint8_t Width = 2;
+
+        printf("Refine cost by hit count (width %u, unchanged, one hit dropped; old is swap and sort)\n", Width);
+        printf("  %-6s %9s  %-6s %11s %11s %11s\n", "image", "hits", "set", "new (us)", "ns/hit", "old (us)");
+
+        for (const ImageDesc& Image : kImages)
+        {
+            for (const uint32_t PlantStride : kRefinePlantStrides)
+            {
+                if (PlantStride > Image.Size / Width)
+                {
+                    continue;
+                }
+
+                BenchImage image(Image, Width, PlantStride);
+                const std::vector<uint8_t> Snapshot(image.pBytes, image.pBytes + Image.Size);
+                const std::vector<uint32_t> Expected(image.PlantedHits.begin() + 1, image.PlantedHits.end());
+                uint8_t& droppedByte = image.pBytes[static_cast<size_t>(image.PlantedHits.front()) * Width];
+
+                MemScanSlot slot;
+                bool scanned = true;
+                const double Seconds = TimeBest(iterations,
+                    [&]()
+                    {
+                        droppedByte = kMarkerByte;
+                        slot.Clear();
+                        scanned &= ScanForValue(slot, image.Memory, image.Region, Width, MarkerValue(Width), ScanPredicate::Equal);
+                        droppedByte = static_cast<uint8_t>(~kMarkerByte);
+                    },
+                    [&]() { scanned &= ScanForValue(slot, image.Memory, image.Region, Width, 0, ScanPredicate::Unchanged); });
+
+                const std::vector<uint32_t> Hits = GetHitIndices(slot);
+                if (!scanned || Hits != Expected)
+                {
+                    Fail("refine of %s with %u planted kept %zu hits, expected %zu, differing from hit %zu on", Image.pName,
+                        image.NumPlanted, Hits.size(), Expected.size(), FirstDifference(Hits, Expected));
+                }
+
+                char oldTime[16] = "-";
+                if (image.NumPlanted <= kMaxSwapAndSortHits)
+                {
+                    std::vector<uint32_t> entries;
+                    uint32_t numKept = 0;
+                    const double OldSeconds = TimeBest(iterations,
+                        [&]() { entries = image.PlantedHits; },
+                        [&]() { numKept = RefineSwapAndSort(entries.data(), image.NumPlanted, image.pBytes, Snapshot.data()); });
+
+                    entries.resize(numKept);
+                    if (entries != Expected)
+                    {
+                        Fail("swap and sort refine of %s with %u planted kept %u hits, expected %zu, differing from hit %zu on",
+                            Image.pName, image.NumPlanted, numKept, Expected.size(), FirstDifference(entries, Expected));
+                    }
+
+                    snprintf(oldTime, sizeof(oldTime), "%.1f", OldSeconds * 1e6);
+                }
+
+                droppedByte = kMarkerByte;
+
+                printf("  %-6s %9u  %-6s %11.1f %11.2f %11s\n", Image.pName, slot.GetNumEntries(),
+                    slot.GetHits().IsDense() ? "dense" : "sparse", Seconds * 1e6,
+                    slot.GetNumEntries() ? Seconds * 1e9 / slot.GetNumEntries() : 0.0, oldTime);
+            }
+        }
+
+        printf("\n");
+    }
+
+    // Formatting a hit listing the way !slotinfo does, from values already read into the host
+    void BenchPrintFormat(int iterations)
+    {
+        const uint32_t PlantStride = 16;
+
+        printf("Hit listing format (one hit per %u elements)\n", PlantStride);
+        printf("  %-6s %5s %9s %11s %12s %10s\n", "image", "width", "lines", "best (us)", "lines/s", "MB/s");
+
+        for (const ImageDesc& Image : kImages)
+        {
+            for (const uint8_t Width : kWidths)
+            {
+                BenchImage image(Image, Width, PlantStride);
+                MemScanSlot slot;
+                if (!ScanForValue(slot, image.Memory, image.Region, Width, MarkerValue(Width), ScanPredicate::Equal))
+                {
+                    Fail("scan of %s/%u for the listing failed", Image.pName, Width);
+                    continue;
+                }
+
+                const uint8_t* pImage = image.Memory.GetDirectPointer(kImageHostBase, Image.Size);
+                std::string listing;
+                uint32_t numLines = 0;
+                const double Seconds = TimeBest(iterations,
+                    [&]()
+                    {
+                        listing.clear();
+                        listing.reserve(static_cast<size_t>(slot.GetNumEntries()) * kMaxHitLineLength);
+                        numLines = 0;
+                    },
+                    [&]()
+                    {
+                        char line[kMaxHitLineLength];
+                        uint8_t value[4];
+                        slot.GetHits().ForEach([&](uint32_t hitIndex)
+                        {
+                            CopyM68KBytes(pImage, slot.GetHitM68KOffset(hitIndex), Width, value);
+                            const size_t Length = FormatHitLine(line, sizeof(line), numLines++,
+                                slot.GetHitM68KAddress(hitIndex), value, Width);
+                            listing.append(line, Length);
+                        });
+                    });
+
+                if (numLines != image.NumPlanted)
+                {
+                    Fail("listing of %s/%u has %u lines, expected %u", Image.pName, Width, numLines, image.NumPlanted);
+                }
+
+                printf("  %-6s %5u %9u %11.1f %12.0f %10.1f\n", Image.pName, Width, numLines, Seconds * 1e6,
+                    Seconds > 0 ? numLines / Seconds : 0.0, MegabytesPerSecond(listing.size(), Seconds));
+            }
+        }
+
+        printf("\n");
+    }
+
+    //------------------------------------------------------------------------
+    // Kernel hit lists
+    //
+    // The kernels' own results, index for index, against a plain loop at every
+    // level. Lengths leave tails of every size past the vector width, starts
+    // are off the vector alignment, and the values sit around the top bit, so
+    // lane order, tail handling and unsigned comparisons all show up.
+    //------------------------------------------------------------------------
+
+    constexpr size_t kKernelCheckLengths[] = { 0, 1, 2, 3, 5, 7, 8, 9, 15, 16, 17, 31, 32, 33, 63, 64, 65, 127, 129, 255, 257, 1021, 4099 };
+    constexpr size_t kKernelCheckMaxStart = 3;
+
+    // Operand values are indices into KernelCheckValues
+    constexpr ValuePredicateCase kKernelCheckCases[] =
+    {
+        { "eq", ScanPredicate::Equal, { 3 }, 1 },
+        { "changed", ScanPredicate::Changed, {}, 0 },
+        { "unchanged", ScanPredicate::Unchanged, {}, 0 },
+        { "inc", ScanPredicate::Increased, {}, 0 },
+        { "dec", ScanPredicate::Decreased, {}, 0 },
+        { "incby", ScanPredicate::IncreasedBy, { 1 }, 1 },
+        { "decby", ScanPredicate::DecreasedBy, { 1 }, 1 },
+        { "range", ScanPredicate::InRange, { 2, 9 }, 2 },
+        { "mask", ScanPredicate::MaskEqual, { 6, 2 }, 2 },
+        { "any", ScanPredicate::AnyOf, { 1, 4, 9, 11 }, 4 },
+    };
+
+    template<typename TScanType>
+    TScanType KernelCheckValue(uint64_t index)
+    {
+        const TScanType High = static_cast<TScanType>(1u << (sizeof(TScanType) * 8 - 1));
+        const TScanType Values[] =
+        {
+            0, 1, 2, 3, 4, 5, 6, 7,
+            static_cast<TScanType>(High - 1), High, static_cast<TScanType>(High + 1), static_cast<TScanType>(~0u),
+        };
+        return Values[index % (sizeof(Values) / sizeof(Values[0]))];
+    }
+
+    template<typename TScanType>
+    void CheckKernelHitsOfWidth(Random& random, uint32_t& numChecksOut)
+    {
+        const size_t Capacity = kKernelCheckLengths[sizeof(kKernelCheckLengths) / sizeof(kKernelCheckLengths[0]) - 1] + kKernelCheckMaxStart;
+        std::vector<TScanType> oldValues(Capacity);
+        std::vector<TScanType> newValues(Capacity);
+        for (size_t i = 0; i < Capacity; ++i)
+        {
+            const uint64_t Bits = random.Next();
+            oldValues[i] = KernelCheckValue<TScanType>(Bits);
+            switch ((Bits >> 8) & 3)
+            {
+            case 0:
+                newValues[i] = oldValues[i];
+                break;
+            case 1:
+                newValues[i] = static_cast<TScanType>(oldValues[i] + 1);
+                break;
+            case 2:
+                newValues[i] = static_cast<TScanType>(oldValues[i] - 1);
+                break;
+            default:
+                newValues[i] = KernelCheckValue<TScanType>(Bits >> 16);
+                break;
+            }
+        }
+
+        for (const ValuePredicateCase& Case : kKernelCheckCases)
+        {
+            TScanType operandValues[kMaxScanOperandValues];
+            for (uint32_t i = 0; i < kMaxScanOperandValues; ++i)
+            {
+                operandValues[i] = Case.Predicate == ScanPredicate::IncreasedBy || Case.Predicate == ScanPredicate::DecreasedBy
+                    ? static_cast<TScanType>(Case.Values[i])
+                    : KernelCheckValue<TScanType>(Case.Values[i]);
+            }
+            const ScanOperand<TScanType> Operand = MakeScanOperand(operandValues, Case.NumValues);
+            const bool UsesSnapshot = PredicateUsesSnapshot(Case.Predicate);
+
+            for (const size_t Length : kKernelCheckLengths)
+            {
+                for (size_t start = 0; start <= kKernelCheckMaxStart; ++start)
+                {
+                    const TScanType* pOld = oldValues.data() + start;
+                    const TScanType* pNew = newValues.data() + start;
+                    std::vector<uint32_t> expected;
+                    for (size_t i = 0; i < Length; ++i)
+                    {
+                        if (MatchesPredicate(Case.Predicate, pOld[i], pNew[i], Operand))
+                        {
+                            expected.push_back(static_cast<uint32_t>(i));
+                        }
+                    }
+
+                    // Candidates start out as a random pattern, which filtering may only thin out
+                    const size_t NumWords = (Length + 63) / 64;
+                    std::vector<uint64_t> initialBits(NumWords);
+                    for (size_t word = 0; word < NumWords; ++word)
+                    {
+                        initialBits[word] = random.Next() | random.Next();
+                    }
+                    if (Length % 64 != 0)
+                    {
+                        initialBits[NumWords - 1] &= (1ull << (Length % 64)) - 1;
+                    }
+                    std::vector<uint64_t> expectedBits(NumWords);
+                    for (const uint32_t Index : expected)
+                    {
+                        expectedBits[Index / 64] |= initialBits[Index / 64] & (1ull << (Index % 64));
+                    }
+
+                    for (const ScanKernels::KernelLevel Level : GetKernelLevels())
+                    {
+                        ScanKernels::SetKernelLevel(Level);
+                        const char* pLevelName = ScanKernels::GetKernelLevelName(Level);
+
+                        if (!UsesSnapshot)
+                        {
+                            // Once with room for every hit, and once stopping halfway, as a full batch would
+                            std::vector<uint32_t> found(Length + 1);
+                            found.resize(ScanKernels::FindMatches(pNew, Length, Case.Predicate, Operand, found.data(), Length));
+                            const size_t MaxIndices = expected.size() / 2;
+                            std::vector<uint32_t> partial(MaxIndices + 1);
+                            partial.resize(ScanKernels::FindMatches(pNew, Length, Case.Predicate, Operand, partial.data(), MaxIndices));
+                            const std::vector<uint32_t> ExpectedPartial(expected.begin(), expected.begin() + MaxIndices);
+
+                            if (found != expected || partial != ExpectedPartial)
+                            {
+                                Fail("%s FindMatches of width %u with %s over %zu elements from %zu found %zu hits, expected %zu, differing from hit %zu on",
+                                    Case.pName, static_cast<uint32_t>(sizeof(TScanType)), pLevelName, Length, start, found.size(),
+                                    expected.size(), found != expected ? FirstDifference(found, expected) : FirstDifference(partial, ExpectedPartial));
+                            }
+                            ++numChecksOut;
+                        }
+
+                        std::vector<uint64_t> bits = initialBits;
+                        const size_t NumRemaining = ScanKernels::FilterCandidates(UsesSnapshot ? pOld : nullptr, pNew, Length,
+                            Case.Predicate, Operand, bits.data());
+                        size_t expectedRemaining = 0;
+                        for (const uint64_t Word : expectedBits)
+                        {
+                            expectedRemaining += static_cast<size_t>(PopCount64(Word));
+                        }
+
+                        if (bits != expectedBits || NumRemaining != expectedRemaining)
+                        {
+                            Fail("%s FilterCandidates of width %u with %s over %zu elements from %zu kept %zu candidates, expected %zu",
+                                Case.pName, static_cast<uint32_t>(sizeof(TScanType)), pLevelName, Length, start, NumRemaining,
+                                expectedRemaining);
+                        }
+                        ++numChecksOut;
+                    }
+                }
+            }
+        }
+    }
+
+    void CheckKernelHits()
+    {
+        Random random(0x5EED);
+        uint32_t numChecks = 0;
+        CheckKernelHitsOfWidth<uint8_t>(random, numChecks);
+        CheckKernelHitsOfWidth<uint16_t>(random, numChecks);
+        CheckKernelHitsOfWidth<uint32_t>(random, numChecks);
+        ScanKernels::SetKernelLevel(ScanKernels::GetSupportedKernelLevel());
+
+        printf("Kernel hit lists\n");
+        printf("  %u kernel calls compared hit for hit with a plain loop\n\n", numChecks);
+    }
+
+    // Values planted at known 68K addresses in FBNeo's layout, where each 16-bit word is kept in
+    // host order. Longs have their halves the other way round in the host and anything at an odd
+    // address straddles two host words, so a plain scan of the host bytes finds none of these.
+    void CheckM68KLayout()
+    {
+        struct LayoutCase
+        {
+            const char* pName;
+            uint8_t Width;
+            uint32_t Value;
+            ScanAlignment Alignment;
+            std::vector<uint32_t> Expected;
+        };
+
+        const LayoutCase Cases[] =
+        {
+            { "long", 4, 0x12345678, ScanAlignment::Even, { 0x100, 0x202 } },
+            { "long", 4, 0x12345678, ScanAlignment::Any, { 0x100, 0x202, 0x301 } },
+            { "word", 2, 0x1234, ScanAlignment::Even, { 0x100, 0x202, 0x400 } },
+            { "word", 2, 0x1234, ScanAlignment::Any, { 0x100, 0x202, 0x301, 0x400, 0x501 } },
+            { "byte", 1, 0x34, ScanAlignment::Any, { 0x101, 0x203, 0x302, 0x401, 0x502 } },
+        };
+
+        const ImageDesc Image = kImages[1];
+        BufferMemorySource memory;
+        uint8_t* pHost = memory.AddRegion(kImageHostBase, Image.Size);
+        memset(pHost, 0, Image.Size);
+        const M68KRegion Region{ Image.pName, kImageM68KBase, Image.Size };
+
+        auto Plant = [pHost](uint32_t offset, const std::vector<uint8_t>& bytes)
+        {
+            for (uint32_t i = 0; i < bytes.size(); ++i)
+            {
+                pHost[(offset + i) ^ 1] = bytes[i];
+            }
+        };
+        Plant(0x100, { 0x12, 0x34, 0x56, 0x78 });
+        Plant(0x202, { 0x12, 0x34, 0x56, 0x78 });
+        Plant(0x301, { 0x12, 0x34, 0x56, 0x78 });
+        Plant(0x400, { 0x12, 0x34 });
+        Plant(0x501, { 0x12, 0x34 });
+
+        printf("68K layout\n");
+        for (const LayoutCase& Case : Cases)
+        {
+            for (const ScanKernels::KernelLevel Level : GetKernelLevels())
+            {
+                ScanKernels::SetKernelLevel(Level);
+
+                for (int unknown = 0; unknown < 2; ++unknown)
+                {
+                    MemScanSlot slot;
+                    bool scanned = true;
+                    const ScanPredicate Predicate = ScanPredicate::Equal;
+                    if (unknown)
+                    {
+                        scanned &= slot.BeginUnknownScan(memory, Region, kImageHostBase, Case.Width, Case.Alignment);
+                    }
+
+                    switch (Case.Width)
+                    {
+                    case 1:
+                        scanned &= slot.ScanForByte(memory, Region, kImageHostBase, MakeScanOperand(static_cast<uint8_t>(Case.Value)), Predicate);
+                        break;
+                    case 2:
+                        scanned &= slot.ScanForHalfWord(memory, Region, kImageHostBase, MakeScanOperand(static_cast<uint16_t>(Case.Value)), Predicate, Case.Alignment);
+                        break;
+                    default:
+                        scanned &= slot.ScanForWord(memory, Region, kImageHostBase, MakeScanOperand(Case.Value), Predicate, Case.Alignment);
+                        break;
+                    }
+
+                    std::vector<uint32_t> found;
+                    bool valuesMatch = true;
+                    slot.GetHits().ForEach([&](uint32_t hitIndex)
+                    {
+                        const uint32_t Offset = slot.GetHitM68KOffset(hitIndex);
+                        uint8_t value[4];
+                        CopyM68KBytes(pHost, Offset, Case.Width, value);
+                        uint32_t decoded = 0;
+                        for (uint32_t i = 0; i < Case.Width; ++i)
+                        {
+                            decoded = (decoded << 8) | value[i];
+                        }
+                        valuesMatch &= decoded == Case.Value;
+                        found.push_back(Offset);
+                    });
+
+                    if (!scanned || !valuesMatch || found != Case.Expected)
+                    {
+                        Fail("%s scan for %X at %s addresses with %s%s found %u hits, expected %u", Case.pName, Case.Value,
+                            Case.Alignment == ScanAlignment::Any ? "any" : "even", ScanKernels::GetKernelLevelName(Level),
+                            unknown ? " after an unknown scan" : "", static_cast<uint32_t>(found.size()),
+                            static_cast<uint32_t>(Case.Expected.size()));
+                    }
+                }
+            }
+
+            printf("  %-5s %-4s addresses: %u hits\n", Case.pName,
+                Case.Alignment == ScanAlignment::Any ? "any" : "even", static_cast<uint32_t>(Case.Expected.size()));
+        }
+
+        ScanKernels::SetKernelLevel(ScanKernels::GetSupportedKernelLevel());
+        printf("\n");
+    }
+
+    void PrintUsage()
+    {
+        printf("Usage: burndbg_bench [--quick] [--iterations N]\n");
+        printf("  --quick          Run every case once, as a smoke test\n");
+        printf("  --iterations N   Report the best of N runs of each case (default %d)\n", kDefaultIterations);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int iterations = kDefaultIterations;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--quick") == 0)
+        {
+            iterations = 1;
+        }
+        else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+        {
+            iterations = atoi(argv[++i]);
+            if (iterations < 1)
+            {
+                PrintUsage();
+                return 2;
+            }
+        }
+        else
+        {
+            PrintUsage();
+            return 2;
+        }
+    }
+
+    printf("burndbg_bench: kernels up to %s, best of %d\n\n",
+        ScanKernels::GetKernelLevelName(ScanKernels::GetSupportedKernelLevel()), iterations);
+
+    MemScanSlot::ResetScanStats();
+
+    CheckKernelHits();
+    CheckM68KLayout();
+    BenchFirstScan(iterations);
+    BenchValuePredicates(iterations);
+    BenchDenseRefine(iterations);
+    BenchBcdScans(iterations);
+    BenchRefineByHitCount(iterations);
+    BenchPrintFormat(iterations);
+
+    const ScanStats Stats = MemScanSlot::GetScanStats();
+    printf("Filtering passes: %llu, %.1f MB in %.1f ms\n",
+        static_cast<unsigned long long>(Stats.NumPasses),
+        Stats.BytesScanned / (1024.0 * 1024.0),
+        Stats.Nanoseconds / 1e6);
+
+    if (s_numFailures)
+    {
+        fprintf(stderr, "%d case(s) failed\n", s_numFailures);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,1201 @@
+//----------------------------------------------------------------------------
+// Replays traces recorded with !bdtrace.
+//
+// Every command of the trace is run again through the same FBNeoSession the
+// extension uses, with target memory and symbols served from the trace, and
+// timed. The number of requests each command makes of the target is set
+// against what it made when the trace was recorded, so a change that turns
+// a bulk read into per-element reads shows up as soon as a trace is replayed.
+//
+// Output is counted too, along with the calls into the engine it would take
+// once the extension has coalesced it, so a listing that stops going out in
+// large chunks shows up the same way.
+//
+// --synthetic records a scripted session against a made-up FBNeo process
+// instead, which is enough to exercise recording and replay without one.
+// --dump and --pid run commands straight against a minidump of FBNeo or a
+// running native build, and --savestates against a directory of savestates.
+//----------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "buffermemorysource.h"
+#include "fbneosavestate.h"
+#include "fbneosession.h"
+#include "linuxprocessmemorysource.h"
+#include "m68kmemorymap.h"
+#include "m68kregion.h"
+#include "mappedfile.h"
+#include "memorytrace.h"
+#include "minidumpmemorysource.h"
+#include "symbolcache.h"
+#include "tracesources.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    constexpr int kDefaultIterations = 5;
+
+    //------------------------------------------------------------------------
+    // Command output
+    //------------------------------------------------------------------------
+
+    // The extension buffers output and hands it to the engine once this much has
+    // built up, as ExtExtension::s_OutBufferFlushChars
+    constexpr uint64_t kOutBufferFlushChars = 0x4000;
+
+    struct OutputCounters
+    {
+        uint64_t OutCalls = 0;
+        uint64_t ErrCalls = 0;
+        uint64_t Chars = 0;
+        // Calls the extension would make into the engine for the same output
+        uint64_t EngineCalls = 0;
+    };
+
+    // Formats everything, so replays pay for output like the extension does, then
+    // prints it or drops it. Counts it on the way through, with engine calls worked
+    // out the way the extension buffers: text goes out when the buffer fills, before
+    // each error, which goes out on its own, and when the command ends.
+    class ReplayOutput : public ICommandOutput
+    {
+    public:
+        explicit ReplayOutput(bool print)
+            : m_print(print)
+        {
+        }
+
+        void OutVa(const char* pFormat, va_list args) override
+        {
+            const uint64_t Length = Format(stdout, pFormat, args);
+            ++m_counters.OutCalls;
+            m_counters.Chars += Length;
+            m_bufferedChars += Length;
+            if (m_bufferedChars >= kOutBufferFlushChars)
+            {
+                Flush();
+            }
+        }
+
+        void ErrVa(const char* pFormat, va_list args) override
+        {
+            Format(stderr, pFormat, args);
+            Flush();
+            ++m_counters.ErrCalls;
+            ++m_counters.EngineCalls;
+        }
+
+        // The command is done, so whatever is still buffered goes out
+        void EndCommand()
+        {
+            Flush();
+        }
+
+        void ResetCounters()
+        {
+            m_counters = OutputCounters();
+            m_bufferedChars = 0;
+        }
+
+        const OutputCounters& GetCounters() const
+        {
+            return m_counters;
+        }
+
+    private:
+        uint64_t Format(FILE* pStream, const char* pFormat, va_list args)
+        {
+            char line[0x200];
+            const int Length = vsnprintf(line, sizeof(line), pFormat, args);
+            if (m_print)
+            {
+                // Keeps errors in order with the output before them when both go to the same place
+                if (pStream == stderr)
+                {
+                    fflush(stdout);
+                }
+                fputs(line, pStream);
+            }
+
+            return Length > 0 ? static_cast<uint64_t>(Length) : 0;
+        }
+
+        void Flush()
+        {
+            if (m_bufferedChars)
+            {
+                ++m_counters.EngineCalls;
+                m_bufferedChars = 0;
+            }
+        }
+
+        bool m_print;
+        OutputCounters m_counters;
+        uint64_t m_bufferedChars = 0;
+    };
+
+    //------------------------------------------------------------------------
+    // Command arguments
+    //
+    // Traces hold commands as typed, so arguments are parsed the way the
+    // engine would for the common cases: numbers default to hex for "e"
+    // arguments and to decimal for the "en=(10)" ones and memscan's -bcd
+    // values, 0x and 0n override that, and backticks are ignored. Anything fancier, like registers or
+    // symbols, can't be evaluated without the debugger.
+    //------------------------------------------------------------------------
+
+    struct CommandArgs
+    {
+        std::vector<std::string> Positional;
+        bool Unknown = false;
+        bool AnyAlignment = false;
+        bool Bcd = false;
+        bool HasPredicate = false;
+        std::string Predicate;
+    };
+
+    bool ParseCommandArgs(const std::string& raw, CommandArgs& argsOut)
+    {
+        std::vector<std::string> tokens;
+        size_t position = 0;
+        while (position < raw.size())
+        {
+            while (position < raw.size() && isspace(static_cast<unsigned char>(raw[position])))
+            {
+                ++position;
+            }
+
+            const size_t Start = position;
+            while (position < raw.size() && !isspace(static_cast<unsigned char>(raw[position])))
+            {
+                ++position;
+            }
+
+            if (position > Start)
+            {
+                tokens.push_back(raw.substr(Start, position - Start));
+            }
+        }
+
+        for (size_t i = 0; i < tokens.size(); ++i)
+        {
+            if (tokens[i] == "-u")
+            {
+                argsOut.Unknown = true;
+            }
+            else if (tokens[i] == "-odd")
+            {
+                argsOut.AnyAlignment = true;
+            }
+            else if (tokens[i] == "-bcd")
+            {
+                argsOut.Bcd = true;
+            }
+            else if (tokens[i] == "-op" && i + 1 < tokens.size())
+            {
+                argsOut.HasPredicate = true;
+                argsOut.Predicate = tokens[++i];
+            }
+            else if (tokens[i][0] == '-' && tokens[i].size() > 1 && !isdigit(static_cast<unsigned char>(tokens[i][1])))
+            {
+                return false;
+            }
+            else
+            {
+                argsOut.Positional.push_back(tokens[i]);
+            }
+        }
+
+        return true;
+    }
+
+    bool ParseNumber(const std::string& token, int defaultRadix, uint64_t* pValueOut)
+    {
+        std::string digits;
+        for (const char Char : token)
+        {
+            if (Char != '`')
+            {
+                digits += Char;
+            }
+        }
+
+        int radix = defaultRadix;
+        if (digits.size() > 2 && digits[0] == '0' && (digits[1] == 'x' || digits[1] == 'X'))
+        {
+            radix = 16;
+            digits.erase(0, 2);
+        }
+        else if (digits.size() > 2 && digits[0] == '0' && (digits[1] == 'n' || digits[1] == 'N'))
+        {
+            radix = 10;
+            digits.erase(0, 2);
+        }
+
+        if (digits.empty())
+        {
+            return false;
+        }
+
+        char* pEnd;
+        const unsigned long long Value = strtoull(digits.c_str(), &pEnd, radix);
+        if (*pEnd != '\0')
+        {
+            return false;
+        }
+
+        *pValueOut = Value;
+        return true;
+    }
+
+    // Runs one command of a trace. Returns false if its arguments can't be replayed.
+    bool RunCommand(FBNeoSession& session, const std::string& name, const std::string& rawArgs)
+    {
+        CommandArgs args;
+        if (!ParseCommandArgs(rawArgs, args))
+        {
+            return false;
+        }
+
+        const std::vector<std::string>& Positional = args.Positional;
+        uint64_t numbers[3] = {};
+        auto ParseAt = [&Positional, &numbers](size_t index, int radix)
+        {
+            return index < Positional.size() && ParseNumber(Positional[index], radix, &numbers[index]);
+        };
+
+        if (name == "membase")
+        {
+            session.MemBase();
+        }
+        else if (name == "readb" || name == "readw" || name == "readl")
+        {
+            if (!ParseAt(0, 16))
+            {
+                return false;
+            }
+            session.ReadValue(numbers[0], name == "readb" ? 1 : name == "readw" ? 2 : 4);
+        }
+        else if (name == "readrange")
+        {
+            if (!ParseAt(0, 16) || !ParseAt(1, 16))
+            {
+                return false;
+            }
+            session.DumpRange(numbers[0], numbers[1]);
+        }
+        else if (name == "memscan")
+        {
+            if (Positional.size() < 2 || !ParseAt(1, 16))
+            {
+                return false;
+            }
+
+            MemScanArgs scanArgs;
+            scanArgs.pSlot = Positional[0].c_str();
+            scanArgs.ValueSize = numbers[1];
+            scanArgs.UnknownScan = args.Unknown;
+            scanArgs.AnyAlignment = args.AnyAlignment;
+            scanArgs.Bcd = args.Bcd;
+            scanArgs.pPredicate = args.HasPredicate ? args.Predicate.c_str() : nullptr;
+            for (size_t i = 2; i < Positional.size(); ++i)
+            {
+                uint64_t value;
+                if (!ParseNumber(Positional[i], args.Bcd ? 10 : 16, &value))
+                {
+                    return false;
+                }
+                scanArgs.Values.push_back(value);
+            }
+            session.MemScan(scanArgs);
+        }
+        else if (name == "slotclear")
+        {
+            if (Positional.empty())
+            {
+                return false;
+            }
+            session.SlotClear(Positional[0].c_str());
+        }
+        else if (name == "slotinfo")
+        {
+            if (Positional.empty() ||
+                (Positional.size() > 1 && !ParseAt(1, 10)) ||
+                (Positional.size() > 2 && !ParseAt(2, 10)))
+            {
+                return false;
+            }
+            session.SlotInfo(Positional[0].c_str(), Positional.size() > 1, numbers[1], Positional.size() > 2, numbers[2]);
+        }
+        else if (name == "slotls")
+        {
+            session.SlotLs();
+        }
+        else
+        {
+            return false;
+        }
+
+        return true;
+    }
+
+    //------------------------------------------------------------------------
+    // Replay
+    //------------------------------------------------------------------------
+
+    // One command of the trace, with what it took when recorded and when replayed
+    struct CommandReplay
+    {
+        size_t EventIndex;
+        uint64_t RecordedRequests = 0;
+        uint64_t RecordedBytes = 0;
+        ReplayCounters Replayed = {};
+        OutputCounters Output = {};
+        double BestSeconds = 0;
+        bool Replayable = true;
+    };
+
+    std::vector<CommandReplay> FindCommands(const MemoryTrace& trace)
+    {
+        std::vector<CommandReplay> commands;
+        for (size_t i = 0; i < trace.GetEvents().size(); ++i)
+        {
+            const TraceEvent& Event = trace.GetEvents()[i];
+            if (Event.Kind == TraceEventKind::Command)
+            {
+                commands.push_back({ i });
+            }
+            else if (!commands.empty() && Event.Kind == TraceEventKind::ScatterBatch)
+            {
+                ++commands.back().RecordedRequests;
+            }
+            else if (!commands.empty() && Event.Kind == TraceEventKind::Read)
+            {
+                commands.back().RecordedRequests += Event.InBatch ? 0 : 1;
+                commands.back().RecordedBytes += Event.Size;
+            }
+        }
+
+        return commands;
+    }
+
+    void ReplayOnce(const MemoryTrace& trace, std::vector<CommandReplay>& commands, bool printOutput, bool firstPass)
+    {
+        ReplayMemorySource memory(trace);
+        ReplaySymbolProvider symbols(trace);
+        ReplayOutput output(printOutput);
+        FBNeoSession session(memory, symbols, output);
+        session.SetPointerSize(trace.GetPointerSize());
+
+        const std::vector<TraceEvent>& Events = trace.GetEvents();
+        size_t nextCommand = 0;
+        for (size_t i = 0; i < Events.size(); ++i)
+        {
+            if (Events[i].Kind == TraceEventKind::TargetRan)
+            {
+                session.RequestRevalidation();
+                continue;
+            }
+            if (Events[i].Kind != TraceEventKind::Command)
+            {
+                continue;
+            }
+
+            CommandReplay& command = commands[nextCommand++];
+            if (!command.Replayable)
+            {
+                continue;
+            }
+
+            memory.SeekToEvent(i);
+            symbols.SeekToEvent(i);
+            memory.ResetCounters();
+            output.ResetCounters();
+            if (printOutput)
+            {
+                printf("> !%s %s\n", Events[i].Name.c_str(), Events[i].Args.c_str());
+            }
+
+            const Clock::time_point Start = Clock::now();
+            command.Replayable = RunCommand(session, Events[i].Name, Events[i].Args);
+            output.EndCommand();
+            const double Seconds = std::chrono::duration<double>(Clock::now() - Start).count();
+
+            command.Replayed = memory.GetCounters();
+            command.Output = output.GetCounters();
+            command.BestSeconds = firstPass ? Seconds : std::min(command.BestSeconds, Seconds);
+        }
+    }
+
+    // Engine calls a command's output should take at most once coalesced: one per buffer
+    // full, one for what's left at the end and one for each error
+    uint64_t GetMaxEngineCalls(const OutputCounters& output)
+    {
+        return output.Chars / kOutBufferFlushChars + 1 + output.ErrCalls;
+    }
+
+    // Returns the number of commands that made more requests than recorded, read memory
+    // the trace doesn't have or split their output into more engine calls than it needs
+    int PrintReport(const MemoryTrace& trace, const std::vector<CommandReplay>& commands)
+    {
+        printf("%4s  %-10s %-24s %9s %9s %9s %7s %7s %7s %11s\n", "#", "Command", "Arguments", "Recorded", "Replayed", "KB",
+            "Out", "Engine", "Out KB", "Best (us)");
+
+        int numRegressions = 0;
+        double totalSeconds = 0;
+        uint64_t totalRecorded = 0;
+        uint64_t totalReplayed = 0;
+        uint64_t totalOutCalls = 0;
+        uint64_t totalEngineCalls = 0;
+        for (size_t i = 0; i < commands.size(); ++i)
+        {
+            const CommandReplay& Command = commands[i];
+            const TraceEvent& Event = trace.GetEvents()[Command.EventIndex];
+            const std::string Args = Event.Args.substr(0, 24);
+
+            if (!Command.Replayable)
+            {
+                printf("%4zu  %-10s %-24s  can't be replayed\n", i, Event.Name.c_str(), Args.c_str());
+                continue;
+            }
+
+            const uint64_t Replayed = Command.Replayed.Reads + Command.Replayed.ScatterBatches;
+            const char* pNote = "";
+            if (Command.Replayed.MissingReads)
+            {
+                pNote = "  reads untraced memory";
+                ++numRegressions;
+            }
+            else if (Replayed > Command.RecordedRequests)
+            {
+                pNote = "  more requests";
+                ++numRegressions;
+            }
+            else if (Command.Output.EngineCalls > GetMaxEngineCalls(Command.Output))
+            {
+                pNote = "  output not coalesced";
+                ++numRegressions;
+            }
+
+            printf("%4zu  %-10s %-24s %9llu %9llu %9llu %7llu %7llu %7llu %11.1f%s\n", i, Event.Name.c_str(), Args.c_str(),
+                static_cast<unsigned long long>(Command.RecordedRequests),
+                static_cast<unsigned long long>(Replayed),
+                static_cast<unsigned long long>((Command.Replayed.ReadBytes + 1023) / 1024),
+                static_cast<unsigned long long>(Command.Output.OutCalls + Command.Output.ErrCalls),
+                static_cast<unsigned long long>(Command.Output.EngineCalls),
+                static_cast<unsigned long long>((Command.Output.Chars + 1023) / 1024),
+                Command.BestSeconds * 1e6, pNote);
+
+            totalSeconds += Command.BestSeconds;
+            totalRecorded += Command.RecordedRequests;
+            totalReplayed += Replayed;
+            totalOutCalls += Command.Output.OutCalls + Command.Output.ErrCalls;
+            totalEngineCalls += Command.Output.EngineCalls;
+        }
+
+        printf("%4s  %-10s %-24s %9llu %9llu %9s %7llu %7llu %7s %11.1f\n", "", "Total", "",
+            static_cast<unsigned long long>(totalRecorded), static_cast<unsigned long long>(totalReplayed), "",
+            static_cast<unsigned long long>(totalOutCalls), static_cast<unsigned long long>(totalEngineCalls), "",
+            totalSeconds * 1e6);
+        return numRegressions;
+    }
+
+    //------------------------------------------------------------------------
+    // Synthetic target
+    //
+    // Just enough of an FBNeo process for the commands: the two pointers they
+    // resolve through symbols, pSekExt->MemMap mapping 128KB of work RAM at
+    // $100000 plus a handler page, and the RAM itself, kept in host order.
+    //------------------------------------------------------------------------
+
+    constexpr uint64_t kSyntheticModuleBase = 0x140000000;
+    constexpr uint64_t kSyntheticPointers = 0x140100000;
+    constexpr uint64_t kSyntheticSekExt = 0x150000000;
+    constexpr uint32_t kSyntheticMemMapOffset = 0x10;
+    constexpr uint64_t kSyntheticRam = 0x160000000;
+    constexpr uint32_t kSyntheticHandlerPage = 0x300000;
+
+    class SyntheticSymbolProvider : public ISymbolProvider
+    {
+    public:
+        bool GetModuleBase(const char* pModule, uint64_t* pBaseOut) override
+        {
+            if (strcmp(pModule, kFBNeoModule) != 0)
+            {
+                return false;
+            }
+
+            *pBaseOut = kSyntheticModuleBase;
+            return true;
+        }
+
+        bool GetSymbolAddress(const char* pSymbol, uint64_t* pAddressOut) override
+        {
+            if (strcmp(pSymbol, kNeo68KRAMSymbol) == 0)
+            {
+                *pAddressOut = kSyntheticPointers;
+                return true;
+            }
+            if (strcmp(pSymbol, kSekExtSymbol) == 0)
+            {
+                *pAddressOut = kSyntheticPointers + 8;
+                return true;
+            }
+
+            return false;
+        }
+
+        bool GetFieldOffset(const char* pModule, const char* pType, const char* pField, uint32_t* pOffsetOut) override
+        {
+            if (strcmp(pModule, kFBNeoModule) != 0 || strcmp(pType, "SekExt") != 0 || strcmp(pField, "MemMap") != 0)
+            {
+                return false;
+            }
+
+            *pOffsetOut = kSyntheticMemMapOffset;
+            return true;
+        }
+    };
+
+    class SyntheticTarget
+    {
+    public:
+        SyntheticTarget()
+        {
+            uint8_t* pPointers = m_memory.AddRegion(kSyntheticPointers, 16);
+            const uint64_t Pointers[2] = { kSyntheticRam, kSyntheticSekExt };
+            memcpy(pPointers, Pointers, sizeof(Pointers));
+
+            const uint32_t MemMapSize = static_cast<uint32_t>(M68KMemoryMap::kNumEntries * sizeof(uint64_t));
+            uint8_t* pSekExt = m_memory.AddRegion(kSyntheticSekExt, kSyntheticMemMapOffset + MemMapSize);
+            for (uint32_t access = 0; access < 3; ++access)
+            {
+                for (uint32_t address = kNeoGeoWorkRam.M68KBase; address < kNeoGeoWorkRam.M68KBase + kNeoGeoWorkRam.Size; address += SEK_PAGE_SIZE)
+                {
+                    SetPageEntry(pSekExt, access, address, kSyntheticRam + (address - kNeoGeoWorkRam.M68KBase));
+                }
+                SetPageEntry(pSekExt, access, kSyntheticHandlerPage, 3);
+            }
+
+            m_pRam = m_memory.AddRegion(kSyntheticRam, kNeoGeoWorkRam.Size);
+        }
+
+        IMemorySource& GetMemory()
+        {
+            return m_memory;
+        }
+
+        ISymbolProvider& GetSymbols()
+        {
+            return m_symbols;
+        }
+
+        // Values are stored the way FBNeo keeps them: words in host order, bytes in the other half of their word
+        void SetByte(uint32_t address, uint8_t value)
+        {
+            m_pRam[(address ^ 1) - kNeoGeoWorkRam.M68KBase] = value;
+        }
+
+        void SetWord(uint32_t address, uint16_t value)
+        {
+            memcpy(m_pRam + (address - kNeoGeoWorkRam.M68KBase), &value, sizeof(value));
+        }
+
+    private:
+        static void SetPageEntry(uint8_t* pSekExt, uint32_t access, uint32_t address, uint64_t entry)
+        {
+            const size_t Index = access * SEK_WADD + (address >> SEK_SHIFT);
+            memcpy(pSekExt + kSyntheticMemMapOffset + Index * sizeof(uint64_t), &entry, sizeof(entry));
+        }
+
+        BufferMemorySource m_memory;
+        SyntheticSymbolProvider m_symbols;
+        uint8_t* m_pRam = nullptr;
+    };
+
+    // Hunts for a lives counter, a countdown timer and a BCD high score the way one would in the debugger
+    bool RecordSyntheticSession(const char* pPath)
+    {
+        SyntheticTarget target;
+        TraceWriter writer;
+        if (!writer.Open(pPath, sizeof(uint64_t)))
+        {
+            fprintf(stderr, "Unable to create %s\n", pPath);
+            return false;
+        }
+
+        RecordingMemorySource memory(target.GetMemory());
+        RecordingSymbolProvider symbols(target.GetSymbols());
+        memory.SetWriter(&writer);
+        symbols.SetWriter(&writer);
+
+        ReplayOutput output(false);
+        FBNeoSession session(memory, symbols, output);
+        session.SetPointerSize(sizeof(uint64_t));
+
+        const uint32_t LivesAddress = 0x10FD83;
+        const uint32_t TimerAddress = 0x100400;
+        uint16_t timer = 0x99;
+        bool allRan = true;
+        auto Command = [&](const char* pName, const char* pArgs)
+        {
+            writer.WriteCommand(pName, pArgs);
+            allRan &= RunCommand(session, pName, pArgs);
+        };
+        auto RunGame = [&](uint8_t lives)
+        {
+            target.SetByte(LivesAddress, lives);
+            target.SetWord(TimerAddress, --timer);
+            writer.WriteTargetRan();
+            session.RequestRevalidation();
+        };
+
+        target.SetByte(LivesAddress, 3);
+        target.SetWord(TimerAddress, timer);
+        target.SetWord(0x100200, 0x1234);
+        const uint8_t Score[] = { 0x12, 0x34, 0x56, 0x78 };
+        for (uint32_t i = 0; i < sizeof(Score); ++i)
+        {
+            target.SetByte(0x100501 + i, Score[i]);
+        }
+        const uint8_t HiScore[] = { 0x00, 0x12, 0x00 };
+        for (uint32_t i = 0; i < sizeof(HiScore); ++i)
+        {
+            target.SetByte(0x100600 + i, HiScore[i]);
+        }
+
+        Command("membase", "");
+        Command("readb", "10fd83");
+        Command("readw", "0x100200");
+        Command("readl", "300000");
+        Command("memscan", "-op any lives 1 3 5 9");
+        RunGame(2);
+        Command("memscan", "-op dec lives 1");
+        Command("memscan", "-op range lives 1 1 4");
+        Command("slotinfo", "lives");
+        Command("memscan", "-u timer 2");
+        Command("memscan", "-bcd -u clock 1");
+        RunGame(2);
+        Command("memscan", "-op dec timer 2");
+        Command("memscan", "-bcd -op dec clock 1");
+        RunGame(2);
+        Command("memscan", "-op decby timer 2 1");
+        Command("memscan", "-bcd -op decby clock 1 1");
+        Command("memscan", "-bcd hiscore 3 1200");
+        Command("memscan", "-op mask timer 2 0f 6");
+        Command("memscan", "-odd score 4 12345678");
+        Command("slotinfo", "score");
+        Command("slotinfo", "timer 0 0n10");
+        Command("memscan", "-u ram 1");
+        Command("slotinfo", "ram 0 0n1000");
+        Command("slotls", "");
+        Command("readrange", "10fd70 20");
+        Command("slotclear", "lives");
+
+        memory.SetWriter(nullptr);
+        symbols.SetWriter(nullptr);
+        if (!writer.Close())
+        {
+            fprintf(stderr, "Failed to write %s\n", pPath);
+            return false;
+        }
+        if (!allRan)
+        {
+            fprintf(stderr, "The scripted session has commands that can't be parsed\n");
+            return false;
+        }
+
+        return true;
+    }
+
+    //------------------------------------------------------------------------
+    // Other targets
+    //
+    // Commands can also run straight against FBNeo's memory from elsewhere,
+    // with no debugger to resolve symbols. The few the commands need are given
+    // on the command line instead, as the debugger shows them: the addresses
+    // of Neo68KRAM and pSekExt from "x", and SekExt.MemMap's offset from "dt".
+    // memscan and slotinfo only need Neo68KRAM.
+    //------------------------------------------------------------------------
+
+    class CommandLineSymbolProvider : public ISymbolProvider
+    {
+    public:
+        // Takes "symbol=address" or "type.field=offset", in hex unless prefixed with 0n.
+        // Names without a module are FBNeo's.
+        bool Add(const char* pDefinition)
+        {
+            const char* pEquals = strchr(pDefinition, '=');
+            uint64_t value;
+            if (!pEquals || pEquals == pDefinition || !ParseNumber(pEquals + 1, 16, &value))
+            {
+                return false;
+            }
+
+            std::string name(pDefinition, pEquals);
+            if (name.find('!') == std::string::npos)
+            {
+                name = std::string(kFBNeoModule) + "!" + name;
+            }
+
+            if (name.find('.') != std::string::npos)
+            {
+                m_fieldOffsets[name] = static_cast<uint32_t>(value);
+            }
+            else
+            {
+                SetSymbol(name, value);
+            }
+            return true;
+        }
+
+        void SetSymbol(const std::string& symbol, uint64_t address)
+        {
+            m_symbols[symbol] = address;
+        }
+
+        // Nothing given on the command line moves, so every module stays where it is
+        bool GetModuleBase(const char* pModule, uint64_t* pBaseOut) override
+        {
+            (void)pModule;
+            *pBaseOut = 0;
+            return true;
+        }
+
+        bool GetSymbolAddress(const char* pSymbol, uint64_t* pAddressOut) override
+        {
+            const auto It = m_symbols.find(pSymbol);
+            if (It == m_symbols.end())
+            {
+                return false;
+            }
+
+            *pAddressOut = It->second;
+            return true;
+        }
+
+        bool GetFieldOffset(const char* pModule, const char* pType, const char* pField, uint32_t* pOffsetOut) override
+        {
+            const auto It = m_fieldOffsets.find(std::string(pModule) + "!" + pType + "." + pField);
+            if (It == m_fieldOffsets.end())
+            {
+                return false;
+            }
+
+            *pOffsetOut = It->second;
+            return true;
+        }
+
+    private:
+        std::unordered_map<std::string, uint64_t> m_symbols;
+
+        // Keyed by "module!type.field"
+        std::unordered_map<std::string, uint32_t> m_fieldOffsets;
+    };
+
+    // Commands as typed in the debugger, with or without the "!", from the command line,
+    // or one per line from stdin if there are none there
+    std::vector<std::string> GetTargetCommands(const std::vector<std::string>& commands)
+    {
+        if (!commands.empty())
+        {
+            return commands;
+        }
+
+        std::vector<std::string> lines;
+        std::string line;
+        while (std::getline(std::cin, line))
+        {
+            lines.push_back(line);
+        }
+        return lines;
+    }
+
+    // Returns false if the command couldn't be run. Blank lines are skipped.
+    bool RunTargetCommand(FBNeoSession& session, ReplayOutput& output, const std::string& line)
+    {
+        const size_t Start = line.find_first_not_of(" \t!");
+        if (Start == std::string::npos)
+        {
+            return true;
+        }
+
+        const size_t NameEnd = std::min(line.find_first_of(" \t", Start), line.size());
+        const std::string Name = line.substr(Start, NameEnd - Start);
+        const std::string Args = line.substr(NameEnd);
+
+        printf("> !%s%s\n", Name.c_str(), Args.c_str());
+        const bool Succeeded = RunCommand(session, Name, Args);
+        if (!Succeeded)
+        {
+            fprintf(stderr, "Can't run !%s%s\n", Name.c_str(), Args.c_str());
+        }
+        output.EndCommand();
+        return Succeeded;
+    }
+
+    // Runs commands against memory. A live target may have run in between, so the session
+    // rereads what it needs before each one. Returns the number of commands that couldn't
+    // be run.
+    int RunTargetCommands(IMemorySource& memory, ISymbolProvider& symbols, uint32_t pointerSize, bool live,
+        const std::vector<std::string>& commands)
+    {
+        ReplayOutput output(true);
+        FBNeoSession session(memory, symbols, output);
+        session.SetPointerSize(pointerSize);
+
+        int numFailed = 0;
+        for (const std::string& Command : GetTargetCommands(commands))
+        {
+            if (live)
+            {
+                session.RequestRevalidation();
+            }
+            if (!RunTargetCommand(session, output, Command))
+            {
+                ++numFailed;
+            }
+        }
+
+        return numFailed;
+    }
+
+#if defined(BURNDBG_SAVESTATES)
+    //------------------------------------------------------------------------
+    // Savestates
+    //
+    // A directory of savestates is scanned the way a game would be by
+    // breaking in at each of them in turn: one session over all of them,
+    // with its memory switched from one state's RAM to the next in between
+    // commands, so slots carry over and each memscan refines the last.
+    //
+    // A state holds no pointers, so each one also gets a made-up Neo68KRAM
+    // pointing at its RAM. The read commands need more than that and can't
+    // be run against states.
+    //------------------------------------------------------------------------
+
+    constexpr uint64_t kSavestateRamAddress = 0x10000000;
+    constexpr uint64_t kSavestateRamPointerAddress = 0x0FFFF000;
+
+    // Forwards to whichever state is current
+    class SavestateMemorySource : public IMemorySource
+    {
+    public:
+        void SetState(IMemorySource* pState)
+        {
+            m_pState = pState;
+        }
+
+        bool Read(uint64_t address, void* pBuffer, uint32_t size) override
+        {
+            return m_pState->Read(address, pBuffer, size);
+        }
+
+        bool ReadScatter(ScatterReadEntry* pEntries, size_t numEntries) override
+        {
+            return m_pState->ReadScatter(pEntries, numEntries);
+        }
+
+        void EnumerateRegions(std::vector<MemoryRegionInfo>& regionsOut) override
+        {
+            m_pState->EnumerateRegions(regionsOut);
+        }
+
+        const uint8_t* GetDirectPointer(uint64_t address, uint32_t size) override
+        {
+            return m_pState->GetDirectPointer(address, size);
+        }
+
+    private:
+        IMemorySource* m_pState = nullptr;
+    };
+
+    // Prints where the RAM dumped to pRamPath sits in the state at pStatePath
+    int FindRamOffset(const char* pStatePath, const char* pRamPath)
+    {
+        MappedFile ramFile;
+        if (!ramFile.Open(pRamPath))
+        {
+            fprintf(stderr, "Unable to open %s\n", pRamPath);
+            return 1;
+        }
+
+        const std::vector<uint8_t> Ram(ramFile.GetData(), ramFile.GetData() + ramFile.GetSize());
+        uint64_t offset;
+        if (!FindSavestateRamOffset(pStatePath, Ram, &offset))
+        {
+            fprintf(stderr, "%s isn't in %s exactly once\n", pRamPath, pStatePath);
+            return 1;
+        }
+
+        printf("--ram-offset %llx\n", static_cast<unsigned long long>(offset));
+        return 0;
+    }
+
+    // Runs the n-th command against the n-th state, in name order. The last command is
+    // repeated for any states left over, and any commands left over run against the
+    // last state. Returns the number of commands that couldn't be run.
+    int RunSavestateCommands(const char* pDirectory, uint64_t ramOffset, uint32_t pointerSize,
+        CommandLineSymbolProvider& symbols, const std::vector<std::string>& commands)
+    {
+        std::vector<std::string> paths;
+        if (!ListSavestates(pDirectory, paths) || paths.empty())
+        {
+            fprintf(stderr, "No savestates in %s\n", pDirectory);
+            return 1;
+        }
+
+        const SavestateLayout Layout = { ramOffset, kNeoGeoWorkRam.Size, kSavestateRamAddress };
+        std::vector<LoadedSavestate> states;
+        LoadSavestates(paths, Layout, 0, states);
+
+        for (LoadedSavestate& state : states)
+        {
+            if (state.Loaded)
+            {
+                uint8_t* pPointer = state.Memory.AddRegion(kSavestateRamPointerAddress, pointerSize);
+                memcpy(pPointer, &kSavestateRamAddress, pointerSize);
+            }
+        }
+        symbols.SetSymbol(kNeo68KRAMSymbol, kSavestateRamPointerAddress);
+
+        SavestateMemorySource memory;
+        ReplayOutput output(true);
+        FBNeoSession session(memory, symbols, output);
+        session.SetPointerSize(pointerSize);
+
+        const std::vector<std::string> Commands = GetTargetCommands(commands);
+        int numFailed = 0;
+        size_t commandIndex = 0;
+        for (size_t i = 0; i < states.size(); ++i)
+        {
+            printf("%s\n", states[i].Path.c_str());
+            if (!states[i].Loaded)
+            {
+                fprintf(stderr, "Unable to load the RAM from %s, skipping it\n", states[i].Path.c_str());
+                continue;
+            }
+
+            memory.SetState(&states[i].Memory);
+            session.RequestRevalidation();
+
+            const bool LastState = i + 1 == states.size();
+            do
+            {
+                const size_t Index = std::min(commandIndex++, Commands.size() - 1);
+                if (!Commands.empty() && !RunTargetCommand(session, output, Commands[Index]))
+                {
+                    ++numFailed;
+                }
+            } while (LastState && commandIndex < Commands.size());
+        }
+
+        return numFailed;
+    }
+#endif
+
+    void PrintUsage()
+    {
+        printf("Usage: burndbg_replay [options] <trace>\n");
+        printf("       burndbg_replay --dump <minidump> --symbol <name>=<value>... [<command>...]\n");
+#if defined(__linux__)
+        printf("       burndbg_replay --pid <pid> --symbol <name>=<value>... [<command>...]\n");
+#endif
+#if defined(BURNDBG_SAVESTATES)
+        printf("       burndbg_replay --savestates <dir> --ram-offset <offset> [<command>...]\n");
+        printf("       burndbg_replay --find-ram-offset <ram> <savestate>\n");
+#endif
+        printf("  --iterations N   Report the best of N replays of each command (default %d)\n", kDefaultIterations);
+        printf("  --print          Print the output of the commands while replaying\n");
+        printf("  --check          Fail if any command makes more requests than recorded\n");
+        printf("  --synthetic      Record a scripted session against a synthetic target to <trace> instead\n");
+        printf("  --dump           Run commands against the minidump instead, from stdin if none are given\n");
+#if defined(__linux__)
+        printf("  --pid N          Run commands against a running FBNeo process instead\n");
+#endif
+        printf("  --symbol S=V     Address of a symbol, e.g. Neo68KRAM=7ff6a1b2c3d0, or offset of a field,\n");
+        printf("                   e.g. SekExt.MemMap=10, for commands run against a dump or process\n");
+        printf("  --pointer-size N Pointer size of the dumped or running process (default 8)\n");
+#if defined(BURNDBG_SAVESTATES)
+        printf("  --savestates     Run commands against each .fs file in <dir> in turn instead, the n-th\n");
+        printf("                   command against the n-th state and the last against any after it\n");
+        printf("  --ram-offset N   Offset of 68K RAM in the game's savestates, as --find-ram-offset prints\n");
+        printf("  --find-ram-offset F  Print where the RAM dumped to F sits in <savestate>\n");
+#endif
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int iterations = kDefaultIterations;
+    bool printOutput = false;
+    bool check = false;
+    bool synthetic = false;
+    bool dump = false;
+    int pid = 0;
+    bool savestates = false;
+#if defined(BURNDBG_SAVESTATES)
+    uint64_t ramOffset = 0;
+    const char* pRamPath = nullptr;
+#endif
+    uint32_t pointerSize = sizeof(uint64_t);
+    CommandLineSymbolProvider symbols;
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+        {
+            iterations = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--print") == 0)
+        {
+            printOutput = true;
+        }
+        else if (strcmp(argv[i], "--check") == 0)
+        {
+            check = true;
+        }
+        else if (strcmp(argv[i], "--synthetic") == 0)
+        {
+            synthetic = true;
+        }
+        else if (strcmp(argv[i], "--dump") == 0)
+        {
+            dump = true;
+        }
+#if defined(__linux__)
+        else if (strcmp(argv[i], "--pid") == 0 && i + 1 < argc)
+        {
+            pid = atoi(argv[++i]);
+        }
+#endif
+        else if (strcmp(argv[i], "--symbol") == 0 && i + 1 < argc && symbols.Add(argv[i + 1]))
+        {
+            ++i;
+        }
+        else if (strcmp(argv[i], "--pointer-size") == 0 && i + 1 < argc)
+        {
+            pointerSize = static_cast<uint32_t>(atoi(argv[++i]));
+        }
+#if defined(BURNDBG_SAVESTATES)
+        else if (strcmp(argv[i], "--savestates") == 0)
+        {
+            savestates = true;
+        }
+        else if (strcmp(argv[i], "--ram-offset") == 0 && i + 1 < argc && ParseNumber(argv[i + 1], 16, &ramOffset))
+        {
+            ++i;
+        }
+        else if (strcmp(argv[i], "--find-ram-offset") == 0 && i + 1 < argc)
+        {
+            pRamPath = argv[++i];
+        }
+#endif
+        else if (argv[i][0] != '-')
+        {
+            positional.push_back(argv[i]);
+        }
+        else
+        {
+            PrintUsage();
+            return 2;
+        }
+    }
+
+    if (iterations < 1 || (pointerSize != 4 && pointerSize != 8))
+    {
+        PrintUsage();
+        return 2;
+    }
+
+#if defined(__linux__)
+    // Everything on the command line is a command to run against the process
+    if (pid)
+    {
+        LinuxProcessMemorySource memory;
+        if (!memory.Attach(pid))
+        {
+            fprintf(stderr, "Unable to attach to process %d\n", pid);
+            return 1;
+        }
+
+        return RunTargetCommands(memory, symbols, pointerSize, true, positional) ? 1 : 0;
+    }
+#endif
+
+    // Otherwise the first is the file to work on, and only dumps and states take commands
+    // after it
+    if (positional.empty() || (!dump && !savestates && positional.size() > 1))
+    {
+        PrintUsage();
+        return 2;
+    }
+
+    const char* pPath = positional.front().c_str();
+    const std::vector<std::string> TargetCommands(positional.begin() + 1, positional.end());
+#if defined(BURNDBG_SAVESTATES)
+    if (pRamPath)
+    {
+        return FindRamOffset(pPath, pRamPath);
+    }
+
+    if (savestates)
+    {
+        return RunSavestateCommands(pPath, ramOffset, pointerSize, symbols, TargetCommands) ? 1 : 0;
+    }
+#endif
+
+    if (dump)
+    {
+        MinidumpMemorySource memory;
+        if (!memory.Open(pPath))
+        {
+            fprintf(stderr, "Unable to open minidump %s\n", pPath);
+            return 1;
+        }
+
+        return RunTargetCommands(memory, symbols, pointerSize, false, TargetCommands) ? 1 : 0;
+    }
+
+    if (synthetic)
+    {
+        return RecordSyntheticSession(pPath) ? 0 : 1;
+    }
+
+    MemoryTrace trace;
+    if (!trace.Load(pPath))
+    {
+        fprintf(stderr, "Unable to load trace %s\n", pPath);
+        return 1;
+    }
+
+    std::vector<CommandReplay> commands = FindCommands(trace);
+    for (int i = 0; i < iterations; ++i)
+    {
+        // Only the first pass prints, the others are just for timing
+        ReplayOnce(trace, commands, printOutput && i == 0, i == 0);
+    }
+
+    printf("%s: %zu commands, best of %d\n\n", pPath, commands.size(), iterations);
+    const int NumRegressions = PrintReport(trace, commands);
+    if (check && NumRegressions)
+    {
+        fprintf(stderr, "%d command(s) regressed\n", NumRegressions);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+
+//----------------------------------------------------------------------------
+// Packed BCD, two decimal digits to a byte with the most significant byte
+// first, the way NeoGeo games keep scores, timers and credits.
+//
+// Scans compare BCD values as the decimal numbers they hold. Decoding goes a
+// byte at a time through a table built at compile time, which also tells
+// bytes holding a digit above 9 apart, so no digit is ever taken apart with
+// shifts and divides in a scan's inner loop.
+//----------------------------------------------------------------------------
+
+// Widest BCD value a scan handles, in bytes
+constexpr uint8_t kMaxBcdSize = 4;
+
+// What a BCD value with a digit above 9 decodes to. Larger than any valid value,
+// so it falls outside every range of valid values.
+constexpr uint32_t kInvalidBcd = 0xFFFFFFFF;
+
+namespace BcdTables
+{
+    constexpr uint8_t kInvalidByte = 0xFF;
+
+    // Decimal value of each byte read as two BCD digits, or kInvalidByte
+    struct ByteValues
+    {
+        uint8_t Values[256];
+
+        constexpr ByteValues()
+            : Values()
+        {
+            for (uint32_t i = 0; i < 256; ++i)
+            {
+                Values[i] = (i >> 4) < 10 && (i & 0xF) < 10 ? static_cast<uint8_t>((i >> 4) * 10 + (i & 0xF)) : kInvalidByte;
+            }
+        }
+    };
+
+    constexpr ByteValues kByteValues;
+
+    // 100 to the power of the index
+    constexpr uint32_t kPowersOf100[kMaxBcdSize + 1] = { 1, 100, 10000, 1000000, 100000000 };
+}
+
+// Largest value size bytes of BCD hold
+constexpr uint32_t GetMaxBcdValue(uint8_t size)
+{
+    return BcdTables::kPowersOf100[size] - 1;
+}
+
+// Encodes value, which must fit in the BCD of the scan, as a big-endian integer,
+// so 1234 comes out as 0x1234
+inline uint32_t EncodeBcd(uint32_t value)
+{
+    uint32_t encoded = 0;
+    for (uint32_t shift = 0; value != 0; shift += 4, value /= 10)
+    {
+        encoded |= (value % 10) << shift;
+    }
+
+    return encoded;
+}
+
+// Decodes the size bytes of BCD at 68K offset offset of a region's host copy, where
+// the byte at 68K offset N lives at host offset N ^ 1. Returns kInvalidBcd if any
+// byte isn't valid BCD.
+inline uint32_t ReadM68KBcd(const uint8_t* pHost, uint32_t offset, uint8_t size)
+{
+    uint32_t value = 0;
+    bool valid = true;
+    for (uint32_t i = 0; i < size; ++i)
+    {
+        const uint8_t Byte = BcdTables::kByteValues.Values[pHost[(offset + i) ^ 1]];
+        valid &= Byte != BcdTables::kInvalidByte;
+        value = value * 100 + Byte;
+    }
+
+    return valid ? value : kInvalidBcd;
+}
+
+// Decodes the size bytes of BCD in encoded, a big-endian integer. Returns kInvalidBcd if
+// any byte isn't valid BCD.
+inline uint32_t DecodeBcd(uint32_t encoded, uint8_t size)
+{
+    uint32_t value = 0;
+    bool valid = true;
+    for (int i = size - 1; i >= 0; --i)
+    {
+        const uint8_t Byte = BcdTables::kByteValues.Values[(encoded >> (i * 8)) & 0xFF];
+        valid &= Byte != BcdTables::kInvalidByte;
+        value = value * 100 + Byte;
+    }
+
+    return valid ? value : kInvalidBcd;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+//----------------------------------------------------------------------------
+// Small portable wrappers around the bit-scan and population count
+// intrinsics. Callers must not pass zero to the trailing zero counts.
+//----------------------------------------------------------------------------
+
+inline uint32_t CountTrailingZeros32(uint32_t value)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, value);
+    return static_cast<uint32_t>(index);
+#else
+    return static_cast<uint32_t>(__builtin_ctz(value));
+#endif
+}
+
+inline uint32_t CountTrailingZeros64(uint64_t value)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return static_cast<uint32_t>(index);
+#elif defined(_MSC_VER)
+    const uint32_t Low = static_cast<uint32_t>(value);
+    return Low ? CountTrailingZeros32(Low) : 32 + CountTrailingZeros32(static_cast<uint32_t>(value >> 32));
+#else
+    return static_cast<uint32_t>(__builtin_ctzll(value));
+#endif
+}
+
+inline uint32_t PopCount64(uint64_t value)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+    return static_cast<uint32_t>(__popcnt64(value));
+#elif defined(_MSC_VER)
+    return __popcnt(static_cast<uint32_t>(value)) + __popcnt(static_cast<uint32_t>(value >> 32));
+#else
+    return static_cast<uint32_t>(__builtin_popcountll(value));
+#endif
+}
@@ -0,0 +1,75 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "buffermemorysource.h"
+
+uint8_t* BufferMemorySource::AddRegion(uint64_t address, uint32_t size)
+{
+    return AddRegion(address, std::vector<uint8_t>(size, 0));
+}
+
+uint8_t* BufferMemorySource::AddRegion(uint64_t address, std::vector<uint8_t>&& bytes)
+{
+    const auto It = std::upper_bound(m_regions.begin(), m_regions.end(), address,
+        [](uint64_t value, const Region& region) { return value < region.Address; });
+    assert(It == m_regions.end() || address + bytes.size() <= It->Address);
+    assert(It == m_regions.begin() || (It - 1)->Address + (It - 1)->Bytes.size() <= address);
+
+    // Moving a region keeps its vector's storage, so handed out pointers survive later inserts
+    const auto Inserted = m_regions.insert(It, Region{ address, std::move(bytes) });
+    return Inserted->Bytes.data();
+}
+
+void BufferMemorySource::Clear()
+{
+    m_regions.clear();
+}
+
+bool BufferMemorySource::Read(uint64_t address, void* pBuffer, uint32_t size)
+{
+    const uint8_t* pSource = GetDirectPointer(address, size);
+    if (!pSource)
+    {
+        return false;
+    }
+
+    memcpy(pBuffer, pSource, size);
+    return true;
+}
+
+void BufferMemorySource::EnumerateRegions(std::vector<MemoryRegionInfo>& regionsOut)
+{
+    regionsOut.clear();
+    for (const Region& Entry : m_regions)
+    {
+        regionsOut.push_back({ Entry.Address, Entry.Bytes.size() });
+    }
+}
+
+const uint8_t* BufferMemorySource::GetDirectPointer(uint64_t address, uint32_t size)
+{
+    const Region* pRegion = FindRegion(address);
+    if (!pRegion || size > pRegion->Bytes.size() - (address - pRegion->Address))
+    {
+        return nullptr;
+    }
+
+    return pRegion->Bytes.data() + (address - pRegion->Address);
+}
+
+const BufferMemorySource::Region* BufferMemorySource::FindRegion(uint64_t address) const
+{
+    const auto It = std::upper_bound(m_regions.begin(), m_regions.end(), address,
+        [](uint64_t value, const Region& region) { return value < region.Address; });
+    if (It == m_regions.begin())
+    {
+        return nullptr;
+    }
+
+    const Region& Containing = *(It - 1);
+    return address - Containing.Address < Containing.Bytes.size() ? &Containing : nullptr;
+}
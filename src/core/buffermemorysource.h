@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "memorysource.h"
+
+//----------------------------------------------------------------------------
+// Memory source over local buffers placed at arbitrary addresses, for running
+// the scan engine against known contents without a target.
+//----------------------------------------------------------------------------
+
+class BufferMemorySource : public IMemorySource
+{
+public:
+    // Maps size zeroed bytes at address and returns them for the caller to fill
+    // in. The pointer stays valid until Clear(). Regions must not overlap.
+    uint8_t* AddRegion(uint64_t address, uint32_t size);
+    // Same, but takes over bytes that are already filled in rather than copying them
+    uint8_t* AddRegion(uint64_t address, std::vector<uint8_t>&& bytes);
+    void Clear();
+
+    // Reads can't span more than one region, even when regions are adjacent
+    bool Read(uint64_t address, void* pBuffer, uint32_t size) override;
+    void EnumerateRegions(std::vector<MemoryRegionInfo>& regionsOut) override;
+    const uint8_t* GetDirectPointer(uint64_t address, uint32_t size) override;
+
+private:
+    struct Region
+    {
+        uint64_t Address;
+        std::vector<uint8_t> Bytes;
+    };
+
+    // The region containing address, or null
+    const Region* FindRegion(uint64_t address) const;
+
+    // Sorted by address
+    std::vector<Region> m_regions;
+};
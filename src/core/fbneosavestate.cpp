@@ -0,0 +1,272 @@
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <zlib.h>
+
+#include "fbneosavestate.h"
+#include "mappedfile.h"
+
+namespace
+{
+    constexpr char kStateChunkId[] = "FS1 ";
+
+    // The chunk follows the 4 byte "FB1 " file id, but embedded states can start
+    // elsewhere, so look a little further
+    constexpr size_t kMaxChunkSearch = 0x100;
+
+    // The chunk header (versions, game name, frame counter and reserved fields)
+    // has grown over FBNeo's history. The compressed length always comes last,
+    // right before the zlib stream, so it's found by looking for that stream.
+    constexpr size_t kMinLengthFieldOffset = 0x40;
+    constexpr size_t kMaxLengthFieldOffset = 0x80;
+
+    // Output preceding the RAM is inflated into this and thrown away
+    constexpr size_t kDiscardBufferSize = 0x10000;
+
+    // Whole states grow by this much at a time as they're inflated
+    constexpr size_t kInflateChunkSize = 0x10000;
+
+    bool IsZlibHeader(const uint8_t* pData)
+    {
+        const uint8_t Cmf = pData[0];
+        const uint8_t Flg = pData[1];
+        return (Cmf & 0x0F) == Z_DEFLATED && (Cmf >> 4) <= 7 && ((Cmf << 8) | Flg) % 31 == 0;
+    }
+
+    // Finds the compressed state within a mapped savestate
+    bool FindCompressedState(const uint8_t* pData, size_t size, const uint8_t** ppStateOut, size_t* pStateSizeOut)
+    {
+        const uint8_t* pSearchEnd = pData + std::min(size, kMaxChunkSearch);
+        const uint8_t* pChunk = std::search(pData, pSearchEnd, kStateChunkId, kStateChunkId + 4);
+        if (pChunk == pSearchEnd)
+        {
+            return false;
+        }
+
+        const size_t ChunkOffset = pChunk - pData;
+        for (size_t fieldOffset = kMinLengthFieldOffset; fieldOffset <= kMaxLengthFieldOffset; fieldOffset += 4)
+        {
+            const size_t StreamOffset = ChunkOffset + fieldOffset + sizeof(uint32_t);
+            if (StreamOffset + 2 > size)
+            {
+                break;
+            }
+
+            uint32_t compressedSize;
+            memcpy(&compressedSize, pData + ChunkOffset + fieldOffset, sizeof(compressedSize));
+            if (compressedSize >= 2 && compressedSize <= size - StreamOffset && IsZlibHeader(pData + StreamOffset))
+            {
+                *ppStateOut = pData + StreamOffset;
+                *pStateSizeOut = compressedSize;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // Inflates a whole compressed state into stateOut
+    bool InflateState(const uint8_t* pCompressed, size_t compressedSize, std::vector<uint8_t>& stateOut)
+    {
+        z_stream stream = {};
+        if (inflateInit(&stream) != Z_OK)
+        {
+            return false;
+        }
+
+        stream.next_in = const_cast<Bytef*>(pCompressed);
+        stream.avail_in = static_cast<uInt>(compressedSize);
+
+        stateOut.clear();
+        int status = Z_OK;
+        while (status == Z_OK)
+        {
+            const size_t Produced = stateOut.size();
+            stateOut.resize(Produced + kInflateChunkSize);
+            stream.next_out = stateOut.data() + Produced;
+            stream.avail_out = static_cast<uInt>(kInflateChunkSize);
+            status = inflate(&stream, Z_NO_FLUSH);
+            stateOut.resize(stateOut.size() - stream.avail_out);
+        }
+
+        inflateEnd(&stream);
+        return status == Z_STREAM_END;
+    }
+}
+
+bool LoadSavestateRam(const char* pPath, const SavestateLayout& layout, std::vector<uint8_t>& ramOut)
+{
+    MappedFile file;
+    if (!file.Open(pPath))
+    {
+        return false;
+    }
+
+    const uint8_t* pCompressed;
+    size_t compressedSize;
+    if (!FindCompressedState(file.GetData(), file.GetSize(), &pCompressed, &compressedSize))
+    {
+        return false;
+    }
+
+    z_stream stream = {};
+    if (inflateInit(&stream) != Z_OK)
+    {
+        return false;
+    }
+
+    stream.next_in = const_cast<Bytef*>(pCompressed);
+    stream.avail_in = static_cast<uInt>(compressedSize);
+
+    // Inflate and drop everything before the RAM, then inflate the RAM straight into
+    // place and stop, leaving the rest of the state compressed
+    std::vector<uint8_t> discard(static_cast<size_t>(std::min<uint64_t>(layout.RamOffset, kDiscardBufferSize)));
+    ramOut.resize(layout.RamSize);
+
+    uint64_t produced = 0;
+    const uint64_t Wanted = layout.RamOffset + layout.RamSize;
+    int status = Z_OK;
+    while (produced < Wanted && status == Z_OK)
+    {
+        if (produced < layout.RamOffset)
+        {
+            stream.next_out = discard.data();
+            stream.avail_out = static_cast<uInt>(std::min<uint64_t>(discard.size(), layout.RamOffset - produced));
+        }
+        else
+        {
+            stream.next_out = ramOut.data() + (produced - layout.RamOffset);
+            stream.avail_out = static_cast<uInt>(Wanted - produced);
+        }
+
+        const uInt OutputSpace = stream.avail_out;
+        status = inflate(&stream, Z_NO_FLUSH);
+        produced += OutputSpace - stream.avail_out;
+    }
+
+    inflateEnd(&stream);
+    return produced == Wanted;
+}
+
+bool FindSavestateRamOffset(const char* pPath, const std::vector<uint8_t>& ram, uint64_t* pOffsetOut)
+{
+    MappedFile file;
+    const uint8_t* pCompressed;
+    size_t compressedSize;
+    std::vector<uint8_t> state;
+    if (ram.empty() ||
+        !file.Open(pPath) ||
+        !FindCompressedState(file.GetData(), file.GetSize(), &pCompressed, &compressedSize) ||
+        !InflateState(pCompressed, compressedSize, state))
+    {
+        return false;
+    }
+
+    const auto Found = std::search(state.begin(), state.end(), ram.begin(), ram.end());
+    if (Found == state.end() || std::search(Found + 1, state.end(), ram.begin(), ram.end()) != state.end())
+    {
+        return false;
+    }
+
+    *pOffsetOut = static_cast<uint64_t>(Found - state.begin());
+    return true;
+}
+
+void LoadSavestates(const std::vector<std::string>& paths, const SavestateLayout& layout,
+    unsigned numThreads, std::vector<LoadedSavestate>& statesOut)
+{
+    statesOut.clear();
+    statesOut.resize(paths.size());
+
+    if (numThreads == 0)
+    {
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    numThreads = static_cast<unsigned>(std::min<size_t>(numThreads, paths.size()));
+
+    // Files vary in size, so workers pull the next one as they go rather than
+    // splitting the list up front
+    std::atomic<size_t> nextIndex(0);
+    auto Worker = [&paths, &layout, &statesOut, &nextIndex]()
+    {
+        for (size_t i = nextIndex++; i < paths.size(); i = nextIndex++)
+        {
+            LoadedSavestate& state = statesOut[i];
+            state.Path = paths[i];
+
+            std::vector<uint8_t> ram;
+            state.Loaded = LoadSavestateRam(paths[i].c_str(), layout, ram);
+            if (state.Loaded)
+            {
+                state.Memory.AddRegion(layout.RamAddress, std::move(ram));
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned i = 1; i < numThreads; ++i)
+    {
+        workers.emplace_back(Worker);
+    }
+
+    // The calling thread pulls its weight too
+    Worker();
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+bool ListSavestates(const char* pDirectory, std::vector<std::string>& pathsOut)
+{
+    pathsOut.clear();
+
+#if defined(_WIN32)
+    const std::string Pattern = std::string(pDirectory) + "\\*.fs";
+    WIN32_FIND_DATAA findData;
+    HANDLE Find = FindFirstFileA(Pattern.c_str(), &findData);
+    if (Find == INVALID_HANDLE_VALUE)
+    {
+        return GetLastError() == ERROR_FILE_NOT_FOUND;
+    }
+
+    do
+    {
+        if (!(findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+        {
+            pathsOut.push_back(std::string(pDirectory) + "\\" + findData.cFileName);
+        }
+    } while (FindNextFileA(Find, &findData));
+    FindClose(Find);
+#else
+    DIR* pDir = opendir(pDirectory);
+    if (!pDir)
+    {
+        return false;
+    }
+
+    while (const dirent* pEntry = readdir(pDir))
+    {
+        const size_t Length = strlen(pEntry->d_name);
+        if (Length > 3 && strcmp(pEntry->d_name + Length - 3, ".fs") == 0)
+        {
+            pathsOut.push_back(std::string(pDirectory) + "/" + pEntry->d_name);
+        }
+    }
+    closedir(pDir);
+#endif
+
+    std::sort(pathsOut.begin(), pathsOut.end());
+    return true;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "buffermemorysource.h"
+
+//----------------------------------------------------------------------------
+// Loading 68K RAM out of FBNeo savestates (.fs), for scanning batches of
+// states offline.
+//
+// A savestate holds an "FS1 " chunk whose payload is the driver's state,
+// deflated. That state is every area the driver's scan callback registers,
+// back to back, so where 68K RAM sits in it depends on the driver and is
+// passed in through SavestateLayout.
+//
+// The offset also moves with the FBNeo version and the options a driver's
+// areas depend on, so rather than being worked out from the scan callback it
+// is found in a state saved while the RAM is known: pause the game, save a
+// state, break in and .writemem the RAM Neo68KRAM points at, then hand both
+// to FindSavestateRamOffset. States saved by the same build of the same
+// game all share it.
+//----------------------------------------------------------------------------
+
+struct SavestateLayout
+{
+    // Offset of 68K RAM within the decompressed driver state, i.e. the total
+    // size of everything the driver saves before it
+    uint64_t RamOffset;
+    uint32_t RamSize;
+
+    // Address the RAM is placed at in the resulting memory source, which is
+    // the host base scans should be given
+    uint64_t RamAddress;
+};
+
+// Inflates just enough of the state to pull out the RAM, streaming from a
+// mapping of the file. Returns false if the file isn't a savestate or its
+// state is too short to contain the RAM.
+bool LoadSavestateRam(const char* pPath, const SavestateLayout& layout, std::vector<uint8_t>& ramOut);
+
+// Finds where a copy of the RAM taken when the state was saved sits in its decompressed
+// state, which is SavestateLayout::RamOffset for every state saved the same way. Returns
+// false unless it's there exactly once.
+bool FindSavestateRamOffset(const char* pPath, const std::vector<uint8_t>& ram, uint64_t* pOffsetOut);
+
+struct LoadedSavestate
+{
+    std::string Path;
+    bool Loaded = false;
+
+    // The state's RAM at layout.RamAddress, if it loaded
+    BufferMemorySource Memory;
+};
+
+// Loads every file in paths, decompressing them in parallel on up to numThreads
+// worker threads (0 picks one per hardware thread). Results are in path order.
+void LoadSavestates(const std::vector<std::string>& paths, const SavestateLayout& layout,
+    unsigned numThreads, std::vector<LoadedSavestate>& statesOut);
+
+// Collects the paths of all .fs files in a directory, sorted by name
+bool ListSavestates(const char* pDirectory, std::vector<std::string>& pathsOut);
@@ -0,0 +1,771 @@
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <cinttypes>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "bcd.h"
+#include "fbneosession.h"
+#include "hitformat.h"
+#include "readplanner.h"
+
+namespace
+{
+    //------------------------------------------------------------------------
+    // Names accepted by memscan's -op argument, with the values each takes.
+    //------------------------------------------------------------------------
+    struct ScanPredicateName
+    {
+        const char* pName;
+        ScanPredicate Predicate;
+        const char* pOperands;
+    };
+
+    constexpr ScanPredicateName kScanPredicateNames[] =
+    {
+        { "eq",        ScanPredicate::Equal,       "a value" },
+        { "changed",   ScanPredicate::Changed,     "no values" },
+        { "unchanged", ScanPredicate::Unchanged,   "no values" },
+        { "inc",       ScanPredicate::Increased,   "no values" },
+        { "dec",       ScanPredicate::Decreased,   "no values" },
+        { "incby",     ScanPredicate::IncreasedBy, "a delta" },
+        { "decby",     ScanPredicate::DecreasedBy, "a delta" },
+        { "range",     ScanPredicate::InRange,     "a low and a high value, inclusive" },
+        { "mask",      ScanPredicate::MaskEqual,   "a mask and the value to compare the masked bits with" },
+        { "any",       ScanPredicate::AnyOf,       "one to 8 values" },
+    };
+
+    bool EqualsIgnoreCase(const char* pLeft, const char* pRight)
+    {
+        for (; *pLeft && *pRight; ++pLeft, ++pRight)
+        {
+            if (tolower(static_cast<unsigned char>(*pLeft)) != tolower(static_cast<unsigned char>(*pRight)))
+            {
+                return false;
+            }
+        }
+
+        return *pLeft == *pRight;
+    }
+
+    const ScanPredicateName* FindScanPredicate(const char* pName)
+    {
+        for (const ScanPredicateName& Entry : kScanPredicateNames)
+        {
+            if (EqualsIgnoreCase(pName, Entry.pName))
+            {
+                return &Entry;
+            }
+        }
+
+        return nullptr;
+    }
+
+    // Values wider than the scan are truncated to it, like a plain search value always was
+    template<typename TScanType>
+    ScanOperand<TScanType> MakeOperand(const std::vector<uint64_t>& values)
+    {
+        TScanType truncated[kMaxScanOperandValues] = {};
+        const uint32_t NumValues = static_cast<uint32_t>(std::min<size_t>(values.size(), kMaxScanOperandValues));
+        for (uint32_t i = 0; i < NumValues; ++i)
+        {
+            truncated[i] = static_cast<TScanType>(values[i]);
+        }
+
+        return MakeScanOperand(truncated, NumValues);
+    }
+}
+
+FBNeoSession::FBNeoSession(IMemorySource& memory, ISymbolProvider& symbols, ICommandOutput& output)
+    : m_memorySource(memory)
+    , m_output(output)
+    , m_symbolCache(symbols)
+{
+}
+
+void FBNeoSession::SetPointerSize(uint32_t pointerSize)
+{
+    assert(pointerSize == 4 || pointerSize == 8);
+    m_pointerSize = pointerSize;
+}
+
+uint32_t FBNeoSession::GetPointerSize() const
+{
+    return m_pointerSize;
+}
+
+void FBNeoSession::Invalidate()
+{
+    m_symbolCache.Invalidate();
+    m_memoryMap.Invalidate();
+}
+
+void FBNeoSession::RequestRevalidation()
+{
+    m_symbolCache.RequestRevalidation();
+    m_memoryMap.Invalidate();
+}
+
+IMemorySource& FBNeoSession::GetMemorySource()
+{
+    return m_memorySource;
+}
+
+//----------------------------------------------------------------------------
+//
+// Helpers
+//
+//----------------------------------------------------------------------------
+
+void FBNeoSession::Out(const char* pFormat, ...)
+{
+    va_list args;
+    va_start(args, pFormat);
+    m_output.OutVa(pFormat, args);
+    va_end(args);
+}
+
+void FBNeoSession::Err(const char* pFormat, ...)
+{
+    va_list args;
+    va_start(args, pFormat);
+    m_output.ErrVa(pFormat, args);
+    va_end(args);
+}
+
+bool FBNeoSession::ResolveSymbol(const char* pSymbol, uint64_t* pAddressOut)
+{
+    if (!m_symbolCache.GetSymbolAddress(pSymbol, pAddressOut))
+    {
+        Err("Unable to resolve '%s'\n", pSymbol);
+        return false;
+    }
+
+    return true;
+}
+
+bool FBNeoSession::ResolveFieldOffset(const char* pModule, const char* pType, const char* pField, uint32_t* pOffsetOut)
+{
+    if (!m_symbolCache.GetFieldOffset(pModule, pType, pField, pOffsetOut))
+    {
+        Err("Unable to find %s!%s.%s\n", pModule, pType, pField);
+        return false;
+    }
+
+    return true;
+}
+
+bool FBNeoSession::ReadPointer(uint64_t address, uint64_t* pPointerOut)
+{
+    assert(m_pointerSize == 4 || m_pointerSize == 8);
+
+    // Both the targets and the hosts are little-endian
+    uint64_t pointer = 0;
+    if (!m_memorySource.Read(address, &pointer, m_pointerSize))
+    {
+        Err("Unable to read a pointer at 0x%016" PRIX64 "\n", address);
+        return false;
+    }
+
+    *pPointerOut = pointer;
+    return true;
+}
+
+// The pointers themselves are read fresh every time since FBNeo reallocates them
+// whenever a game is loaded, only the symbol lookups are cached.
+bool FBNeoSession::GetM68KRAMBase(uint64_t* pBaseOut)
+{
+    uint64_t symbol;
+    return ResolveSymbol(kNeo68KRAMSymbol, &symbol) && ReadPointer(symbol, pBaseOut);
+}
+
+// The whole pSekExt->MemMap page table comes over in one read, after which
+// translating any 68K address is just a table lookup. Null if it couldn't be read.
+const M68KMemoryMap* FBNeoSession::GetM68KMemoryMap()
+{
+    if (!m_memoryMap.IsLoaded())
+    {
+        uint64_t symbol;
+        uint64_t sekExt;
+        uint32_t memMapOffset;
+        if (!ResolveSymbol(kSekExtSymbol, &symbol) ||
+            !ReadPointer(symbol, &sekExt) ||
+            !ResolveFieldOffset(kFBNeoModule, "SekExt", "MemMap", &memMapOffset))
+        {
+            return nullptr;
+        }
+
+        const uint64_t MemMap = sekExt + memMapOffset;
+        std::vector<uint8_t> rawEntries(M68KMemoryMap::kNumEntries * m_pointerSize);
+        if (!m_memorySource.Read(MemMap, rawEntries.data(), static_cast<uint32_t>(rawEntries.size())))
+        {
+            Err("Unable to read pSekExt->MemMap at 0x%016" PRIX64 "\n", MemMap);
+            return nullptr;
+        }
+        m_memoryMap.Load(rawEntries.data(), m_pointerSize);
+    }
+
+    return &m_memoryMap;
+}
+
+// Where the host currently has a 68K region mapped. Slots only remember 68K offsets,
+// so commands look this up once and translate everything against it.
+bool FBNeoSession::GetRegionHostBase(const M68KRegion& region, uint64_t* pHostBaseOut)
+{
+    assert(region == kNeoGeoWorkRam);
+    (void)region;
+    return GetM68KRAMBase(pHostBaseOut);
+}
+
+// Reads 68K memory into pBuffer in 68K byte order, with one read per run of pages FBNeo
+// mapped onto contiguous host memory. Bytes on pages with no memory behind them, or that
+// couldn't be read, come back as zero and are flagged in pReadable, if given. Returns
+// false if there were any, or if the memory map itself couldn't be read.
+bool FBNeoSession::ReadM68KMemory(uint32_t address, uint32_t size, uint8_t* pBuffer, uint8_t* pReadable)
+{
+    assert(address <= kM68KAddressMask && size <= kM68KAddressMask + 1 - address);
+
+    const M68KMemoryMap* pMemoryMap = GetM68KMemoryMap();
+    if (!pMemoryMap)
+    {
+        memset(pBuffer, 0, size);
+        if (pReadable)
+        {
+            memset(pReadable, 0, size);
+        }
+        return false;
+    }
+
+    // FBNeo keeps each 68K word in host order, so whole words are fetched and
+    // their bytes put back in the right order locally
+    const uint32_t AlignedStart = address & ~1u;
+    const uint32_t AlignedSize = ((address + size + 1) & ~1u) - AlignedStart;
+    std::vector<uint8_t> hostBytes(AlignedSize, 0);
+    std::vector<uint8_t> hostReadable(AlignedSize, 0);
+
+    std::vector<M68KHostRun> runs;
+    pMemoryMap->SplitIntoHostRuns(AlignedStart, AlignedSize, M68KAccess::Read, runs);
+
+    std::vector<ScatterReadEntry> reads;
+    for (const M68KHostRun& Run : runs)
+    {
+        if (Run.Translation.Kind == M68KPageKind::Memory)
+        {
+            const uint32_t Offset = Run.M68KAddress - AlignedStart;
+            reads.push_back({ Run.Translation.HostAddress, hostBytes.data() + Offset, Run.Size, false });
+        }
+    }
+
+    m_memorySource.ReadScatter(reads.data(), reads.size());
+    for (const ScatterReadEntry& Read : reads)
+    {
+        if (Read.Succeeded)
+        {
+            memset(hostReadable.data() + (static_cast<uint8_t*>(Read.pBuffer) - hostBytes.data()), 1, Read.Size);
+        }
+    }
+
+    bool allReadable = true;
+    for (uint32_t i = 0; i < size; ++i)
+    {
+        const uint32_t HostOffset = ((address + i) ^ 1) - AlignedStart;
+        pBuffer[i] = hostBytes[HostOffset];
+        allReadable &= hostReadable[HostOffset] != 0;
+        if (pReadable)
+        {
+            pReadable[i] = hostReadable[HostOffset];
+        }
+    }
+
+    return allReadable;
+}
+
+// Every slot command takes the slot name as its first argument
+bool FBNeoSession::GetSlotName(const char* pSlot, std::string& nameOut)
+{
+    if (!MemScanSlotPool::NormalizeName(pSlot, nameOut))
+    {
+        Out("Invalid slot name '%s'. Use a number or up to %u letters, digits and underscores\n",
+            pSlot, static_cast<uint32_t>(MemScanSlotPool::kMaxNameLength));
+        return false;
+    }
+
+    return true;
+}
+
+void FBNeoSession::PrintSlot(const std::string& name, const MemScanSlot* pSlot)
+{
+    if (!pSlot || pSlot->IsClear())
+    {
+        Out("Slot %s is clear\n", name.c_str());
+        return;
+    }
+
+    const MemScanSlot& Slot = *pSlot;
+    if (Slot.GetNumEntries() > kMaxPrintedEntries)
+    {
+        // Far too many to list, keep refining until they fit or page through them
+        Out("Slot %s: %u hits, refine further or list some with !slotinfo %s <start> <count>\n",
+            name.c_str(), Slot.GetNumEntries(), name.c_str());
+    }
+    else
+    {
+        Out("Slot %s:\n", name.c_str());
+        PrintSlotHits(Slot, 0, Slot.GetNumEntries());
+        Out("Listed %u entries\n", Slot.GetNumEntries());
+    }
+}
+
+// Lists the numHits hits starting at hit number firstHit. Values for all of them are
+// fetched up front with a few coalesced reads and formatted from the local copy.
+void FBNeoSession::PrintSlotHits(const MemScanSlot& slot, uint32_t firstHit, uint32_t numHits)
+{
+    std::vector<uint32_t> hitIndices;
+    hitIndices.reserve(numHits);
+    uint32_t hitNumber = 0;
+    slot.GetHits().ForEach([firstHit, numHits, &hitIndices, &hitNumber](uint32_t hitIndex)
+    {
+        if (hitNumber >= firstHit && hitNumber - firstHit < numHits)
+        {
+            hitIndices.push_back(hitIndex);
+        }
+        ++hitNumber;
+    });
+
+    uint64_t hostBase;
+    if (hitIndices.empty() || !GetRegionHostBase(slot.GetRegion(), &hostBase))
+    {
+        return;
+    }
+
+    const uint8_t SlotSize = slot.GetSlotSize();
+    const uint32_t HostSize = slot.GetHitHostSize();
+    std::vector<uint64_t> hostAddresses;
+    hostAddresses.reserve(hitIndices.size());
+    for (const uint32_t HitIndex : hitIndices)
+    {
+        hostAddresses.push_back(hostBase + slot.GetHitHostOffset(HitIndex));
+    }
+
+    std::vector<ReadRange> readRanges;
+    PlanCoalescedReads(hostAddresses.data(), hostAddresses.size(), HostSize, kDefaultMaxReadGap, readRanges);
+
+    // Starting on a host word keeps 68K offsets relative to the span in the region's byte order
+    const uint64_t SpanStart = readRanges.front().Address & ~1ull;
+    const uint64_t SpanSize = readRanges.back().Address + readRanges.back().Size - SpanStart;
+    std::vector<uint8_t> localSpan(SpanSize);
+    std::vector<uint8_t> readable(SpanSize, 0);
+    std::vector<ScatterReadEntry> reads;
+    reads.reserve(readRanges.size());
+    for (const ReadRange& Range : readRanges)
+    {
+        reads.push_back({ Range.Address, localSpan.data() + (Range.Address - SpanStart), Range.Size, false });
+    }
+
+    m_memorySource.ReadScatter(reads.data(), reads.size());
+    for (const ScatterReadEntry& Read : reads)
+    {
+        if (Read.Succeeded)
+        {
+            memset(readable.data() + (Read.Address - SpanStart), 1, Read.Size);
+        }
+    }
+
+    const uint32_t SpanM68KOffset = static_cast<uint32_t>(SpanStart - hostBase);
+    char line[kMaxHitLineLength];
+    uint8_t value[4];
+    for (size_t i = 0; i < hitIndices.size(); ++i)
+    {
+        const size_t SpanOffset = static_cast<size_t>(hostAddresses[i] - SpanStart);
+        const bool Readable = memchr(readable.data() + SpanOffset, 0, HostSize) == nullptr;
+        if (Readable)
+        {
+            CopyM68KBytes(localSpan.data(), slot.GetHitM68KOffset(hitIndices[i]) - SpanM68KOffset, SlotSize, value);
+        }
+
+        FormatHitLine(
+            line,
+            sizeof(line),
+            firstHit + static_cast<uint32_t>(i),
+            slot.GetHitM68KAddress(hitIndices[i]),
+            Readable ? value : nullptr,
+            SlotSize,
+            slot.GetEncoding() == ScanEncoding::Bcd);
+        Out("%s", line);
+    }
+}
+
+//----------------------------------------------------------------------------
+//
+// Commands
+//
+//----------------------------------------------------------------------------
+
+void FBNeoSession::MemBase()
+{
+    uint64_t base;
+    if (GetM68KRAMBase(&base))
+    {
+        Out("m68k RAM base: 0x%016" PRIX64 "\n", base);
+    }
+}
+
+// Shared by readb, readw and readl
+void FBNeoSession::ReadValue(uint64_t address, uint8_t valueSize)
+{
+    const uint32_t Address = static_cast<uint32_t>(address) & kM68KAddressMask;
+    if (valueSize > 1 && (Address & 1))
+    {
+        Out("$%06X is odd, the 68000 only reads words and longs from even addresses\n", Address);
+        return;
+    }
+
+    if (valueSize > kM68KAddressMask + 1 - Address)
+    {
+        Out("$%06X runs past the end of the 68K address space\n", Address);
+        return;
+    }
+
+    const M68KMemoryMap* pMemoryMap = GetM68KMemoryMap();
+    if (!pMemoryMap)
+    {
+        return;
+    }
+
+    // This is modeled after the implementation in FBNeo's ReadByte() in
+    // m68000_intf.cpp, which reads bytes from the other half of their word.
+    const M68KTranslation Translation = pMemoryMap->Translate(valueSize == 1 ? Address ^ 1 : Address);
+    if (Translation.Kind == M68KPageKind::Unmapped)
+    {
+        Out("$%06X is unmapped\n", Address);
+        return;
+    }
+    if (Translation.Kind == M68KPageKind::Handler)
+    {
+        Out("$%06X is handled by read handler %u\n", Address, Translation.HandlerIndex);
+        return;
+    }
+
+    uint8_t bytes[4];
+    if (!ReadM68KMemory(Address, valueSize, bytes, nullptr))
+    {
+        Out("$%06X spans a page with no memory behind it\n", Address);
+        return;
+    }
+
+    // The buffer is in 68K order, so values are assembled big-endian
+    uint32_t value = 0;
+    for (uint8_t i = 0; i < valueSize; ++i)
+    {
+        value = (value << 8) | bytes[i];
+    }
+
+    Out("$%06X (0x%016" PRIX64 ") = 0x%0*X\n", Address, Translation.HostAddress, valueSize * 2, value);
+}
+
+// Dumps a range of 68K address space in 68K byte order, 16 bytes a line.
+// Bytes on pages with no memory behind them show as ??.
+void FBNeoSession::DumpRange(uint64_t address, uint64_t length)
+{
+    const uint32_t Address = static_cast<uint32_t>(address) & kM68KAddressMask;
+    if (length == 0 || length > kMaxReadRangeSize)
+    {
+        Out("Length must be between 1 and 0x%X\n", kMaxReadRangeSize);
+        return;
+    }
+    if (length > kM68KAddressMask + 1 - Address)
+    {
+        Out("$%06X + 0x%X runs past the end of the 68K address space\n", Address, static_cast<uint32_t>(length));
+        return;
+    }
+
+    if (!GetM68KMemoryMap())
+    {
+        return;
+    }
+
+    const uint32_t Size = static_cast<uint32_t>(length);
+    std::vector<uint8_t> bytes(Size);
+    std::vector<uint8_t> readable(Size);
+    ReadM68KMemory(Address, Size, bytes.data(), readable.data());
+
+    constexpr uint32_t kBytesPerLine = 16;
+    for (uint32_t lineStart = 0; lineStart < Size; lineStart += kBytesPerLine)
+    {
+        char hex[kBytesPerLine * 3 + 1] = {};
+        char ascii[kBytesPerLine + 1] = {};
+        const uint32_t LineSize = std::min(kBytesPerLine, Size - lineStart);
+        for (uint32_t i = 0; i < LineSize; ++i)
+        {
+            const uint8_t Byte = bytes[lineStart + i];
+            if (readable[lineStart + i])
+            {
+                snprintf(hex + i * 3, 4, "%02X ", Byte);
+                ascii[i] = (Byte >= 0x20 && Byte < 0x7F) ? static_cast<char>(Byte) : '.';
+            }
+            else
+            {
+                snprintf(hex + i * 3, 4, "?? ");
+                ascii[i] = '?';
+            }
+        }
+
+        Out("$%06X  %-48s %s\n", Address + lineStart, hex, ascii);
+    }
+}
+
+// The first scan of a slot either looks for values matching eq, range, mask
+// or any or, with -u, snapshots the region for an unknown initial value.
+// Scans of a slot that already holds results refine them, with any -op.
+// With -bcd, values are decimal numbers the target keeps as packed BCD.
+void FBNeoSession::MemScan(const MemScanArgs& args)
+{
+    std::string slotName;
+    if (!GetSlotName(args.pSlot, slotName))
+    {
+        return;
+    }
+
+    const uint64_t ValueSize = args.ValueSize;
+    if (args.Bcd && (ValueSize < 1 || ValueSize > kMaxBcdSize))
+    {
+        Out("Invalid BCD value size %" PRIu64 ". Must be 1 to %u\n", ValueSize, kMaxBcdSize);
+        return;
+    }
+    if (!args.Bcd && ValueSize != 1 && ValueSize != 2 && ValueSize != 4)
+    {
+        Out("Invalid search value size %" PRIu64 ". Must be 1, 2 or 4\n", ValueSize);
+        return;
+    }
+
+    const ScanPredicateName* pPredicate = &kScanPredicateNames[0];
+    if (args.pPredicate)
+    {
+        if (args.UnknownScan)
+        {
+            Out("-u starts a new scan and can't be combined with -op\n");
+            return;
+        }
+
+        pPredicate = FindScanPredicate(args.pPredicate);
+        if (!pPredicate)
+        {
+            Out("Unknown scan predicate '%s'\n", args.pPredicate);
+            return;
+        }
+    }
+
+    const ScanPredicate Predicate = pPredicate->Predicate;
+    const size_t NumValues = args.Values.size();
+    if (!args.UnknownScan)
+    {
+        if (NumValues == 0 && GetMinOperandValues(Predicate) == 1)
+        {
+            Out("A value is required for this scan\n");
+            return;
+        }
+
+        if (NumValues < GetMinOperandValues(Predicate) || NumValues > GetMaxOperandValues(Predicate))
+        {
+            Out("-op %s takes %s\n", pPredicate->pName, pPredicate->pOperands);
+            return;
+        }
+
+        if (args.Bcd)
+        {
+            if (Predicate == ScanPredicate::MaskEqual)
+            {
+                Out("-op mask doesn't apply to BCD values\n");
+                return;
+            }
+
+            // BCD values aren't truncated, a digit too many is far more likely a typo
+            const uint32_t MaxValue = GetMaxBcdValue(static_cast<uint8_t>(ValueSize));
+            for (const uint64_t Value : args.Values)
+            {
+                if (Value > MaxValue)
+                {
+                    Out("%" PRIu64 " doesn't fit in %" PRIu64 " bytes of BCD, which hold up to %u\n", Value, ValueSize, MaxValue);
+                    return;
+                }
+            }
+
+            if (Predicate == ScanPredicate::InRange && args.Values[0] > args.Values[1])
+            {
+                Out("Empty range, %" PRIu64 " is above %" PRIu64 "\n", args.Values[0], args.Values[1]);
+                return;
+            }
+        }
+        else
+        {
+            const uint64_t ValueMask = ValueSize == 4 ? 0xFFFFFFFF : (1ull << (ValueSize * 8)) - 1;
+            if (Predicate == ScanPredicate::InRange && (args.Values[0] & ValueMask) > (args.Values[1] & ValueMask))
+            {
+                Out("Empty range, 0x%" PRIX64 " is above 0x%" PRIX64 "\n", args.Values[0] & ValueMask, args.Values[1] & ValueMask);
+                return;
+            }
+        }
+    }
+
+    if (PredicateUsesSnapshot(Predicate) && !m_scanSlots.Find(slotName))
+    {
+        Out("Slot %s has no previous scan to compare against\n", slotName.c_str());
+        return;
+    }
+
+    // Slots hold 68K offsets, so the host mapping is looked up fresh for every scan
+    const MemScanSlot* pExistingSlot = m_scanSlots.Find(slotName);
+    const bool Refining = pExistingSlot && !pExistingSlot->IsClear() && !args.UnknownScan;
+    if (Refining && args.AnyAlignment && pExistingSlot->GetAlignment() != ScanAlignment::Any)
+    {
+        Out("-odd only applies when starting a scan, clear slot %s first\n", slotName.c_str());
+        return;
+    }
+
+    if (Refining && pExistingSlot->GetSlotSize() != ValueSize)
+    {
+        Out("Slot %s holds %u byte values, clear it first to scan for %" PRIu64 " byte ones\n", slotName.c_str(),
+            pExistingSlot->GetSlotSize(), ValueSize);
+        return;
+    }
+
+    // The values mean something else either way, so -bcd has to be given for every scan of a BCD slot
+    if (Refining && args.Bcd != (pExistingSlot->GetEncoding() == ScanEncoding::Bcd))
+    {
+        Out(args.Bcd ? "Slot %s doesn't hold BCD values, clear it first\n" : "Slot %s holds BCD values, scan it with -bcd\n",
+            slotName.c_str());
+        return;
+    }
+
+    const ScanAlignment Alignment = Refining ? pExistingSlot->GetAlignment()
+        : args.AnyAlignment ? ScanAlignment::Any : ScanAlignment::Even;
+    const M68KRegion Region = pExistingSlot && !pExistingSlot->IsClear() ? pExistingSlot->GetRegion() : kNeoGeoWorkRam;
+    uint64_t hostBase;
+    if (!GetRegionHostBase(Region, &hostBase))
+    {
+        return;
+    }
+
+    MemScanSlot* pTargetSlot = m_scanSlots.FindOrCreate(slotName);
+    if (!pTargetSlot)
+    {
+        Out("All %u slots are in use, clear one with !slotclear first\n",
+            static_cast<uint32_t>(MemScanSlotPool::kMaxSlots));
+        return;
+    }
+
+    MemScanSlot& targetSlot = *pTargetSlot;
+    bool success = false;
+    if (args.UnknownScan)
+    {
+        success = targetSlot.BeginUnknownScan(m_memorySource, Region, hostBase, static_cast<uint8_t>(ValueSize), Alignment,
+            args.Bcd ? ScanEncoding::Bcd : ScanEncoding::Binary);
+    }
+    else if (args.Bcd)
+    {
+        success = targetSlot.ScanForBcd(m_memorySource, Region, hostBase, static_cast<uint8_t>(ValueSize),
+            MakeOperand<uint32_t>(args.Values), Predicate, Alignment);
+    }
+    else if (ValueSize == 1)
+    {
+        success = targetSlot.ScanForByte(m_memorySource, Region, hostBase, MakeOperand<uint8_t>(args.Values), Predicate);
+    }
+    else if (ValueSize == 2)
+    {
+        success = targetSlot.ScanForHalfWord(m_memorySource, Region, hostBase, MakeOperand<uint16_t>(args.Values), Predicate, Alignment);
+    }
+    else if (ValueSize == 4)
+    {
+        success = targetSlot.ScanForWord(m_memorySource, Region, hostBase, MakeOperand<uint32_t>(args.Values), Predicate, Alignment);
+    }
+
+    if (!success)
+    {
+        // Everything else a scan can fail on was ruled out above
+        Out("Failed to perform memory scan on slot %s, unable to read %s at 0x%016" PRIX64 "\n", slotName.c_str(),
+            Region.pName, hostBase);
+    }
+    else
+    {
+        PrintSlot(slotName, &targetSlot);
+    }
+
+    // Nothing worth keeping, hand the memory back
+    if (targetSlot.IsClear())
+    {
+        m_scanSlots.Release(slotName);
+    }
+}
+
+void FBNeoSession::SlotClear(const char* pSlot)
+{
+    std::string slotName;
+    if (!GetSlotName(pSlot, slotName))
+    {
+        return;
+    }
+
+    m_scanSlots.Release(slotName);
+    PrintSlot(slotName, nullptr);
+}
+
+// Without a start, lists every hit of the slot if there aren't too many.
+// Given a start, lists up to count hits from that hit number on, whatever
+// the slot holds, so large result sets can be paged through.
+void FBNeoSession::SlotInfo(const char* pSlot, bool hasStart, uint64_t start, bool hasCount, uint64_t count)
+{
+    std::string slotName;
+    if (!GetSlotName(pSlot, slotName))
+    {
+        return;
+    }
+
+    const MemScanSlot* pFoundSlot = m_scanSlots.Find(slotName);
+    if (!hasStart || !pFoundSlot || pFoundSlot->IsClear())
+    {
+        PrintSlot(slotName, pFoundSlot);
+        return;
+    }
+
+    const uint32_t NumEntries = pFoundSlot->GetNumEntries();
+    const uint64_t Count = hasCount ? count : kMaxPrintedEntries;
+    if (start >= NumEntries)
+    {
+        Out("Slot %s only has %u hits\n", slotName.c_str(), NumEntries);
+        return;
+    }
+    if (Count == 0 || Count > kMaxPrintedEntries)
+    {
+        Out("Count must be between 1 and %u\n", kMaxPrintedEntries);
+        return;
+    }
+
+    const uint32_t FirstHit = static_cast<uint32_t>(start);
+    const uint32_t NumHits = static_cast<uint32_t>(Count < NumEntries - start ? Count : NumEntries - start);
+    Out("Slot %s, hits %u to %u of %u:\n", slotName.c_str(), FirstHit, FirstHit + NumHits - 1, NumEntries);
+    PrintSlotHits(*pFoundSlot, FirstHit, NumHits);
+}
+
+void FBNeoSession::SlotLs()
+{
+    if (m_scanSlots.GetNumSlots() == 0)
+    {
+        Out("All slots are clear\n");
+        return;
+    }
+
+    m_scanSlots.ForEach([this](const std::string& name, const MemScanSlot& slot)
+    {
+        Out("Slot %s: Size %u%s%s, %u hits, %u KB\n",
+            name.c_str(), slot.GetSlotSize(), slot.GetEncoding() == ScanEncoding::Bcd ? " BCD" : "",
+            slot.GetAlignment() == ScanAlignment::Any ? " at any address" : "",
+            slot.GetNumEntries(), static_cast<uint32_t>((slot.GetMemoryUsage() + 1023) / 1024));
+    });
+    Out("%u of %u slots in use\n",
+        static_cast<uint32_t>(m_scanSlots.GetNumSlots()), static_cast<uint32_t>(MemScanSlotPool::kMaxSlots));
+}
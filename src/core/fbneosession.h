@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstdarg>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "m68kmemorymap.h"
+#include "m68kregion.h"
+#include "memorysource.h"
+#include "memscanslot.h"
+#include "memscanslotpool.h"
+#include "scanpredicate.h"
+#include "symbolcache.h"
+
+//----------------------------------------------------------------------------
+// FBNeo symbols the commands depend on.
+//----------------------------------------------------------------------------
+constexpr char kFBNeoModule[] = "fbneo64d_vs";
+constexpr char kNeo68KRAMSymbol[] = "fbneo64d_vs!Neo68KRAM";
+constexpr char kSekExtSymbol[] = "fbneo64d_vs!pSekExt";
+
+//----------------------------------------------------------------------------
+// Where command output goes. The extension hands it to the debugger, tools
+// print it or throw it away.
+//----------------------------------------------------------------------------
+
+class ICommandOutput
+{
+public:
+    virtual ~ICommandOutput() = default;
+
+    virtual void OutVa(const char* pFormat, va_list args) = 0;
+    virtual void ErrVa(const char* pFormat, va_list args) = 0;
+};
+
+// Arguments of memscan, already split up but not yet validated
+struct MemScanArgs
+{
+    const char* pSlot = nullptr;
+    uint64_t ValueSize = 0;
+    bool UnknownScan = false;
+    // Also look for words and longs at odd addresses, when starting a scan
+    bool AnyAlignment = false;
+    // Values are decimal numbers, kept by the target as packed BCD of ValueSize bytes
+    bool Bcd = false;
+
+    // Null for the default, ScanPredicate::Equal
+    const char* pPredicate = nullptr;
+
+    // The search value, or for -op, the values the predicate takes
+    std::vector<uint64_t> Values;
+};
+
+//----------------------------------------------------------------------------
+// The extension's view of an FBNeo process and the commands that work on it,
+// without any dependency on the debugger engine.
+//
+// Everything comes in through an IMemorySource and an ISymbolProvider and
+// goes out through an ICommandOutput, so the same commands run inside the
+// debugger, against a replayed trace or against a synthetic target. Bad
+// arguments and failed lookups are reported on the output and end the
+// command early.
+//----------------------------------------------------------------------------
+
+class FBNeoSession
+{
+public:
+    FBNeoSession(IMemorySource& memory, ISymbolProvider& symbols, ICommandOutput& output);
+
+    // Pointer size of the target, 4 or 8. Must be set before running any command.
+    void SetPointerSize(uint32_t pointerSize);
+    uint32_t GetPointerSize() const;
+
+    // Forgets everything learned about the target, e.g. when a new session starts
+    void Invalidate();
+
+    // The target has been running, so modules may have been loaded or unloaded and the
+    // game may have remapped memory. Nothing is reread until the next command.
+    void RequestRevalidation();
+
+    IMemorySource& GetMemorySource();
+
+    // Commands
+    void MemBase();
+    void ReadValue(uint64_t address, uint8_t valueSize);
+    void DumpRange(uint64_t address, uint64_t length);
+    void MemScan(const MemScanArgs& args);
+    void SlotClear(const char* pSlot);
+    void SlotInfo(const char* pSlot, bool hasStart, uint64_t start, bool hasCount, uint64_t count);
+    void SlotLs();
+
+    // Slots with more hits than this only print a summary
+    static constexpr uint32_t kMaxPrintedEntries = 0x1000;
+
+    // Largest range readrange will dump in one go
+    static constexpr uint32_t kMaxReadRangeSize = 0x10000;
+
+private:
+    void Out(const char* pFormat, ...);
+    void Err(const char* pFormat, ...);
+
+    bool ResolveSymbol(const char* pSymbol, uint64_t* pAddressOut);
+    bool ResolveFieldOffset(const char* pModule, const char* pType, const char* pField, uint32_t* pOffsetOut);
+    bool ReadPointer(uint64_t address, uint64_t* pPointerOut);
+    bool GetM68KRAMBase(uint64_t* pBaseOut);
+    const M68KMemoryMap* GetM68KMemoryMap();
+    bool GetRegionHostBase(const M68KRegion& region, uint64_t* pHostBaseOut);
+    bool ReadM68KMemory(uint32_t address, uint32_t size, uint8_t* pBuffer, uint8_t* pReadable);
+    bool GetSlotName(const char* pSlot, std::string& nameOut);
+    void PrintSlot(const std::string& name, const MemScanSlot* pSlot);
+    void PrintSlotHits(const MemScanSlot& slot, uint32_t firstHit, uint32_t numHits);
+
+    IMemorySource& m_memorySource;
+    ICommandOutput& m_output;
+    uint32_t m_pointerSize = 0;
+
+    // Symbol addresses and type layouts resolved so far this session
+    SymbolCache m_symbolCache;
+
+    // Mirror of pSekExt->MemMap, pulled in on first use after the target last ran
+    M68KMemoryMap m_memoryMap;
+
+    // Memory scan slot data
+    // A slot only exists while it contains some number of hits against a previous search
+    MemScanSlotPool m_scanSlots;
+};
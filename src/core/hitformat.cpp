@@ -0,0 +1,47 @@
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#include "bcd.h"
+#include "hitformat.h"
+
+size_t FormatHitLine(char* pBuffer, size_t bufferSize, uint32_t number, uint32_t m68kAddress, const uint8_t* pValue, uint8_t valueSize,
+    bool bcd)
+{
+    assert(pBuffer && bufferSize > 0);
+    assert(valueSize >= 1 && valueSize <= 4);
+
+    int length;
+    if (!pValue)
+    {
+        length = snprintf(pBuffer, bufferSize, "%u:\t$%06X\t??\n", number, m68kAddress);
+    }
+    else
+    {
+        uint32_t value = 0;
+        for (uint32_t i = 0; i < valueSize; ++i)
+        {
+            value = (value << 8) | pValue[i];
+        }
+
+        const uint32_t Decimal = bcd ? DecodeBcd(value, valueSize) : kInvalidBcd;
+        if (Decimal != kInvalidBcd)
+        {
+            length = snprintf(pBuffer, bufferSize, "%u:\t$%06X\t0n%u\n", number, m68kAddress, Decimal);
+        }
+        else
+        {
+            length = snprintf(pBuffer, bufferSize, "%u:\t$%06X\t0x%0*X\n", number, m68kAddress, valueSize * 2, value);
+        }
+    }
+
+    if (length < 0)
+    {
+        pBuffer[0] = '\0';
+        return 0;
+    }
+
+    // Truncated lines are cut at the end of the buffer
+    return static_cast<size_t>(length) < bufferSize ? static_cast<size_t>(length) : bufferSize - 1;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+//----------------------------------------------------------------------------
+// Text formatting for scan hit listings, shared by the debugger commands and
+// the benchmark so both measure the same code.
+//----------------------------------------------------------------------------
+
+// Longest line FormatHitLine can produce, including the terminator
+constexpr size_t kMaxHitLineLength = 40;
+
+// Formats one hit of a listing as "number:\t$address\tvalue\n". valueSize is 1 to 4 and pValue
+// points at that many bytes of value in 68K order, or is null when the value couldn't be read.
+// BCD values that are still valid are shown in decimal, as 0n1234. Returns the number of
+// characters written, not counting the terminator.
+size_t FormatHitLine(char* pBuffer, size_t bufferSize, uint32_t number, uint32_t m68kAddress, const uint8_t* pValue, uint8_t valueSize,
+    bool bcd = false);
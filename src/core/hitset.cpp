@@ -0,0 +1,144 @@
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "hitset.h"
+
+void HitSet::Reset(uint32_t universeSize)
+{
+    Clear();
+    m_universeSize = universeSize;
+}
+
+void HitSet::Clear()
+{
+    // Swap rather than clear so the set actually lets go of the memory
+    std::vector<uint64_t>().swap(m_bits);
+    std::vector<uint32_t>().swap(m_indices);
+    m_universeSize = 0;
+    m_count = 0;
+    m_dense = false;
+}
+
+void HitSet::AddAll()
+{
+    std::vector<uint32_t>().swap(m_indices);
+    m_bits.assign((m_universeSize + 63) / 64, ~0ull);
+
+    // Bits past the end of the universe must stay clear
+    if (m_universeSize % 64)
+    {
+        m_bits.back() = (1ull << (m_universeSize % 64)) - 1;
+    }
+
+    m_count = m_universeSize;
+    m_dense = true;
+}
+
+void HitSet::Append(uint32_t index)
+{
+    assert(index < m_universeSize);
+
+    if (m_dense)
+    {
+        assert((m_bits[index / 64] & (1ull << (index % 64))) == 0);
+        m_bits[index / 64] |= 1ull << (index % 64);
+        ++m_count;
+        return;
+    }
+
+    assert(m_indices.empty() || m_indices.back() < index);
+    m_indices.push_back(index);
+    ++m_count;
+
+    if (ShouldBeDense())
+    {
+        ConvertToDense();
+    }
+}
+
+uint32_t HitSet::GetCount() const
+{
+    return m_count;
+}
+
+uint32_t HitSet::GetUniverseSize() const
+{
+    return m_universeSize;
+}
+
+bool HitSet::IsEmpty() const
+{
+    return m_count == 0;
+}
+
+bool HitSet::IsDense() const
+{
+    return m_dense;
+}
+
+size_t HitSet::GetMemoryUsage() const
+{
+    return m_bits.capacity() * sizeof(uint64_t) + m_indices.capacity() * sizeof(uint32_t);
+}
+
+uint64_t* HitSet::GetDenseBits()
+{
+    assert(m_dense);
+    return m_bits.data();
+}
+
+size_t HitSet::GetNumDenseWords() const
+{
+    return m_bits.size();
+}
+
+void HitSet::SetDenseCount(uint32_t count)
+{
+    assert(m_dense);
+    m_count = count;
+
+    if (ShouldBeSparse())
+    {
+        ConvertToSparse();
+    }
+}
+
+void HitSet::ConvertToDense()
+{
+    assert(!m_dense);
+
+    m_bits.assign((m_universeSize + 63) / 64, 0);
+    for (const uint32_t Index : m_indices)
+    {
+        m_bits[Index / 64] |= 1ull << (Index % 64);
+    }
+
+    std::vector<uint32_t>().swap(m_indices);
+    m_dense = true;
+}
+
+void HitSet::ConvertToSparse()
+{
+    assert(m_dense);
+
+    std::vector<uint32_t> indices;
+    indices.reserve(m_count);
+    ForEach([&indices](uint32_t index) { indices.push_back(index); });
+    assert(indices.size() == m_count);
+
+    m_indices.swap(indices);
+    std::vector<uint64_t>().swap(m_bits);
+    m_dense = false;
+}
+
+void HitSet::ReleaseSparseSlack()
+{
+    assert(!m_dense);
+
+    if (m_indices.size() < m_indices.capacity() / 4)
+    {
+        std::vector<uint32_t>(m_indices).swap(m_indices);
+    }
+}
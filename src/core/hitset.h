@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "bitutils.h"
+
+//----------------------------------------------------------------------------
+// Set of scan hits, stored as element indices into the scanned region.
+//
+// Sparse sets are a sorted vector of indices, dense sets are a bitmap with
+// one bit per element of the region. The representation flips automatically
+// to whichever is smaller, so a set can hold every element of the region
+// without any cap. Either way iteration is always in ascending order.
+//----------------------------------------------------------------------------
+
+class HitSet
+{
+public:
+    // Empties the set and sizes it for element indices in [0, universeSize)
+    void Reset(uint32_t universeSize);
+
+    // Empties the set and releases its memory
+    void Clear();
+
+    // Adds every index in the universe
+    void AddAll();
+
+    // Indices must be appended in strictly ascending order
+    void Append(uint32_t index);
+
+    uint32_t GetCount() const;
+    uint32_t GetUniverseSize() const;
+    bool IsEmpty() const;
+    bool IsDense() const;
+    size_t GetMemoryUsage() const;
+
+    // Raw bitmap of a dense set, 64 elements per word, for vectorized filters.
+    // Callers that modify it must report the new population with
+    // SetDenseCount, which also picks the cheaper representation again.
+    uint64_t* GetDenseBits();
+    size_t GetNumDenseWords() const;
+    void SetDenseCount(uint32_t count);
+
+    // Calls callback(index) for every hit in ascending order
+    template<typename TCallback>
+    void ForEach(TCallback&& callback) const
+    {
+        if (m_dense)
+        {
+            for (size_t word = 0; word < m_bits.size(); ++word)
+            {
+                uint64_t bits = m_bits[word];
+                while (bits)
+                {
+                    callback(static_cast<uint32_t>(word * 64 + CountTrailingZeros64(bits)));
+                    bits &= bits - 1;
+                }
+            }
+        }
+        else
+        {
+            for (const uint32_t Index : m_indices)
+            {
+                callback(Index);
+            }
+        }
+    }
+
+    // Keeps only the hits for which keep(index) returns true
+    template<typename TPredicate>
+    void Filter(TPredicate&& keep)
+    {
+        if (m_dense)
+        {
+            uint32_t count = 0;
+            for (size_t word = 0; word < m_bits.size(); ++word)
+            {
+                uint64_t bits = m_bits[word];
+                uint64_t pending = bits;
+                while (pending)
+                {
+                    const uint32_t Bit = CountTrailingZeros64(pending);
+                    if (!keep(static_cast<uint32_t>(word * 64 + Bit)))
+                    {
+                        bits &= ~(1ull << Bit);
+                    }
+                    pending &= pending - 1;
+                }
+
+                m_bits[word] = bits;
+                count += PopCount64(bits);
+            }
+
+            SetDenseCount(count);
+        }
+        else
+        {
+            // Stable in-place compaction, survivors slide down over the failures without
+            // ever changing order, so the indices never need sorting again
+            size_t numKept = 0;
+            for (const uint32_t Index : m_indices)
+            {
+                if (keep(Index))
+                {
+                    m_indices[numKept++] = Index;
+                }
+            }
+
+            m_indices.resize(numKept);
+            m_count = static_cast<uint32_t>(numKept);
+            ReleaseSparseSlack();
+        }
+    }
+
+private:
+    // Bitmap once there's more than one hit per 32 elements, since that's where a
+    // 32-bit index per hit starts costing more than a bit per element. Going back
+    // to indices waits until half that density so the set doesn't flip-flop.
+    bool ShouldBeDense() const { return m_count > m_universeSize / 32; }
+    bool ShouldBeSparse() const { return m_count < m_universeSize / 64; }
+
+    void ConvertToDense();
+    void ConvertToSparse();
+
+    // Gives back most of the index storage once a refine has pruned the set well below it
+    void ReleaseSparseSlack();
+
+    std::vector<uint64_t> m_bits;
+    std::vector<uint32_t> m_indices;
+    uint32_t m_universeSize = 0;
+    uint32_t m_count = 0;
+    bool m_dense = false;
+};
@@ -0,0 +1,201 @@
+#if defined(__linux__)
+
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "linuxprocessmemorysource.h"
+
+namespace
+{
+    // The kernel rejects process_vm_readv calls with more iovecs than this
+    constexpr size_t kMaxIovecsPerCall = IOV_MAX;
+}
+
+LinuxProcessMemorySource::~LinuxProcessMemorySource()
+{
+    Detach();
+}
+
+bool LinuxProcessMemorySource::Attach(pid_t pid)
+{
+    Detach();
+
+    if (pid <= 0 || (kill(pid, 0) != 0 && errno != EPERM))
+    {
+        return false;
+    }
+
+    m_pid = pid;
+    return true;
+}
+
+void LinuxProcessMemorySource::Detach()
+{
+    if (m_memFd >= 0)
+    {
+        close(m_memFd);
+    }
+
+    m_pid = 0;
+    m_memFd = -1;
+    m_useVmReadv = true;
+}
+
+void LinuxProcessMemorySource::DisableVmReadv()
+{
+    m_useVmReadv = false;
+}
+
+bool LinuxProcessMemorySource::Read(uint64_t address, void* pBuffer, uint32_t size)
+{
+    ScatterReadEntry entry = { address, pBuffer, size, false };
+    return ReadScatter(&entry, 1);
+}
+
+bool LinuxProcessMemorySource::ReadScatter(ScatterReadEntry* pEntries, size_t numEntries)
+{
+    bool allSucceeded = true;
+    size_t next = 0;
+    while (next < numEntries)
+    {
+        const size_t Consumed = m_useVmReadv ? ReadBatch(pEntries + next, numEntries - next) : 0;
+        if (Consumed == 0)
+        {
+            ScatterReadEntry& entry = pEntries[next++];
+            entry.Succeeded = ReadWithPread(entry.Address, entry.pBuffer, entry.Size);
+            allSucceeded &= entry.Succeeded;
+            continue;
+        }
+
+        for (size_t i = next; i < next + Consumed; ++i)
+        {
+            allSucceeded &= pEntries[i].Succeeded;
+        }
+        next += Consumed;
+    }
+
+    return allSucceeded;
+}
+
+size_t LinuxProcessMemorySource::ReadBatch(ScatterReadEntry* pEntries, size_t numEntries)
+{
+    const size_t BatchSize = std::min(numEntries, kMaxIovecsPerCall);
+    std::vector<iovec> local(BatchSize);
+    std::vector<iovec> remote(BatchSize);
+    for (size_t i = 0; i < BatchSize; ++i)
+    {
+        local[i] = { pEntries[i].pBuffer, pEntries[i].Size };
+        remote[i] = { reinterpret_cast<void*>(static_cast<uintptr_t>(pEntries[i].Address)), pEntries[i].Size };
+        pEntries[i].Succeeded = false;
+    }
+
+    const ssize_t BytesRead = process_vm_readv(m_pid, local.data(), BatchSize, remote.data(), BatchSize, 0);
+    if (BytesRead < 0)
+    {
+        // EFAULT just means the first range wasn't readable, anything else means the call
+        // itself isn't available to us and every later read should go through pread
+        if (errno != EFAULT)
+        {
+            m_useVmReadv = false;
+        }
+        return 0;
+    }
+
+    // The kernel stops at the first remote range it can't read in full, so everything
+    // before that completed. The partial one is left for the fallback to retry alone.
+    size_t remaining = static_cast<size_t>(BytesRead);
+    size_t numCompleted = 0;
+    while (numCompleted < BatchSize && remaining >= pEntries[numCompleted].Size)
+    {
+        remaining -= pEntries[numCompleted].Size;
+        pEntries[numCompleted++].Succeeded = true;
+    }
+
+    return numCompleted;
+}
+
+bool LinuxProcessMemorySource::ReadWithPread(uint64_t address, void* pBuffer, uint32_t size)
+{
+    if (size == 0)
+    {
+        return true;
+    }
+
+    if (m_memFd < 0)
+    {
+        char path[64];
+        snprintf(path, sizeof(path), "/proc/%d/mem", static_cast<int>(m_pid));
+        m_memFd = open(path, O_RDONLY | O_CLOEXEC);
+        if (m_memFd < 0)
+        {
+            return false;
+        }
+    }
+
+    uint8_t* pOut = static_cast<uint8_t*>(pBuffer);
+    while (size > 0)
+    {
+        const ssize_t BytesRead = pread(m_memFd, pOut, size, static_cast<off_t>(address));
+        if (BytesRead <= 0)
+        {
+            if (BytesRead < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+
+        pOut += BytesRead;
+        address += static_cast<uint64_t>(BytesRead);
+        size -= static_cast<uint32_t>(BytesRead);
+    }
+
+    return true;
+}
+
+void LinuxProcessMemorySource::EnumerateRegions(std::vector<MemoryRegionInfo>& regionsOut)
+{
+    regionsOut.clear();
+
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/maps", static_cast<int>(m_pid));
+    FILE* pMaps = fopen(path, "r");
+    if (!pMaps)
+    {
+        return;
+    }
+
+    // Each line starts "start-end perms ...", only readable mappings are of interest
+    char line[512];
+    while (fgets(line, sizeof(line), pMaps))
+    {
+        uint64_t start;
+        uint64_t end;
+        char perms[5];
+        if (sscanf(line, "%" SCNx64 "-%" SCNx64 " %4s", &start, &end, perms) == 3 && perms[0] == 'r' && end > start)
+        {
+            regionsOut.push_back({ start, end - start });
+        }
+
+        // Skip the rest of lines with very long paths so they aren't mistaken for new entries
+        while (!strchr(line, '\n') && fgets(line, sizeof(line), pMaps))
+        {
+        }
+    }
+
+    fclose(pMaps);
+}
+
+#endif // __linux__
@@ -0,0 +1,57 @@
+#pragma once
+
+#if defined(__linux__)
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <sys/types.h>
+
+#include "memorysource.h"
+
+//----------------------------------------------------------------------------
+// Memory source reading a live process on Linux, for scanning native FBNeo
+// builds without a debugger attached.
+//
+// Reads go through process_vm_readv, with scatter reads packed into as few
+// vectored calls as possible. Where that isn't allowed (e.g. a kernel
+// without it, or a seccomp filter) reads fall back to pread on
+// /proc/<pid>/mem. Either way the caller needs ptrace access to the target.
+//----------------------------------------------------------------------------
+
+class LinuxProcessMemorySource : public IMemorySource
+{
+public:
+    LinuxProcessMemorySource() = default;
+    ~LinuxProcessMemorySource();
+
+    LinuxProcessMemorySource(const LinuxProcessMemorySource&) = delete;
+    LinuxProcessMemorySource& operator=(const LinuxProcessMemorySource&) = delete;
+
+    // Returns false if the process doesn't exist or can't be read at all
+    bool Attach(pid_t pid);
+    void Detach();
+
+    // Sends every read through /proc/<pid>/mem from now on, as if process_vm_readv had
+    // been refused, so the fallback can be exercised where the call works
+    void DisableVmReadv();
+
+    bool Read(uint64_t address, void* pBuffer, uint32_t size) override;
+    bool ReadScatter(ScatterReadEntry* pEntries, size_t numEntries) override;
+    void EnumerateRegions(std::vector<MemoryRegionInfo>& regionsOut) override;
+
+private:
+    // Reads as many of the entries as fit in one process_vm_readv, marking the ones that
+    // completed. Returns how many entries were consumed, 0 if the call couldn't be made.
+    size_t ReadBatch(ScatterReadEntry* pEntries, size_t numEntries);
+    bool ReadWithPread(uint64_t address, void* pBuffer, uint32_t size);
+
+    pid_t m_pid = 0;
+
+    // /proc/<pid>/mem, opened the first time process_vm_readv can't be used
+    int m_memFd = -1;
+    bool m_useVmReadv = true;
+};
+
+#endif // __linux__
@@ -0,0 +1,72 @@
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "m68kmemorymap.h"
+
+void M68KMemoryMap::Load(const uint8_t* pRawEntries, uint32_t pointerSize)
+{
+    assert(pointerSize == 4 || pointerSize == 8);
+
+    m_entries.resize(kNumEntries);
+    if (pointerSize == sizeof(uint64_t))
+    {
+        memcpy(m_entries.data(), pRawEntries, kNumEntries * sizeof(uint64_t));
+        return;
+    }
+
+    for (size_t i = 0; i < kNumEntries; ++i)
+    {
+        uint32_t entry;
+        memcpy(&entry, pRawEntries + i * sizeof(uint32_t), sizeof(uint32_t));
+        m_entries[i] = entry;
+    }
+}
+
+void M68KMemoryMap::Invalidate()
+{
+    std::vector<uint64_t>().swap(m_entries);
+}
+
+bool M68KMemoryMap::IsLoaded() const
+{
+    return !m_entries.empty();
+}
+
+void M68KMemoryMap::SplitIntoHostRuns(uint32_t address, uint32_t size, M68KAccess access, std::vector<M68KHostRun>& runsOut) const
+{
+    assert(address <= kM68KAddressMask && size <= kM68KAddressMask + 1 - address);
+
+    runsOut.clear();
+
+    uint32_t current = address;
+    const uint32_t End = address + size;
+    while (current != End)
+    {
+        const uint32_t ChunkSize = std::min(GetBytesLeftInPage(current), End - current);
+        const M68KTranslation Translation = Translate(current, access);
+
+        if (!runsOut.empty())
+        {
+            M68KHostRun& previous = runsOut.back();
+            const bool BothMemory =
+                previous.Translation.Kind == M68KPageKind::Memory && Translation.Kind == M68KPageKind::Memory;
+            const bool Contiguous = BothMemory
+                ? previous.Translation.HostAddress + previous.Size == Translation.HostAddress
+                : previous.Translation.Kind == Translation.Kind && previous.Translation.HandlerIndex == Translation.HandlerIndex;
+
+            if (Contiguous)
+            {
+                previous.Size += ChunkSize;
+                current += ChunkSize;
+                continue;
+            }
+        }
+
+        runsOut.push_back({ current, ChunkSize, Translation });
+        current += ChunkSize;
+    }
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//----------------------------------------------------------------------------
+// Constants yoinked from FBNeo's sek.h.
+//----------------------------------------------------------------------------
+constexpr unsigned int SEK_BITS = 24;
+constexpr unsigned int SEK_SHIFT = 10;
+constexpr unsigned int SEK_PAGE_SIZE = (1 << SEK_SHIFT);
+constexpr unsigned int SEK_PAGE_MASK = SEK_PAGE_SIZE - 1;
+constexpr unsigned int SEK_PAGE_COUNT = (1 << (SEK_BITS - SEK_SHIFT));
+constexpr unsigned int SEK_WADD = SEK_PAGE_COUNT;
+constexpr unsigned int SEK_MAXHANDLER = 10;
+
+// 68000 addresses are 24 bits wide, FBNeo masks off the rest before every access
+constexpr uint32_t kM68KAddressMask = (1u << SEK_BITS) - 1;
+
+//----------------------------------------------------------------------------
+// Local copy of pSekExt->MemMap, the page table FBNeo uses to find the host
+// memory behind each 1KB page of 68K address space.
+//
+// The table holds SEK_PAGE_COUNT entries each for reads, writes and opcode
+// fetches. An entry is either a host pointer biased so that adding the low
+// address bits gives the byte, or a handler index below SEK_MAXHANDLER.
+// Handler 0 is the default one FBNeo installs for pages nothing mapped.
+//----------------------------------------------------------------------------
+
+enum class M68KAccess
+{
+    Read,
+    Write,
+    Fetch,
+};
+
+enum class M68KPageKind
+{
+    Memory,
+    Handler,
+    Unmapped,
+};
+
+struct M68KTranslation
+{
+    M68KPageKind Kind;
+
+    // Valid for M68KPageKind::Memory
+    uint64_t HostAddress;
+
+    // Valid for M68KPageKind::Handler
+    uint32_t HandlerIndex;
+};
+
+// A stretch of 68K address space that either maps onto one contiguous block
+// of host memory or lies entirely on pages that don't
+struct M68KHostRun
+{
+    uint32_t M68KAddress;
+    uint32_t Size;
+
+    // Translation of M68KAddress, which for memory runs is where the block starts
+    M68KTranslation Translation;
+};
+
+class M68KMemoryMap
+{
+public:
+    static constexpr size_t kNumEntries = SEK_PAGE_COUNT * 3;
+
+    // Takes entries as read from the target, pointerSize bytes each (4 or 8)
+    void Load(const uint8_t* pRawEntries, uint32_t pointerSize);
+    void Invalidate();
+    bool IsLoaded() const;
+
+    // Translates an address exactly as FBNeo would for this kind of access. Byte accesses
+    // should pass the address ^ 1, matching the word swap FBNeo's ReadByte() applies.
+    M68KTranslation Translate(uint32_t address, M68KAccess access = M68KAccess::Read) const
+    {
+        assert(IsLoaded());
+
+        const uint32_t Masked = address & kM68KAddressMask;
+        const uint64_t Entry = m_entries[static_cast<uint32_t>(access) * SEK_WADD + (Masked >> SEK_SHIFT)];
+
+        M68KTranslation translation = {};
+        if (Entry >= SEK_MAXHANDLER)
+        {
+            translation.Kind = M68KPageKind::Memory;
+            translation.HostAddress = Entry + (Masked & SEK_PAGE_MASK);
+        }
+        else
+        {
+            translation.Kind = Entry == 0 ? M68KPageKind::Unmapped : M68KPageKind::Handler;
+            translation.HandlerIndex = static_cast<uint32_t>(Entry);
+        }
+
+        return translation;
+    }
+
+    // Splits [address, address + size) into runs, merging neighbouring pages FBNeo mapped
+    // onto adjacent host memory, so each memory run can be fetched with a single read.
+    // The range must not run past the end of the 24-bit address space.
+    void SplitIntoHostRuns(uint32_t address, uint32_t size, M68KAccess access, std::vector<M68KHostRun>& runsOut) const;
+
+    // Number of bytes from address to the end of its page, i.e. how far a
+    // single host read can go before the next page needs translating
+    static uint32_t GetBytesLeftInPage(uint32_t address)
+    {
+        return SEK_PAGE_SIZE - (address & SEK_PAGE_MASK);
+    }
+
+private:
+    std::vector<uint64_t> m_entries;
+};
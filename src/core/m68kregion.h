@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+//----------------------------------------------------------------------------
+// A block of 68K address space backed by one contiguous host allocation in
+// FBNeo. Scan results are kept relative to one of these instead of as host
+// pointers, so they survive the emulator being restarted; commands look the
+// host base up again each time they run.
+//----------------------------------------------------------------------------
+
+struct M68KRegion
+{
+    const char* pName;
+    uint32_t M68KBase;
+    uint32_t Size;
+
+    bool operator==(const M68KRegion& other) const
+    {
+        return M68KBase == other.M68KBase && Size == other.Size;
+    }
+    bool operator!=(const M68KRegion& other) const
+    {
+        return !(*this == other);
+    }
+};
+
+// Work RAM, as resolved through fbneo64d_vs!Neo68KRAM
+constexpr M68KRegion kNeoGeoWorkRam = { "Work RAM", 0x100000, 0x20000 };
+
+//----------------------------------------------------------------------------
+// Values as the 68K sees them, out of a region's host copy.
+//
+// FBNeo keeps 68K memory as host-endian words, so on the little-endian hosts
+// it runs on, the byte at 68K offset N lives at host offset N ^ 1. Aligned
+// words read straight out of the host, longs have their two words the other
+// way around, and values at odd addresses straddle words.
+//----------------------------------------------------------------------------
+
+// Assembles the value at 68K offset offset big-endian, the way the 68K reads it
+template<typename TValue>
+inline TValue ReadM68KValue(const uint8_t* pHost, uint32_t offset)
+{
+    uint32_t value = 0;
+    if (sizeof(TValue) > 1 && (offset & 1) == 0)
+    {
+        // Whole host words, high word first
+        for (uint32_t i = 0; i < sizeof(TValue); i += 2)
+        {
+            uint16_t word;
+            memcpy(&word, pHost + offset + i, sizeof(word));
+            value = (value << 16) | word;
+        }
+    }
+    else
+    {
+        for (uint32_t i = 0; i < sizeof(TValue); ++i)
+        {
+            value = (value << 8) | pHost[(offset + i) ^ 1];
+        }
+    }
+
+    return static_cast<TValue>(value);
+}
+
+// Copies size bytes from 68K offset offset out of the host copy, in 68K order
+inline void CopyM68KBytes(const uint8_t* pHost, uint32_t offset, uint32_t size, uint8_t* pBytesOut)
+{
+    for (uint32_t i = 0; i < size; ++i)
+    {
+        pBytesOut[i] = pHost[(offset + i) ^ 1];
+    }
+}
@@ -0,0 +1,95 @@
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <cstddef>
+#include <cstdint>
+
+#include "mappedfile.h"
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+bool MappedFile::Open(const char* pPath)
+{
+    Close();
+
+#if defined(_WIN32)
+    HANDLE File = CreateFileA(pPath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (File == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    HANDLE Mapping = nullptr;
+    if (GetFileSizeEx(File, &fileSize) && fileSize.QuadPart > 0)
+    {
+        Mapping = CreateFileMappingA(File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    }
+    CloseHandle(File);
+    if (!Mapping)
+    {
+        return false;
+    }
+
+    // The view keeps the mapping alive on its own
+    const void* pView = MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(Mapping);
+    if (!pView)
+    {
+        return false;
+    }
+
+    m_pData = static_cast<const uint8_t*>(pView);
+    m_size = static_cast<size_t>(fileSize.QuadPart);
+#else
+    const int File = open(pPath, O_RDONLY);
+    if (File < 0)
+    {
+        return false;
+    }
+
+    struct stat fileInfo;
+    void* pView = MAP_FAILED;
+    if (fstat(File, &fileInfo) == 0 && fileInfo.st_size > 0)
+    {
+        pView = mmap(nullptr, static_cast<size_t>(fileInfo.st_size), PROT_READ, MAP_PRIVATE, File, 0);
+    }
+
+    // The mapping keeps the file alive on its own
+    close(File);
+    if (pView == MAP_FAILED)
+    {
+        return false;
+    }
+
+    m_pData = static_cast<const uint8_t*>(pView);
+    m_size = static_cast<size_t>(fileInfo.st_size);
+#endif
+
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (!m_pData)
+    {
+        return;
+    }
+
+#if defined(_WIN32)
+    UnmapViewOfFile(m_pData);
+#else
+    munmap(const_cast<uint8_t*>(m_pData), m_size);
+#endif
+
+    m_pData = nullptr;
+    m_size = 0;
+}
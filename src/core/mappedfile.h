@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+//----------------------------------------------------------------------------
+// Read-only memory mapping of a whole file.
+//----------------------------------------------------------------------------
+
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Closes any file already open first
+    bool Open(const char* pPath);
+    void Close();
+
+    const uint8_t* GetData() const { return m_pData; }
+    size_t GetSize() const { return m_size; }
+
+private:
+    const uint8_t* m_pData = nullptr;
+    size_t m_size = 0;
+};
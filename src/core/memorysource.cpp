@@ -0,0 +1,22 @@
+#include <cstddef>
+#include <cstdint>
+
+#include "memorysource.h"
+
+bool IMemorySource::ReadScatter(ScatterReadEntry* pEntries, size_t numEntries)
+{
+    bool allSucceeded = true;
+    for (size_t i = 0; i < numEntries; ++i)
+    {
+        ScatterReadEntry& entry = pEntries[i];
+        entry.Succeeded = Read(entry.Address, entry.pBuffer, entry.Size);
+        allSucceeded &= entry.Succeeded;
+    }
+
+    return allSucceeded;
+}
+
+const uint8_t* IMemorySource::GetDirectPointer(uint64_t, uint32_t)
+{
+    return nullptr;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//----------------------------------------------------------------------------
+// Somewhere target memory can be read from. The scan engine only reads
+// memory through this, so it runs the same whether the bytes come from a
+// live debugging session or a local buffer.
+//----------------------------------------------------------------------------
+
+struct MemoryRegionInfo
+{
+    uint64_t Address;
+    uint64_t Size;
+};
+
+// One read of a scatter batch. Succeeded is filled in by the read.
+struct ScatterReadEntry
+{
+    uint64_t Address;
+    void* pBuffer;
+    uint32_t Size;
+    bool Succeeded;
+};
+
+class IMemorySource
+{
+public:
+    virtual ~IMemorySource() = default;
+
+    // Returns false unless all size bytes could be read
+    virtual bool Read(uint64_t address, void* pBuffer, uint32_t size) = 0;
+
+    // Performs every read of the batch, even after one fails. Returns false if any
+    // of them did. The default issues one Read per entry, sources that can batch
+    // requests to the target should do better.
+    virtual bool ReadScatter(ScatterReadEntry* pEntries, size_t numEntries);
+
+    // Readable regions of the address space in ascending address order
+    virtual void EnumerateRegions(std::vector<MemoryRegionInfo>& regionsOut) = 0;
+
+    // Sources that already hold memory locally (e.g. a mapped file) can hand out
+    // size bytes at address in place, which lets callers skip copying them. Null
+    // when the source can't, in which case the caller falls back to Read.
+    virtual const uint8_t* GetDirectPointer(uint64_t address, uint32_t size);
+};
@@ -0,0 +1,431 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "memorytrace.h"
+
+namespace
+{
+    constexpr char kTraceMagic[8] = { 'B', 'D', 'T', 'R', 'A', 'C', 'E', '1' };
+
+    // fopen is deprecated under /sdl in favour of fopen_s, which nothing else has
+    FILE* OpenFile(const char* pPath, const char* pMode)
+    {
+#if defined(_MSC_VER)
+        FILE* pFile = nullptr;
+        return fopen_s(&pFile, pPath, pMode) == 0 ? pFile : nullptr;
+#else
+        return fopen(pPath, pMode);
+#endif
+    }
+
+    // Walks a loaded trace file, failing every read once one runs off the end
+    class TraceReader
+    {
+    public:
+        TraceReader(const uint8_t* pData, size_t size)
+            : m_pData(pData)
+            , m_size(size)
+        {
+        }
+
+        bool AtEnd() const
+        {
+            return m_offset == m_size;
+        }
+
+        bool Bytes(size_t size, const uint8_t** ppBytesOut)
+        {
+            if (size > m_size - m_offset)
+            {
+                return false;
+            }
+
+            *ppBytesOut = m_pData + m_offset;
+            m_offset += size;
+            return true;
+        }
+
+        bool U8(uint8_t* pValueOut)
+        {
+            const uint8_t* pBytes;
+            if (!Bytes(1, &pBytes))
+            {
+                return false;
+            }
+
+            *pValueOut = pBytes[0];
+            return true;
+        }
+
+        bool U32(uint32_t* pValueOut)
+        {
+            const uint8_t* pBytes;
+            if (!Bytes(4, &pBytes))
+            {
+                return false;
+            }
+
+            *pValueOut = 0;
+            for (int i = 3; i >= 0; --i)
+            {
+                *pValueOut = (*pValueOut << 8) | pBytes[i];
+            }
+            return true;
+        }
+
+        bool U64(uint64_t* pValueOut)
+        {
+            uint32_t low;
+            uint32_t high;
+            if (!U32(&low) || !U32(&high))
+            {
+                return false;
+            }
+
+            *pValueOut = (static_cast<uint64_t>(high) << 32) | low;
+            return true;
+        }
+
+        bool Bool(bool* pValueOut)
+        {
+            uint8_t value;
+            if (!U8(&value))
+            {
+                return false;
+            }
+
+            *pValueOut = value != 0;
+            return true;
+        }
+
+        bool String(std::string& stringOut)
+        {
+            uint32_t length;
+            const uint8_t* pBytes;
+            if (!U32(&length) || !Bytes(length, &pBytes))
+            {
+                return false;
+            }
+
+            stringOut.assign(reinterpret_cast<const char*>(pBytes), length);
+            return true;
+        }
+
+    private:
+        const uint8_t* m_pData;
+        size_t m_size;
+        size_t m_offset = 0;
+    };
+}
+
+//----------------------------------------------------------------------------
+//
+// TraceWriter
+//
+//----------------------------------------------------------------------------
+
+TraceWriter::~TraceWriter()
+{
+    Close();
+}
+
+bool TraceWriter::Open(const char* pPath, uint32_t pointerSize)
+{
+    Close();
+
+    m_pFile = OpenFile(pPath, "wb");
+    if (!m_pFile)
+    {
+        return false;
+    }
+
+    m_failed = false;
+    m_numBytesWritten = 0;
+    WriteBytes(kTraceMagic, sizeof(kTraceMagic));
+    WriteU32(pointerSize);
+    return !m_failed;
+}
+
+bool TraceWriter::Close()
+{
+    if (!m_pFile)
+    {
+        return true;
+    }
+
+    m_failed |= fclose(m_pFile) != 0;
+    m_pFile = nullptr;
+    return !m_failed;
+}
+
+bool TraceWriter::IsOpen() const
+{
+    return m_pFile != nullptr;
+}
+
+void TraceWriter::WriteCommand(const char* pName, const char* pArgs)
+{
+    WriteKind(TraceEventKind::Command);
+    WriteString(pName);
+    WriteString(pArgs ? pArgs : "");
+}
+
+void TraceWriter::WriteTargetRan()
+{
+    WriteKind(TraceEventKind::TargetRan);
+}
+
+void TraceWriter::WriteRead(uint64_t address, const void* pData, uint32_t size, bool succeeded)
+{
+    WriteKind(TraceEventKind::Read);
+    WriteU64(address);
+    WriteU32(size);
+    WriteU8(succeeded ? 1 : 0);
+    if (succeeded)
+    {
+        WriteBytes(pData, size);
+    }
+}
+
+void TraceWriter::WriteScatterBatch(size_t numReads)
+{
+    WriteKind(TraceEventKind::ScatterBatch);
+    WriteU32(static_cast<uint32_t>(numReads));
+}
+
+void TraceWriter::WriteRegions(const std::vector<MemoryRegionInfo>& regions)
+{
+    WriteKind(TraceEventKind::Regions);
+    WriteU32(static_cast<uint32_t>(regions.size()));
+    for (const MemoryRegionInfo& Region : regions)
+    {
+        WriteU64(Region.Address);
+        WriteU64(Region.Size);
+    }
+}
+
+void TraceWriter::WriteModuleBase(const char* pModule, bool found, uint64_t base)
+{
+    WriteKind(TraceEventKind::ModuleBase);
+    WriteString(pModule);
+    WriteU8(found ? 1 : 0);
+    WriteU64(found ? base : 0);
+}
+
+void TraceWriter::WriteSymbolAddress(const char* pSymbol, bool found, uint64_t address)
+{
+    WriteKind(TraceEventKind::SymbolAddress);
+    WriteString(pSymbol);
+    WriteU8(found ? 1 : 0);
+    WriteU64(found ? address : 0);
+}
+
+void TraceWriter::WriteFieldOffset(const char* pModule, const char* pType, const char* pField, bool found, uint32_t offset)
+{
+    const std::string Key = std::string(pModule) + "!" + pType + "." + pField;
+    WriteKind(TraceEventKind::FieldOffset);
+    WriteString(Key.c_str());
+    WriteU8(found ? 1 : 0);
+    WriteU32(found ? offset : 0);
+}
+
+uint64_t TraceWriter::GetNumBytesWritten() const
+{
+    return m_numBytesWritten;
+}
+
+void TraceWriter::WriteBytes(const void* pData, size_t size)
+{
+    if (!m_pFile || m_failed || size == 0)
+    {
+        return;
+    }
+
+    m_failed = fwrite(pData, 1, size, m_pFile) != size;
+    m_numBytesWritten += size;
+}
+
+void TraceWriter::WriteKind(TraceEventKind kind)
+{
+    WriteU8(static_cast<uint8_t>(kind));
+}
+
+void TraceWriter::WriteU8(uint8_t value)
+{
+    WriteBytes(&value, sizeof(value));
+}
+
+void TraceWriter::WriteU32(uint32_t value)
+{
+    uint8_t bytes[4];
+    for (int i = 0; i < 4; ++i)
+    {
+        bytes[i] = static_cast<uint8_t>(value >> (i * 8));
+    }
+    WriteBytes(bytes, sizeof(bytes));
+}
+
+void TraceWriter::WriteU64(uint64_t value)
+{
+    WriteU32(static_cast<uint32_t>(value));
+    WriteU32(static_cast<uint32_t>(value >> 32));
+}
+
+void TraceWriter::WriteString(const char* pString)
+{
+    const size_t Length = strlen(pString);
+    WriteU32(static_cast<uint32_t>(Length));
+    WriteBytes(pString, Length);
+}
+
+//----------------------------------------------------------------------------
+//
+// MemoryTrace
+//
+//----------------------------------------------------------------------------
+
+bool MemoryTrace::Load(const char* pPath)
+{
+    m_pointerSize = 0;
+    m_events.clear();
+    m_data.clear();
+    m_regions.clear();
+
+    FILE* pFile = OpenFile(pPath, "rb");
+    if (!pFile)
+    {
+        return false;
+    }
+
+    std::vector<uint8_t> contents;
+    uint8_t chunk[0x10000];
+    size_t chunkSize;
+    while ((chunkSize = fread(chunk, 1, sizeof(chunk), pFile)) != 0)
+    {
+        contents.insert(contents.end(), chunk, chunk + chunkSize);
+    }
+    const bool ReadFailed = ferror(pFile) != 0;
+    fclose(pFile);
+    if (ReadFailed)
+    {
+        return false;
+    }
+
+    TraceReader reader(contents.data(), contents.size());
+    const uint8_t* pMagic;
+    if (!reader.Bytes(sizeof(kTraceMagic), &pMagic) ||
+        memcmp(pMagic, kTraceMagic, sizeof(kTraceMagic)) != 0 ||
+        !reader.U32(&m_pointerSize) ||
+        (m_pointerSize != 4 && m_pointerSize != 8))
+    {
+        return false;
+    }
+
+    uint32_t batchReadsLeft = 0;
+    while (!reader.AtEnd())
+    {
+        TraceEvent event;
+        uint8_t kind;
+        if (!reader.U8(&kind))
+        {
+            return false;
+        }
+        event.Kind = static_cast<TraceEventKind>(kind);
+
+        bool valid;
+        switch (event.Kind)
+        {
+        case TraceEventKind::Command:
+            valid = reader.String(event.Name) && reader.String(event.Args);
+            break;
+
+        case TraceEventKind::TargetRan:
+            valid = true;
+            break;
+
+        case TraceEventKind::Read:
+        {
+            valid = reader.U64(&event.Address) && reader.U32(&event.Size) && reader.Bool(&event.Succeeded);
+            const uint8_t* pBytes;
+            if (valid && event.Succeeded)
+            {
+                valid = reader.Bytes(event.Size, &pBytes);
+                if (valid)
+                {
+                    event.DataOffset = m_data.size();
+                    m_data.insert(m_data.end(), pBytes, pBytes + event.Size);
+                }
+            }
+            if (batchReadsLeft)
+            {
+                event.InBatch = true;
+                --batchReadsLeft;
+            }
+            break;
+        }
+
+        case TraceEventKind::ScatterBatch:
+            valid = reader.U32(&event.Size);
+            batchReadsLeft = event.Size;
+            break;
+
+        case TraceEventKind::Regions:
+            valid = reader.U32(&event.Size);
+            event.DataOffset = m_regions.size();
+            for (uint32_t i = 0; valid && i < event.Size; ++i)
+            {
+                MemoryRegionInfo region;
+                valid = reader.U64(&region.Address) && reader.U64(&region.Size);
+                m_regions.push_back(region);
+            }
+            break;
+
+        case TraceEventKind::ModuleBase:
+        case TraceEventKind::SymbolAddress:
+            valid = reader.String(event.Name) && reader.Bool(&event.Succeeded) && reader.U64(&event.Address);
+            break;
+
+        case TraceEventKind::FieldOffset:
+            valid = reader.String(event.Name) && reader.Bool(&event.Succeeded) && reader.U32(&event.Size);
+            break;
+
+        default:
+            valid = false;
+            break;
+        }
+
+        if (!valid)
+        {
+            return false;
+        }
+
+        m_events.push_back(std::move(event));
+    }
+
+    return true;
+}
+
+uint32_t MemoryTrace::GetPointerSize() const
+{
+    return m_pointerSize;
+}
+
+const std::vector<TraceEvent>& MemoryTrace::GetEvents() const
+{
+    return m_events;
+}
+
+const uint8_t* MemoryTrace::GetReadData(const TraceEvent& read) const
+{
+    return m_data.data() + read.DataOffset;
+}
+
+const MemoryRegionInfo* MemoryTrace::GetRegions(const TraceEvent& regions) const
+{
+    return m_regions.data() + regions.DataOffset;
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "memorysource.h"
+
+//----------------------------------------------------------------------------
+// Traces of everything commands asked of the target: memory reads with the
+// bytes that came back, symbol lookups with their answers, and markers for
+// each command and for each time the target ran in between.
+//
+// A trace is enough to run the same commands again without the target, and
+// the recorded reads say how many round trips each command originally took.
+//
+// The file is a header followed by a stream of events, all little-endian:
+//   "BDTRACE1" u32 pointerSize
+//   u8 kind, then per kind:
+//     Command        str name, str args
+//     TargetRan      -
+//     Read           u64 address, u32 size, u8 succeeded, size bytes if succeeded
+//     ScatterBatch   u32 numReads; the next numReads Read events are its entries
+//     Regions        u32 count, count * (u64 address, u64 size)
+//     ModuleBase     str module, u8 found, u64 base
+//     SymbolAddress  str symbol, u8 found, u64 address
+//     FieldOffset    str "module!type.field", u8 found, u32 offset
+//   with str being u32 length followed by that many characters.
+//----------------------------------------------------------------------------
+
+enum class TraceEventKind : uint8_t
+{
+    Command,
+    TargetRan,
+    Read,
+    ScatterBatch,
+    Regions,
+    ModuleBase,
+    SymbolAddress,
+    FieldOffset,
+};
+
+class TraceWriter
+{
+public:
+    TraceWriter() = default;
+    TraceWriter(const TraceWriter&) = delete;
+    TraceWriter& operator=(const TraceWriter&) = delete;
+    ~TraceWriter();
+
+    // Creates or overwrites pPath. Returns false if it can't be written.
+    bool Open(const char* pPath, uint32_t pointerSize);
+    // Returns false if any of the trace failed to make it to disk
+    bool Close();
+    bool IsOpen() const;
+
+    void WriteCommand(const char* pName, const char* pArgs);
+    void WriteTargetRan();
+    void WriteRead(uint64_t address, const void* pData, uint32_t size, bool succeeded);
+    void WriteScatterBatch(size_t numReads);
+    void WriteRegions(const std::vector<MemoryRegionInfo>& regions);
+    void WriteModuleBase(const char* pModule, bool found, uint64_t base);
+    void WriteSymbolAddress(const char* pSymbol, bool found, uint64_t address);
+    void WriteFieldOffset(const char* pModule, const char* pType, const char* pField, bool found, uint32_t offset);
+
+    uint64_t GetNumBytesWritten() const;
+
+private:
+    void WriteBytes(const void* pData, size_t size);
+    void WriteKind(TraceEventKind kind);
+    void WriteU8(uint8_t value);
+    void WriteU32(uint32_t value);
+    void WriteU64(uint64_t value);
+    void WriteString(const char* pString);
+
+    FILE* m_pFile = nullptr;
+    bool m_failed = false;
+    uint64_t m_numBytesWritten = 0;
+};
+
+// One event of a loaded trace. Which fields mean something depends on the kind.
+struct TraceEvent
+{
+    TraceEventKind Kind;
+
+    // Command: name. ModuleBase: module. SymbolAddress: symbol. FieldOffset: "module!type.field".
+    std::string Name;
+    // Command: raw arguments
+    std::string Args;
+
+    // Read: address. ModuleBase, SymbolAddress: the answer.
+    uint64_t Address = 0;
+    // Read: size. ScatterBatch: number of reads. Regions: number of regions. FieldOffset: the answer.
+    uint32_t Size = 0;
+    // Read: whether it succeeded. Lookups: whether there was an answer.
+    bool Succeeded = false;
+    // Read: set for the entries of a scatter batch
+    bool InBatch = false;
+    // Read: offset of the bytes read in the trace's data. Regions: index of the first region.
+    size_t DataOffset = 0;
+};
+
+class MemoryTrace
+{
+public:
+    // Replaces the contents with the trace in pPath. Returns false if it can't be read or is malformed.
+    bool Load(const char* pPath);
+
+    uint32_t GetPointerSize() const;
+    const std::vector<TraceEvent>& GetEvents() const;
+
+    // Bytes of a successful Read event
+    const uint8_t* GetReadData(const TraceEvent& read) const;
+    // Regions of a Regions event
+    const MemoryRegionInfo* GetRegions(const TraceEvent& regions) const;
+
+private:
+    uint32_t m_pointerSize = 0;
+    std::vector<TraceEvent> m_events;
+    std::vector<uint8_t> m_data;
+    std::vector<MemoryRegionInfo> m_regions;
+};
@@ -0,0 +1,587 @@
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "bcd.h"
+#include "memscanslot.h"
+#include "readplanner.h"
+#include "scankernels.h"
+
+namespace 
+{
+    // The kernels report hits in batches of this many indices
+    constexpr size_t kHitBatchSize = 0x1000;
+
+    std::atomic<uint64_t> s_numScanPasses{ 0 };
+    std::atomic<uint64_t> s_bytesScanned{ 0 };
+    std::atomic<uint64_t> s_scanNanoseconds{ 0 };
+
+    // Adds the lifetime of one filtering pass over numBytes of values to the scan stats
+    class ScanPassTimer
+    {
+    public:
+        explicit ScanPassTimer(uint64_t numBytes)
+            : m_numBytes(numBytes)
+            , m_start(std::chrono::steady_clock::now())
+        {
+        }
+
+        ~ScanPassTimer()
+        {
+            const auto Elapsed = std::chrono::steady_clock::now() - m_start;
+            s_numScanPasses.fetch_add(1, std::memory_order_relaxed);
+            s_bytesScanned.fetch_add(m_numBytes, std::memory_order_relaxed);
+            s_scanNanoseconds.fetch_add(
+                static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Elapsed).count()),
+                std::memory_order_relaxed);
+        }
+
+    private:
+        uint64_t m_numBytes;
+        std::chrono::steady_clock::time_point m_start;
+    };
+
+    // Distance in 68K bytes between the elements of a scan
+    uint32_t GetElementStride(uint8_t valueSize, ScanAlignment alignment)
+    {
+        return valueSize == 1 || alignment == ScanAlignment::Any ? 1 : 2;
+    }
+
+    // Bytes are numbered by host offset, everything else by 68K offset over the stride
+    uint32_t GetElementM68KOffset(uint32_t index, uint8_t valueSize, ScanAlignment alignment)
+    {
+        return valueSize == 1 ? index ^ 1 : index * GetElementStride(valueSize, alignment);
+    }
+
+    template<typename TScanType>
+    TScanType ReadElementValue(const uint8_t* pHost, uint32_t m68kOffset, uint8_t valueSize, ScanEncoding encoding)
+    {
+        return encoding == ScanEncoding::Bcd
+            ? static_cast<TScanType>(ReadM68KBcd(pHost, m68kOffset, valueSize))
+            : ReadM68KValue<TScanType>(pHost, m68kOffset);
+    }
+
+    // The kernels take one value per element, as the 68K sees it. Bytes, numbered by host
+    // offset, and aligned words are laid out that way in the host copy already. Longs,
+    // values at odd addresses and BCD are decoded into valuesOut first, in one linear pass,
+    // so the kernels' inner loops stay plain vector operations for every predicate.
+    template<typename TScanType>
+    const TScanType* GetElementValues(const uint8_t* pHost, size_t numElements, uint8_t valueSize, ScanAlignment alignment,
+        ScanEncoding encoding, std::vector<TScanType>& valuesOut)
+    {
+        if (encoding == ScanEncoding::Binary &&
+            (sizeof(TScanType) == 1 || (sizeof(TScanType) == 2 && alignment == ScanAlignment::Even)))
+        {
+            return reinterpret_cast<const TScanType*>(pHost);
+        }
+
+        valuesOut.resize(numElements);
+        for (size_t i = 0; i < numElements; ++i)
+        {
+            const uint32_t Offset = GetElementM68KOffset(static_cast<uint32_t>(i), valueSize, alignment);
+            valuesOut[i] = ReadElementValue<TScanType>(pHost, Offset, valueSize, encoding);
+        }
+
+        return valuesOut.data();
+    }
+
+    // Values already known to fit in TScanType
+    template<typename TScanType>
+    ScanOperand<TScanType> NarrowOperand(const uint32_t* pValues, uint32_t numValues)
+    {
+        TScanType narrowed[kMaxScanOperandValues];
+        for (uint32_t i = 0; i < kMaxScanOperandValues; ++i)
+        {
+            narrowed[i] = static_cast<TScanType>(pValues[i]);
+        }
+
+        return MakeScanOperand(narrowed, numValues);
+    }
+
+    // Clears the candidates whose decoded BCD values are kInvalidBcd. Returns the number left.
+    template<typename TScanType>
+    size_t DropInvalidBcd(const TScanType* pValues, size_t numElements, uint8_t valueSize, uint64_t* pCandidateBits)
+    {
+        const TScanType ValidRange[] = { 0, static_cast<TScanType>(GetMaxBcdValue(valueSize)) };
+        return ScanKernels::FilterCandidates(nullptr, pValues, numElements, ScanPredicate::InRange,
+            MakeScanOperand(ValidRange, 2), pCandidateBits);
+    }
+}
+
+MemScanSlot::MemScanSlot()
+{
+    Clear();
+}
+
+void MemScanSlot::Clear()
+{
+    m_slotSize = 0;
+    m_alignment = ScanAlignment::Even;
+    m_encoding = ScanEncoding::Binary;
+    m_hits.Clear();
+
+    // Swap rather than clear so the slot actually lets go of the memory
+    m_region = {};
+    std::vector<uint8_t>().swap(m_snapshot);
+}
+
+template<typename TScanType>
+bool MemScanSlot::Scan(IMemorySource& memory, const M68KRegion& region, uint64_t hostBase, const ScanOperand<TScanType>& operand,
+    ScanPredicate predicate, ScanAlignment alignment, uint8_t valueSize, ScanEncoding encoding)
+{
+    assert((hostBase & 1) == 0);
+    assert(valueSize <= sizeof(TScanType));
+
+    // Bytes are at every address whatever the alignment
+    if (valueSize == 1)
+    {
+        alignment = ScanAlignment::Even;
+    }
+
+    if (m_slotSize != 0 && (m_slotSize != valueSize || m_alignment != alignment || m_encoding != encoding))
+    {
+        // The search must match the current slot size, alignment and encoding, or the slot must be cleared. Otherwise, bail.
+        return false;
+    }
+
+    if (PredicateUsesSnapshot(predicate) && IsClear())
+    {
+        // Nothing to compare against yet
+        return false;
+    }
+
+    if (!IsClear() && region != m_region)
+    {
+        // Hits are offsets into the region they were found in, so they can't be carried over to another
+        return false;
+    }
+
+    if (!m_hits.IsEmpty())
+    {
+        // If there are any preexisting hits, we'll search within those results and ignore the start/end range.
+        // Valid hits are hits which have met all search criteria seen by this slot between clears.
+        const bool Refined = m_hits.IsDense()
+            ? RefineDense(memory, hostBase, operand, predicate)
+            : RefineSparse(memory, hostBase, operand, predicate);
+        if (!Refined)
+        {
+            return false;
+        }
+    }
+    else
+    {
+        const uint32_t ScanSize = region.Size;
+
+        // The local copy doubles as the snapshot for any relational scans that follow
+        std::vector<uint8_t> regionCopy(ScanSize);
+        if (!memory.Read(hostBase, regionCopy.data(), ScanSize))
+        {
+            return false;
+        }
+
+        m_region = region;
+        m_alignment = alignment;
+        m_encoding = encoding;
+        m_snapshot.swap(regionCopy);
+
+        // The kernels hand back element indices into the local copy, which are
+        // also the indices kept in the hit set. Don't directly read from the
+        // remote process address space!
+        ScanPassTimer timer(ScanSize);
+        const size_t ElementsToScan = GetNumElements(ScanSize, valueSize, alignment);
+        std::vector<TScanType> decodedValues;
+        const TScanType* pLocalTypedArray =
+            GetElementValues(m_snapshot.data(), ElementsToScan, valueSize, alignment, encoding, decodedValues);
+        m_hits.Reset(static_cast<uint32_t>(ElementsToScan));
+
+        uint32_t hitIndices[kHitBatchSize];
+        size_t batchStart = 0;
+        while (batchStart < ElementsToScan)
+        {
+            const size_t NumHits =
+                ScanKernels::FindMatches(
+                    pLocalTypedArray + batchStart,
+                    ElementsToScan - batchStart,
+                    predicate,
+                    operand,
+                    hitIndices,
+                    kHitBatchSize);
+
+            for (size_t i = 0; i < NumHits; ++i)
+            {
+                m_hits.Append(static_cast<uint32_t>(batchStart + hitIndices[i]));
+            }
+
+            if (NumHits < kHitBatchSize)
+            {
+                break;
+            }
+
+            // The batch filled up, so pick up again right after its last hit
+            batchStart += hitIndices[NumHits - 1] + 1;
+        }
+    }
+
+    m_slotSize = valueSize;
+    return true;
+}
+
+template<typename TScanType>
+bool MemScanSlot::RefineSparse(IMemorySource& memory, uint64_t hostBase, const ScanOperand<TScanType>& operand, ScanPredicate predicate)
+{
+    // Hits are kept in address order, so the current values for all of them can be pulled in with
+    // a few coalesced reads of the covered span rather than one remote read per hit.
+    const uint64_t RegionStart = hostBase;
+    std::vector<uint64_t> hitAddresses;
+    hitAddresses.reserve(m_hits.GetCount());
+    m_hits.ForEach([this, &hitAddresses, RegionStart](uint32_t index)
+    {
+        hitAddresses.push_back(RegionStart + GetHitHostOffset(index));
+    });
+
+    std::vector<ReadRange> readRanges;
+    PlanCoalescedReads(hitAddresses.data(), hitAddresses.size(), GetHitHostSize(), kDefaultMaxReadGap, readRanges);
+
+    // The span starts on a host word, like the region, so 68K offsets relative to it pick out
+    // bytes the same way as offsets into the region's host copy do
+    const uint64_t SpanStart = readRanges.front().Address & ~1ull;
+    const uint64_t SpanSize = readRanges.back().Address + readRanges.back().Size - SpanStart;
+    std::vector<uint8_t> localSpan(SpanSize);
+    std::vector<ScatterReadEntry> reads;
+    reads.reserve(readRanges.size());
+    for (const ReadRange& Range : readRanges)
+    {
+        reads.push_back({ Range.Address, localSpan.data() + (Range.Address - SpanStart), Range.Size, false });
+    }
+
+    if (!memory.ReadScatter(reads.data(), reads.size()))
+    {
+        return false;
+    }
+
+    const uint8_t* pSnapshot = m_snapshot.data();
+    const uint8_t* pSpan = localSpan.data();
+    const uint32_t SpanOffset = static_cast<uint32_t>(SpanStart - RegionStart);
+    {
+        ScanPassTimer timer(static_cast<uint64_t>(m_hits.GetCount()) * sizeof(TScanType));
+        const bool DropsInvalidPrevious = m_encoding == ScanEncoding::Bcd && PredicateUsesSnapshot(predicate);
+        m_hits.Filter([this, pSnapshot, pSpan, SpanOffset, &operand, predicate, DropsInvalidPrevious](uint32_t index)
+        {
+            const uint32_t Offset = GetHitM68KOffset(index);
+            const TScanType PreviousValue = ReadElementValue<TScanType>(pSnapshot, Offset, m_slotSize, m_encoding);
+            const TScanType CurrentValue = ReadElementValue<TScanType>(pSpan, Offset - SpanOffset, m_slotSize, m_encoding);
+            if (m_encoding == ScanEncoding::Bcd &&
+                (CurrentValue == static_cast<TScanType>(kInvalidBcd) ||
+                (DropsInvalidPrevious && PreviousValue == static_cast<TScanType>(kInvalidBcd))))
+            {
+                return false;
+            }
+
+            return MatchesPredicate(predicate, PreviousValue, CurrentValue, operand);
+        });
+    }
+
+    // Everything that was just read is the new baseline for the next relational scan
+    for (const ReadRange& Range : readRanges)
+    {
+        memcpy(m_snapshot.data() + (Range.Address - RegionStart), localSpan.data() + (Range.Address - SpanStart), Range.Size);
+    }
+
+    return true;
+}
+
+template<typename TScanType>
+bool MemScanSlot::RefineDense(IMemorySource& memory, uint64_t hostBase, const ScanOperand<TScanType>& operand, ScanPredicate predicate)
+{
+    // Hits are spread across the whole region, so one bulk read and a vectorized
+    // pass over the old and new copies is cheaper than chasing them individually.
+    // Sources holding the region locally are filtered in place and only copied
+    // once, into the snapshot.
+    const uint32_t RegionSize = static_cast<uint32_t>(m_snapshot.size());
+    const uint8_t* pCurrent = memory.GetDirectPointer(hostBase, RegionSize);
+    std::vector<uint8_t> currentRegion;
+    if (!pCurrent || (reinterpret_cast<uintptr_t>(pCurrent) & (sizeof(TScanType) - 1)) != 0)
+    {
+        currentRegion.resize(RegionSize);
+        if (!memory.Read(hostBase, currentRegion.data(), RegionSize))
+        {
+            return false;
+        }
+        pCurrent = currentRegion.data();
+    }
+
+    size_t numRemaining;
+    {
+        ScanPassTimer timer(RegionSize);
+        const size_t NumElements = m_hits.GetUniverseSize();
+        std::vector<TScanType> previousValues;
+        std::vector<TScanType> currentValues;
+        const TScanType* pPreviousValues = PredicateUsesSnapshot(predicate)
+            ? GetElementValues(m_snapshot.data(), NumElements, m_slotSize, m_alignment, m_encoding, previousValues)
+            : nullptr;
+        const TScanType* pCurrentValues = GetElementValues(pCurrent, NumElements, m_slotSize, m_alignment, m_encoding, currentValues);
+        numRemaining =
+            ScanKernels::FilterCandidates(
+                pPreviousValues,
+                pCurrentValues,
+                NumElements,
+                predicate,
+                operand,
+                m_hits.GetDenseBits());
+
+        // Invalid BCD is above every valid value, so it still has to go after predicates
+        // like dec that only look at how values changed
+        if (m_encoding == ScanEncoding::Bcd)
+        {
+            numRemaining = DropInvalidBcd(pCurrentValues, NumElements, m_slotSize, m_hits.GetDenseBits());
+            if (pPreviousValues)
+            {
+                numRemaining = DropInvalidBcd(pPreviousValues, NumElements, m_slotSize, m_hits.GetDenseBits());
+            }
+        }
+    }
+
+    m_hits.SetDenseCount(static_cast<uint32_t>(numRemaining));
+    if (currentRegion.empty())
+    {
+        memcpy(m_snapshot.data(), pCurrent, RegionSize);
+    }
+    else
+    {
+        m_snapshot.swap(currentRegion);
+    }
+    return true;
+}
+
+bool MemScanSlot::ScanForByte(IMemorySource& memory, const M68KRegion& region, uint64_t hostBase, uint8_t searchValue, ScanPredicate predicate)
+{
+    return Scan(memory, region, hostBase, MakeScanOperand(searchValue), predicate, ScanAlignment::Even);
+}
+
+bool MemScanSlot::ScanForByte(IMemorySource& memory, const M68KRegion& region, uint64_t hostBase, const ScanOperand<uint8_t>& operand,
+    ScanPredicate predicate)
+{
+    return Scan(memory, region, hostBase, operand, predicate, ScanAlignment::Even);
+}
+
+bool MemScanSlot::ScanForHalfWord(IMemorySource& memory, const M68KRegion& region, uint64_t hostBase, uint16_t searchValue, ScanPredicate predicate)
+{
+    return Scan(memory, region, hostBase, MakeScanOperand(searchValue), predicate, ScanAlignment::Even);
+}
+
+bool MemScanSlot::ScanForHalfWord(IMemorySource& memory, const M68KRegion& region, uint64_t hostBase, const ScanOperand<uint16_t>& operand,
+    ScanPredicate predicate, ScanAlignment alignment)
+{
+    return Scan(memory, region, hostBase, operand, predicate, alignment);
+}
+
+bool MemScanSlot::ScanForWord(IMemorySource& memory, const M68KRegion& region, uint64_t hostBase, uint32_t searchValue, ScanPredicate predicate)
+{
+    return Scan(memory, region, hostBase, MakeScanOperand(searchValue), predicate, ScanAlignment::Even);
+}
+
+bool MemScanSlot::ScanForWord(IMemorySource& memory, const M68KRegion& region, uint64_t hostBase, const ScanOperand<uint32_t>& operand,
+    ScanPredicate predicate, ScanAlignment alignment)
+{
+    return Scan(memory, region, hostBase, operand, predicate, alignment);
+}
+
+// Equal and AnyOf first scans look for the BCD encoding of their values, with the plain
+// integer scans. Only valid BCD can match an encoded value, and bytes and aligned words
+// are then searched in place. Every other BCD scan compares decoded values.
+bool MemScanSlot::ScanForBcd(IMemorySource& memory, const M68KRegion& region, uint64_t hostBase, uint8_t valueSize,
+    const ScanOperand<uint32_t>& operand, ScanPredicate predicate, ScanAlignment alignment)
+{
+    if (valueSize < 1 || valueSize > kMaxBcdSize || predicate == ScanPredicate::MaskEqual)
+    {
+        return false;
+    }
+
+    // Nothing decodes to more than the maximum but invalid BCD, which mustn't match
+    for (uint32_t i = 0; i < kMaxScanOperandValues; ++i)
+    {
+        if (operand.Values[i] > GetMaxBcdValue(valueSize))
+        {
+            return false;
+        }
+    }
+
+    const bool SearchesEncoded = IsClear() && valueSize != 3 &&
+        (predicate == ScanPredicate::Equal || predicate == ScanPredicate::AnyOf);
+    if (!SearchesEncoded)
+    {
+        return Scan(memory, region, hostBase, operand, predicate, alignment, valueSize, ScanEncoding::Bcd);
+    }
+
+    uint32_t encoded[kMaxScanOperandValues];
+    for (uint32_t i = 0; i < kMaxScanOperandValues; ++i)
+    {
+        encoded[i] = EncodeBcd(operand.Values[i]);
+    }
+
+    bool scanned;
+    switch (valueSize)
+    {
+    case 1:
+        scanned = Scan(memory, region, hostBase, NarrowOperand<uint8_t>(encoded, operand.NumValues), predicate, alignment);
+        break;
+    case 2:
+        scanned = Scan(memory, region, hostBase, NarrowOperand<uint16_t>(encoded, operand.NumValues), predicate, alignment);
+        break;
+    default:
+        scanned = Scan(memory, region, hostBase, MakeScanOperand(encoded, operand.NumValues), predicate, alignment);
+        break;
+    }
+
+    // From here on the hits are BCD values like any other
+    if (scanned)
+    {
+        m_encoding = ScanEncoding::Bcd;
+    }
+    return scanned;
+}
+
+bool MemScanSlot::BeginUnknownScan(IMemorySource& memory, const M68KRegion& region, uint64_t hostBase, uint8_t valueSize,
+    ScanAlignment alignment, ScanEncoding encoding)
+{
+    const bool ValidSize = encoding == ScanEncoding::Bcd
+        ? valueSize >= 1 && valueSize <= kMaxBcdSize
+        : valueSize == 1 || valueSize == 2 || valueSize == 4;
+    if (!ValidSize)
+    {
+        return false;
+    }
+
+    assert((hostBase & 1) == 0);
+
+    const uint32_t ScanSize = region.Size;
+    std::vector<uint8_t> regionCopy(ScanSize);
+    if (!memory.Read(hostBase, regionCopy.data(), ScanSize))
+    {
+        return false;
+    }
+
+    // Copy first, region may well be this slot's own descriptor
+    const M68KRegion Region = region;
+    Clear();
+
+    m_region = Region;
+    m_alignment = valueSize == 1 ? ScanAlignment::Even : alignment;
+    m_encoding = encoding;
+    m_snapshot.swap(regionCopy);
+    const uint32_t NumElements = GetNumElements(ScanSize, valueSize, m_alignment);
+    m_hits.Reset(NumElements);
+    m_hits.AddAll();
+
+    // Whatever isn't valid BCD to begin with can't be the value being looked for
+    if (encoding == ScanEncoding::Bcd)
+    {
+        ScanPassTimer timer(ScanSize);
+        std::vector<uint32_t> values;
+        GetElementValues(m_snapshot.data(), NumElements, valueSize, m_alignment, encoding, values);
+        m_hits.SetDenseCount(static_cast<uint32_t>(DropInvalidBcd(values.data(), NumElements, valueSize, m_hits.GetDenseBits())));
+    }
+
+    m_slotSize = valueSize;
+    return true;
+}
+
+bool MemScanSlot::IsClear() const
+{
+    return m_hits.IsEmpty();
+}
+
+uint8_t MemScanSlot::GetSlotSize() const
+{
+    return m_slotSize;
+}
+
+uint32_t MemScanSlot::GetNumEntries() const
+{
+    return m_hits.GetCount();
+}
+
+const HitSet& MemScanSlot::GetHits() const
+{
+    return m_hits;
+}
+
+const M68KRegion& MemScanSlot::GetRegion() const
+{
+    return m_region;
+}
+
+size_t MemScanSlot::GetMemoryUsage() const
+{
+    return m_hits.GetMemoryUsage() + m_snapshot.capacity();
+}
+
+ScanAlignment MemScanSlot::GetAlignment() const
+{
+    return m_alignment;
+}
+
+ScanEncoding MemScanSlot::GetEncoding() const
+{
+    return m_encoding;
+}
+
+uint32_t MemScanSlot::GetHitM68KOffset(uint32_t hitIndex) const
+{
+    return GetElementM68KOffset(hitIndex, m_slotSize, m_alignment);
+}
+
+uint32_t MemScanSlot::GetHitM68KAddress(uint32_t hitIndex) const
+{
+    return m_region.M68KBase + GetHitM68KOffset(hitIndex);
+}
+
+// Values at odd addresses take in the host words on either side, which at the very end
+// of the region are read from a little further back instead
+uint32_t MemScanSlot::GetHitHostOffset(uint32_t hitIndex) const
+{
+    if (m_slotSize == 1)
+    {
+        return hitIndex;
+    }
+
+    const uint32_t WordOffset = GetHitM68KOffset(hitIndex) & ~1u;
+    return std::min(WordOffset, m_region.Size - GetHitHostSize());
+}
+
+// Whole host words, plus one more for values that can start at an odd address
+uint32_t MemScanSlot::GetHitHostSize() const
+{
+    if (m_slotSize == 1)
+    {
+        return 1;
+    }
+
+    const uint32_t WordsSize = (m_slotSize + 1u) & ~1u;
+    return m_alignment == ScanAlignment::Even ? WordsSize : WordsSize + 2u;
+}
+
+uint32_t MemScanSlot::GetNumElements(uint32_t regionSize, uint8_t valueSize, ScanAlignment alignment)
+{
+    return regionSize < valueSize ? 0 : (regionSize - valueSize) / GetElementStride(valueSize, alignment) + 1;
+}
+
+ScanStats MemScanSlot::GetScanStats()
+{
+    ScanStats stats;
+    stats.NumPasses = s_numScanPasses.load(std::memory_order_relaxed);
+    stats.BytesScanned = s_bytesScanned.load(std::memory_order_relaxed);
+    stats.Nanoseconds = s_scanNanoseconds.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void MemScanSlot::ResetScanStats()
+{
+    s_numScanPasses.store(0, std::memory_order_relaxed);
+    s_bytesScanned.store(0, std::memory_order_relaxed);
+    s_scanNanoseconds.store(0, std::memory_order_relaxed);
+}
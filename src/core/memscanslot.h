@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "hitset.h"
+#include "m68kregion.h"
+#include "memorysource.h"
+#include "scanpredicate.h"
+
+// Totals for the filtering done by the scans of every slot, not counting the time
+// spent reading memory, so kernel throughput can be told apart from transport cost
+struct ScanStats
+{
+    uint64_t NumPasses;
+    uint64_t BytesScanned;
+    uint64_t Nanoseconds;
+};
+
+// Where a scan looks for words and longs. The 68000 only accesses them at even
+// addresses, but values a game puts together from single bytes can be anywhere.
+enum class ScanAlignment : uint8_t
+{
+    Even,
+    Any,
+};
+
+// How a scan reads the values it compares
+enum class ScanEncoding : uint8_t
+{
+    // Plain unsigned integers
+    Binary,
+    // Packed BCD, compared as the decimal numbers they hold. Values that aren't valid
+    // BCD never match, and are dropped from the hits by any refine.
+    Bcd,
+};
+
+class MemScanSlot
+{
+public:
+    MemScanSlot();
+
+    void Clear();
+
+    // Scans are described in terms of a 68K region plus wherever the host currently has
+    // that region mapped in memory, which the caller looks up fresh for every command.
+    // Values are compared as the 68K sees them, big-endian, at every address the
+    // alignment allows; the alignment of the scan that started the slot holds for its
+    // refines. Predicates that use the snapshot compare against the values seen by the
+    // previous scan of this slot, so they can't start a new scan. A scan that fails to
+    // read memory leaves the slot as it was.
+    bool ScanForByte(IMemorySource& memory, const M68KRegion& region, uint64_t hostBase, uint8_t searchValue, ScanPredicate predicate = ScanPredicate::Equal);
+    bool ScanForHalfWord(IMemorySource& memory, const M68KRegion& region, uint64_t hostBase, uint16_t searchValue, ScanPredicate predicate = ScanPredicate::Equal);
+    bool ScanForWord(IMemorySource& memory, const M68KRegion& region, uint64_t hostBase, uint32_t searchValue, ScanPredicate predicate = ScanPredicate::Equal);
+
+    // Same, for predicates taking more than one value
+    bool ScanForByte(IMemorySource& memory, const M68KRegion& region, uint64_t hostBase, const ScanOperand<uint8_t>& operand,
+        ScanPredicate predicate);
+    bool ScanForHalfWord(IMemorySource& memory, const M68KRegion& region, uint64_t hostBase, const ScanOperand<uint16_t>& operand,
+        ScanPredicate predicate, ScanAlignment alignment = ScanAlignment::Even);
+    bool ScanForWord(IMemorySource& memory, const M68KRegion& region, uint64_t hostBase, const ScanOperand<uint32_t>& operand,
+        ScanPredicate predicate, ScanAlignment alignment = ScanAlignment::Even);
+
+    // Same, for packed BCD values of 1 to kMaxBcdSize bytes. The operand holds plain
+    // decimal numbers, e.g. 1234 for the bytes 12 34. ScanPredicate::MaskEqual doesn't
+    // apply to BCD.
+    bool ScanForBcd(IMemorySource& memory, const M68KRegion& region, uint64_t hostBase, uint8_t valueSize,
+        const ScanOperand<uint32_t>& operand, ScanPredicate predicate, ScanAlignment alignment = ScanAlignment::Even);
+
+    // Starts a scan for a value that isn't known up front. Every element of the region is
+    // a hit until later scans refine on how the values changed since the last one.
+    bool BeginUnknownScan(IMemorySource& memory, const M68KRegion& region, uint64_t hostBase, uint8_t valueSize,
+        ScanAlignment alignment = ScanAlignment::Even, ScanEncoding encoding = ScanEncoding::Binary);
+
+    bool IsClear() const;
+
+    uint8_t GetSlotSize() const;
+    ScanAlignment GetAlignment() const;
+    ScanEncoding GetEncoding() const;
+    uint32_t GetNumEntries() const;
+    const HitSet& GetHits() const;
+    const M68KRegion& GetRegion() const;
+    size_t GetMemoryUsage() const;
+
+    // Hits are element indices into the slot's region. Bytes are numbered by host
+    // offset, words and longs by 68K offset over the alignment's step.
+    uint32_t GetHitM68KOffset(uint32_t hitIndex) const;
+    uint32_t GetHitM68KAddress(uint32_t hitIndex) const;
+
+    // The host bytes a hit's value lives in, as an offset into the region's host copy.
+    // The size is the same for every hit of the slot, so reads can be planned in one go.
+    uint32_t GetHitHostOffset(uint32_t hitIndex) const;
+    uint32_t GetHitHostSize() const;
+
+    // Number of values of valueSize bytes a region of regionSize bytes holds
+    static uint32_t GetNumElements(uint32_t regionSize, uint8_t valueSize, ScanAlignment alignment);
+
+    static ScanStats GetScanStats();
+    static void ResetScanStats();
+
+private:
+    // Values are valueSize bytes, which only differs from the size of TScanType for BCD
+    template<typename TScanType>
+    bool Scan(IMemorySource& memory, const M68KRegion& region, uint64_t hostBase, const ScanOperand<TScanType>& operand,
+        ScanPredicate predicate, ScanAlignment alignment, uint8_t valueSize = sizeof(TScanType), ScanEncoding encoding = ScanEncoding::Binary);
+    template<typename TScanType>
+    bool RefineSparse(IMemorySource& memory, uint64_t hostBase, const ScanOperand<TScanType>& operand, ScanPredicate predicate);
+    template<typename TScanType>
+    bool RefineDense(IMemorySource& memory, uint64_t hostBase, const ScanOperand<TScanType>& operand, ScanPredicate predicate);
+
+    // The size, alignment and encoding of the active scan
+    uint8_t m_slotSize = 0;
+    ScanAlignment m_alignment = ScanAlignment::Even;
+    ScanEncoding m_encoding = ScanEncoding::Binary;
+
+    M68KRegion m_region = {};
+    HitSet m_hits;
+
+    // Host copy of the scanned region as of the last scan, which the relational
+    // predicates compare against
+    std::vector<uint8_t> m_snapshot;
+};
\ No newline at end of file
@@ -0,0 +1,88 @@
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+
+#include "memscanslotpool.h"
+
+bool MemScanSlotPool::NormalizeName(const char* pName, std::string& nameOut)
+{
+    const size_t Length = strlen(pName);
+    if (Length == 0 || Length > kMaxNameLength)
+    {
+        return false;
+    }
+
+    if (isdigit(static_cast<unsigned char>(pName[0])))
+    {
+        char* pEnd = nullptr;
+        const unsigned long long Number = strtoull(pName, &pEnd, 0);
+        if (*pEnd != '\0')
+        {
+            return false;
+        }
+
+        nameOut = std::to_string(Number);
+        return true;
+    }
+
+    for (size_t i = 0; i < Length; ++i)
+    {
+        const unsigned char C = static_cast<unsigned char>(pName[i]);
+        if (!isalnum(C) && C != '_')
+        {
+            return false;
+        }
+    }
+
+    nameOut = pName;
+    return true;
+}
+
+MemScanSlot* MemScanSlotPool::Find(const std::string& name)
+{
+    const auto It = m_slots.find(name);
+    return It != m_slots.end() ? &It->second : nullptr;
+}
+
+const MemScanSlot* MemScanSlotPool::Find(const std::string& name) const
+{
+    const auto It = m_slots.find(name);
+    return It != m_slots.end() ? &It->second : nullptr;
+}
+
+MemScanSlot* MemScanSlotPool::FindOrCreate(const std::string& name)
+{
+    MemScanSlot* pSlot = Find(name);
+    if (pSlot || m_slots.size() >= kMaxSlots)
+    {
+        return pSlot;
+    }
+
+    // Map nodes never move, so the slot stays put while others come and go
+    return &m_slots[name];
+}
+
+bool MemScanSlotPool::Release(const std::string& name)
+{
+    return m_slots.erase(name) != 0;
+}
+
+size_t MemScanSlotPool::GetNumSlots() const
+{
+    return m_slots.size();
+}
+
+size_t MemScanSlotPool::GetMemoryUsage() const
+{
+    size_t bytes = 0;
+    for (const auto& Entry : m_slots)
+    {
+        bytes += Entry.second.GetMemoryUsage();
+    }
+
+    return bytes;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <string>
+
+#include "memscanslot.h"
+
+//----------------------------------------------------------------------------
+// Named memory scan slots.
+//
+// A slot is only allocated when something is first scanned into it and is
+// destroyed again when cleared, so only slots holding results take up any
+// memory. Names that parse as numbers are normalized to decimal, which keeps
+// the old numbered slots working: "1" and "0x1" are the same slot.
+//----------------------------------------------------------------------------
+
+class MemScanSlotPool
+{
+public:
+    static constexpr size_t kMaxSlots = 64;
+    static constexpr size_t kMaxNameLength = 32;
+
+    // Returns false unless the name is a number or an identifier of letters,
+    // digits and underscores no longer than kMaxNameLength
+    static bool NormalizeName(const char* pName, std::string& nameOut);
+
+    // Null if there's no slot by that name
+    MemScanSlot* Find(const std::string& name);
+    const MemScanSlot* Find(const std::string& name) const;
+
+    // Allocates the slot if it doesn't exist yet. Null once kMaxSlots are in use.
+    MemScanSlot* FindOrCreate(const std::string& name);
+
+    // Destroys the slot along with everything it held. Returns false if there was no such slot.
+    bool Release(const std::string& name);
+
+    size_t GetNumSlots() const;
+    size_t GetMemoryUsage() const;
+
+    // Calls callback(name, slot) for every allocated slot in name order
+    template<typename TCallback>
+    void ForEach(TCallback&& callback) const
+    {
+        for (const auto& Entry : m_slots)
+        {
+            callback(Entry.first, Entry.second);
+        }
+    }
+
+private:
+    std::map<std::string, MemScanSlot> m_slots;
+};
@@ -0,0 +1,252 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "minidumpmemorysource.h"
+
+namespace
+{
+    //------------------------------------------------------------------------
+    // Just enough of the minidump format from minidumpapiset.h, without
+    // needing Windows headers. Everything is little-endian and only 4 byte
+    // aligned in the file, so fields are pulled out with memcpy.
+    //------------------------------------------------------------------------
+    constexpr uint32_t kMinidumpSignature = 0x504D444D; // "MDMP"
+    constexpr uint32_t kMemoryListStream = 5;
+    constexpr uint32_t kMemory64ListStream = 9;
+
+    // MINIDUMP_HEADER
+    constexpr size_t kHeaderSize = 32;
+    constexpr size_t kHeaderNumberOfStreamsOffset = 8;
+    constexpr size_t kHeaderStreamDirectoryRvaOffset = 12;
+
+    // MINIDUMP_DIRECTORY, a stream type followed by a MINIDUMP_LOCATION_DESCRIPTOR
+    constexpr size_t kDirectoryEntrySize = 12;
+
+    // MINIDUMP_MEMORY_DESCRIPTOR, a start address followed by a MINIDUMP_LOCATION_DESCRIPTOR
+    constexpr size_t kMemoryDescriptorSize = 16;
+
+    // MINIDUMP_MEMORY64_LIST header, followed by MINIDUMP_MEMORY_DESCRIPTOR64 start/size pairs
+    constexpr size_t kMemory64ListHeaderSize = 16;
+    constexpr size_t kMemoryDescriptor64Size = 16;
+
+    template<typename T>
+    T ReadField(const uint8_t* pData, uint64_t offset)
+    {
+        T value;
+        memcpy(&value, pData + offset, sizeof(T));
+        return value;
+    }
+
+    bool FitsInFile(uint64_t offset, uint64_t size, uint64_t fileSize)
+    {
+        return offset <= fileSize && size <= fileSize - offset;
+    }
+}
+
+bool MinidumpMemorySource::Open(const char* pPath)
+{
+    Close();
+
+    if (!m_file.Open(pPath))
+    {
+        return false;
+    }
+
+    const uint8_t* pData = m_file.GetData();
+    const uint64_t FileSize = m_file.GetSize();
+    if (FileSize < kHeaderSize || ReadField<uint32_t>(pData, 0) != kMinidumpSignature)
+    {
+        Close();
+        return false;
+    }
+
+    const uint32_t NumStreams = ReadField<uint32_t>(pData, kHeaderNumberOfStreamsOffset);
+    const uint32_t DirectoryRva = ReadField<uint32_t>(pData, kHeaderStreamDirectoryRvaOffset);
+    if (!FitsInFile(DirectoryRva, static_cast<uint64_t>(NumStreams) * kDirectoryEntrySize, FileSize))
+    {
+        Close();
+        return false;
+    }
+
+    // A full dump has a Memory64ListStream, which supersedes any MemoryListStream
+    bool hasMemory64List = false;
+    for (uint32_t i = 0; i < NumStreams && !hasMemory64List; ++i)
+    {
+        hasMemory64List = ReadField<uint32_t>(pData, DirectoryRva + i * kDirectoryEntrySize) == kMemory64ListStream;
+    }
+
+    for (uint32_t i = 0; i < NumStreams; ++i)
+    {
+        const uint64_t Entry = DirectoryRva + static_cast<uint64_t>(i) * kDirectoryEntrySize;
+        const uint32_t StreamType = ReadField<uint32_t>(pData, Entry);
+        const uint32_t StreamSize = ReadField<uint32_t>(pData, Entry + 4);
+        const uint32_t StreamRva = ReadField<uint32_t>(pData, Entry + 8);
+
+        bool parsed = true;
+        if (StreamType == kMemory64ListStream)
+        {
+            parsed = ParseMemory64List(StreamRva, StreamSize);
+        }
+        else if (StreamType == kMemoryListStream && !hasMemory64List)
+        {
+            parsed = ParseMemoryList(StreamRva, StreamSize);
+        }
+
+        if (!parsed)
+        {
+            Close();
+            return false;
+        }
+    }
+
+    if (m_ranges.empty())
+    {
+        Close();
+        return false;
+    }
+
+    std::sort(m_ranges.begin(), m_ranges.end(),
+        [](const CapturedRange& a, const CapturedRange& b) { return a.Address < b.Address; });
+    return true;
+}
+
+void MinidumpMemorySource::Close()
+{
+    m_ranges.clear();
+    m_file.Close();
+}
+
+bool MinidumpMemorySource::ParseMemoryList(uint64_t streamOffset, uint64_t streamSize)
+{
+    const uint8_t* pData = m_file.GetData();
+    if (streamSize < sizeof(uint32_t) || !FitsInFile(streamOffset, streamSize, m_file.GetSize()))
+    {
+        return false;
+    }
+
+    const uint32_t NumRanges = ReadField<uint32_t>(pData, streamOffset);
+    if (static_cast<uint64_t>(NumRanges) * kMemoryDescriptorSize > streamSize - sizeof(uint32_t))
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < NumRanges; ++i)
+    {
+        const uint64_t Descriptor = streamOffset + sizeof(uint32_t) + static_cast<uint64_t>(i) * kMemoryDescriptorSize;
+        const uint64_t Address = ReadField<uint64_t>(pData, Descriptor);
+        const uint32_t Size = ReadField<uint32_t>(pData, Descriptor + 8);
+        const uint32_t Rva = ReadField<uint32_t>(pData, Descriptor + 12);
+        if (!AddRange(Address, Size, Rva))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool MinidumpMemorySource::ParseMemory64List(uint64_t streamOffset, uint64_t streamSize)
+{
+    const uint8_t* pData = m_file.GetData();
+    if (streamSize < kMemory64ListHeaderSize || !FitsInFile(streamOffset, streamSize, m_file.GetSize()))
+    {
+        return false;
+    }
+
+    const uint64_t NumRanges = ReadField<uint64_t>(pData, streamOffset);
+    if (NumRanges > (streamSize - kMemory64ListHeaderSize) / kMemoryDescriptor64Size)
+    {
+        return false;
+    }
+
+    // All of the memory is stored back to back from BaseRva, in descriptor order
+    uint64_t fileOffset = ReadField<uint64_t>(pData, streamOffset + 8);
+    for (uint64_t i = 0; i < NumRanges; ++i)
+    {
+        const uint64_t Descriptor = streamOffset + kMemory64ListHeaderSize + i * kMemoryDescriptor64Size;
+        const uint64_t Address = ReadField<uint64_t>(pData, Descriptor);
+        const uint64_t Size = ReadField<uint64_t>(pData, Descriptor + 8);
+        if (!AddRange(Address, Size, fileOffset))
+        {
+            return false;
+        }
+        fileOffset += Size;
+    }
+
+    return true;
+}
+
+bool MinidumpMemorySource::AddRange(uint64_t address, uint64_t size, uint64_t fileOffset)
+{
+    if (!FitsInFile(fileOffset, size, m_file.GetSize()))
+    {
+        return false;
+    }
+
+    if (size != 0)
+    {
+        m_ranges.push_back({ address, size, fileOffset });
+    }
+    return true;
+}
+
+const MinidumpMemorySource::CapturedRange* MinidumpMemorySource::FindRange(uint64_t address) const
+{
+    auto It = std::upper_bound(m_ranges.begin(), m_ranges.end(), address,
+        [](uint64_t value, const CapturedRange& range) { return value < range.Address; });
+    if (It == m_ranges.begin())
+    {
+        return nullptr;
+    }
+
+    const CapturedRange& Range = *(It - 1);
+    return address - Range.Address < Range.Size ? &Range : nullptr;
+}
+
+bool MinidumpMemorySource::Read(uint64_t address, void* pBuffer, uint32_t size)
+{
+    // Neighbouring allocations often end up in separate but adjacent ranges, so
+    // a read is allowed to carry on into the next one
+    uint8_t* pOut = static_cast<uint8_t*>(pBuffer);
+    while (size > 0)
+    {
+        const CapturedRange* pRange = FindRange(address);
+        if (!pRange)
+        {
+            return false;
+        }
+
+        const uint64_t Offset = address - pRange->Address;
+        const uint32_t Chunk = static_cast<uint32_t>(std::min<uint64_t>(size, pRange->Size - Offset));
+        memcpy(pOut, m_file.GetData() + pRange->FileOffset + Offset, Chunk);
+
+        pOut += Chunk;
+        address += Chunk;
+        size -= Chunk;
+    }
+
+    return true;
+}
+
+void MinidumpMemorySource::EnumerateRegions(std::vector<MemoryRegionInfo>& regionsOut)
+{
+    regionsOut.clear();
+    for (const CapturedRange& Range : m_ranges)
+    {
+        regionsOut.push_back({ Range.Address, Range.Size });
+    }
+}
+
+const uint8_t* MinidumpMemorySource::GetDirectPointer(uint64_t address, uint32_t size)
+{
+    const CapturedRange* pRange = FindRange(address);
+    if (!pRange || size > pRange->Size - (address - pRange->Address))
+    {
+        return nullptr;
+    }
+
+    return m_file.GetData() + pRange->FileOffset + (address - pRange->Address);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "mappedfile.h"
+#include "memorysource.h"
+
+//----------------------------------------------------------------------------
+// Memory source over a Windows minidump, for scanning captured dumps of FBNeo
+// offline. The dump is memory mapped and parsed directly, so this works
+// without dbghelp on any platform. Both full dumps (Memory64ListStream) and
+// smaller ones (MemoryListStream) are supported.
+//----------------------------------------------------------------------------
+
+class MinidumpMemorySource : public IMemorySource
+{
+public:
+    // Returns false if the file can't be mapped, isn't a minidump, or has no memory in it
+    bool Open(const char* pPath);
+    void Close();
+
+    bool Read(uint64_t address, void* pBuffer, uint32_t size) override;
+    void EnumerateRegions(std::vector<MemoryRegionInfo>& regionsOut) override;
+
+    // Points straight into the mapping, as long as the range lies within one captured range
+    const uint8_t* GetDirectPointer(uint64_t address, uint32_t size) override;
+
+private:
+    struct CapturedRange
+    {
+        uint64_t Address;
+        uint64_t Size;
+        uint64_t FileOffset;
+    };
+
+    bool ParseMemoryList(uint64_t streamOffset, uint64_t streamSize);
+    bool ParseMemory64List(uint64_t streamOffset, uint64_t streamSize);
+    bool AddRange(uint64_t address, uint64_t size, uint64_t fileOffset);
+
+    // The captured range containing address, or null
+    const CapturedRange* FindRange(uint64_t address) const;
+
+    MappedFile m_file;
+
+    // Sorted by address
+    std::vector<CapturedRange> m_ranges;
+};
@@ -0,0 +1,49 @@
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "readplanner.h"
+
+size_t PlanCoalescedReads(
+    const uint64_t* pAddresses,
+    size_t numAddresses,
+    uint32_t elementSize,
+    uint32_t maxGap,
+    std::vector<ReadRange>& rangesOut)
+{
+    assert(pAddresses || numAddresses == 0);
+    assert(elementSize > 0);
+
+    const size_t FirstRange = rangesOut.size();
+    if (numAddresses == 0)
+    {
+        return 0;
+    }
+
+    uint64_t rangeStart = pAddresses[0];
+    uint64_t rangeEnd = rangeStart + elementSize;
+    for (size_t i = 1; i < numAddresses; ++i)
+    {
+        const uint64_t Address = pAddresses[i];
+        assert(Address >= pAddresses[i - 1]);
+
+        const uint64_t End = Address + elementSize;
+        if (Address <= rangeEnd + maxGap)
+        {
+            // Close enough to the current range to just read through the gap
+            if (End > rangeEnd)
+            {
+                rangeEnd = End;
+            }
+            continue;
+        }
+
+        rangesOut.push_back({ rangeStart, static_cast<uint32_t>(rangeEnd - rangeStart) });
+        rangeStart = Address;
+        rangeEnd = End;
+    }
+
+    rangesOut.push_back({ rangeStart, static_cast<uint32_t>(rangeEnd - rangeStart) });
+    return rangesOut.size() - FirstRange;
+}
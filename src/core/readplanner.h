@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//----------------------------------------------------------------------------
+// Read coalescing for scattered remote values.
+//
+// Every remote read is a round trip through the debugger, so a list of
+// small values is better served by a handful of larger reads covering them.
+// The planner only does the address arithmetic; callers perform the reads.
+//----------------------------------------------------------------------------
+
+struct ReadRange
+{
+    uint64_t Address = 0;
+    uint32_t Size = 0;
+};
+
+// Gaps between values larger than this are cheaper to skip with a new read than to transfer
+constexpr uint32_t kDefaultMaxReadGap = 0x400;
+
+// Builds the ranges needed to cover elementSize bytes at each of the given addresses, which must be
+// sorted in ascending order. Neighbouring values are merged into a single range whenever the unused
+// bytes between them are at most maxGap. Returns the number of ranges appended to rangesOut.
+size_t PlanCoalescedReads(
+    const uint64_t* pAddresses,
+    size_t numAddresses,
+    uint32_t elementSize,
+    uint32_t maxGap,
+    std::vector<ReadRange>& rangesOut);
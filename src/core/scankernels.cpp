@@ -0,0 +1,220 @@
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include "bitutils.h"
+#include "scankernels.h"
+#include "scankernels_impl.h"
+
+using ScanKernels::KernelLevel;
+
+namespace
+{
+    template<typename TScanType>
+    size_t FindMatchesScalar(const TScanType* pData, size_t numElements, ScanPredicate predicate,
+        const ScanOperand<TScanType>& operand, uint32_t* pIndicesOut, size_t maxIndices)
+    {
+        size_t numFound = 0;
+        for (size_t i = 0; i < numElements && numFound < maxIndices; ++i)
+        {
+            if (MatchesPredicate(predicate, pData[i], pData[i], operand))
+            {
+                pIndicesOut[numFound++] = static_cast<uint32_t>(i);
+            }
+        }
+
+        return numFound;
+    }
+
+    template<typename TScanType>
+    size_t FilterCandidatesScalar(const TScanType* pOld, const TScanType* pNew, size_t numElements,
+        ScanPredicate predicate, const ScanOperand<TScanType>& operand, uint64_t* pCandidateBits)
+    {
+        const size_t NumWords = (numElements + 63) / 64;
+        size_t numRemaining = 0;
+        for (size_t word = 0; word < NumWords; ++word)
+        {
+            uint64_t candidates = pCandidateBits[word];
+            uint64_t pending = candidates;
+            while (pending)
+            {
+                const uint32_t Bit = CountTrailingZeros64(pending);
+                const size_t Index = word * 64 + Bit;
+                assert(Index < numElements);
+
+                if (!MatchesPredicate(predicate, pOld[Index], pNew[Index], operand))
+                {
+                    candidates &= ~(1ull << Bit);
+                }
+                pending &= pending - 1;
+            }
+
+            pCandidateBits[word] = candidates;
+            numRemaining += PopCount64(candidates);
+        }
+
+        return numRemaining;
+    }
+
+    KernelLevel DetectKernelLevel()
+    {
+#if SCANKERNELS_X86
+        bool hasSse2 = false;
+        bool hasAvx2 = false;
+#if defined(_MSC_VER)
+        int cpuInfo[4];
+        __cpuid(cpuInfo, 0);
+        const int MaxLeaf = cpuInfo[0];
+
+        __cpuid(cpuInfo, 1);
+        hasSse2 = (cpuInfo[3] & (1 << 26)) != 0;
+        const bool HasOsxsave = (cpuInfo[2] & (1 << 27)) != 0;
+        const bool HasAvx = (cpuInfo[2] & (1 << 28)) != 0;
+
+        // AVX2 also needs the OS to preserve the upper YMM halves across context switches
+        if (MaxLeaf >= 7 && HasOsxsave && HasAvx && (_xgetbv(0) & 0x6) == 0x6)
+        {
+            __cpuidex(cpuInfo, 7, 0);
+            hasAvx2 = (cpuInfo[1] & (1 << 5)) != 0;
+        }
+#else
+        __builtin_cpu_init();
+        hasSse2 = __builtin_cpu_supports("sse2");
+        hasAvx2 = __builtin_cpu_supports("avx2");
+#endif
+        if (hasAvx2)
+        {
+            return KernelLevel::Avx2;
+        }
+        if (hasSse2)
+        {
+            return KernelLevel::Sse2;
+        }
+#endif // SCANKERNELS_X86
+
+        return KernelLevel::Scalar;
+    }
+
+    KernelLevel& ActiveKernelLevel()
+    {
+        static KernelLevel s_activeLevel = ScanKernels::GetSupportedKernelLevel();
+        return s_activeLevel;
+    }
+
+    template<typename TScanType>
+    size_t DispatchFindMatches(const TScanType* pData, size_t numElements, ScanPredicate predicate,
+        const ScanOperand<TScanType>& operand, uint32_t* pIndicesOut, size_t maxIndices)
+    {
+        assert(pData || numElements == 0);
+        assert(pIndicesOut || maxIndices == 0);
+        assert(!PredicateUsesSnapshot(predicate));
+
+        switch (ActiveKernelLevel())
+        {
+#if SCANKERNELS_X86
+        case KernelLevel::Avx2:
+            return ScanKernels::Avx2::FindMatches(pData, numElements, predicate, operand, pIndicesOut, maxIndices);
+        case KernelLevel::Sse2:
+            return ScanKernels::Sse2::FindMatches(pData, numElements, predicate, operand, pIndicesOut, maxIndices);
+#endif
+        default:
+            return FindMatchesScalar(pData, numElements, predicate, operand, pIndicesOut, maxIndices);
+        }
+    }
+
+    template<typename TScanType>
+    size_t DispatchFilterCandidates(const TScanType* pOld, const TScanType* pNew, size_t numElements,
+        ScanPredicate predicate, const ScanOperand<TScanType>& operand, uint64_t* pCandidateBits)
+    {
+        assert(pNew || numElements == 0);
+        assert(pOld || !PredicateUsesSnapshot(predicate));
+        assert(pCandidateBits || numElements == 0);
+
+        // The vector loops always load both sides, so point the unused one at valid memory
+        if (!pOld)
+        {
+            pOld = pNew;
+        }
+
+        switch (ActiveKernelLevel())
+        {
+#if SCANKERNELS_X86
+        case KernelLevel::Avx2:
+            return ScanKernels::Avx2::FilterCandidates(pOld, pNew, numElements, predicate, operand, pCandidateBits);
+        case KernelLevel::Sse2:
+            return ScanKernels::Sse2::FilterCandidates(pOld, pNew, numElements, predicate, operand, pCandidateBits);
+#endif
+        default:
+            return FilterCandidatesScalar(pOld, pNew, numElements, predicate, operand, pCandidateBits);
+        }
+    }
+}
+
+namespace ScanKernels
+{
+    KernelLevel GetSupportedKernelLevel()
+    {
+        static const KernelLevel s_supportedLevel = DetectKernelLevel();
+        return s_supportedLevel;
+    }
+
+    KernelLevel GetKernelLevel()
+    {
+        return ActiveKernelLevel();
+    }
+
+    void SetKernelLevel(KernelLevel level)
+    {
+        const KernelLevel Supported = GetSupportedKernelLevel();
+        ActiveKernelLevel() = level > Supported ? Supported : level;
+    }
+
+    const char* GetKernelLevelName(KernelLevel level)
+    {
+        switch (level)
+        {
+        case KernelLevel::Avx2:
+            return "AVX2";
+        case KernelLevel::Sse2:
+            return "SSE2";
+        default:
+            return "Scalar";
+        }
+    }
+
+    size_t FindMatches(const uint8_t* pData, size_t numElements, ScanPredicate predicate,
+        const ScanOperand<uint8_t>& operand, uint32_t* pIndicesOut, size_t maxIndices)
+    {
+        return DispatchFindMatches(pData, numElements, predicate, operand, pIndicesOut, maxIndices);
+    }
+
+    size_t FindMatches(const uint16_t* pData, size_t numElements, ScanPredicate predicate,
+        const ScanOperand<uint16_t>& operand, uint32_t* pIndicesOut, size_t maxIndices)
+    {
+        return DispatchFindMatches(pData, numElements, predicate, operand, pIndicesOut, maxIndices);
+    }
+
+    size_t FindMatches(const uint32_t* pData, size_t numElements, ScanPredicate predicate,
+        const ScanOperand<uint32_t>& operand, uint32_t* pIndicesOut, size_t maxIndices)
+    {
+        return DispatchFindMatches(pData, numElements, predicate, operand, pIndicesOut, maxIndices);
+    }
+
+    size_t FilterCandidates(const uint8_t* pOld, const uint8_t* pNew, size_t numElements,
+        ScanPredicate predicate, const ScanOperand<uint8_t>& operand, uint64_t* pCandidateBits)
+    {
+        return DispatchFilterCandidates(pOld, pNew, numElements, predicate, operand, pCandidateBits);
+    }
+
+    size_t FilterCandidates(const uint16_t* pOld, const uint16_t* pNew, size_t numElements,
+        ScanPredicate predicate, const ScanOperand<uint16_t>& operand, uint64_t* pCandidateBits)
+    {
+        return DispatchFilterCandidates(pOld, pNew, numElements, predicate, operand, pCandidateBits);
+    }
+
+    size_t FilterCandidates(const uint32_t* pOld, const uint32_t* pNew, size_t numElements,
+        ScanPredicate predicate, const ScanOperand<uint32_t>& operand, uint64_t* pCandidateBits)
+    {
+        return DispatchFilterCandidates(pOld, pNew, numElements, predicate, operand, pCandidateBits);
+    }
+}
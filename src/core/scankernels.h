@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "scanpredicate.h"
+
+//----------------------------------------------------------------------------
+// Vectorized search kernels used by the memory scanner.
+//
+// The widest instruction set supported by the host CPU is picked at runtime.
+// The active level can be lowered (e.g. to compare against the scalar path)
+// but never raised above what the CPU supports.
+//----------------------------------------------------------------------------
+
+namespace ScanKernels
+{
+    enum class KernelLevel
+    {
+        Scalar,
+        Sse2,
+        Avx2,
+    };
+
+    KernelLevel GetSupportedKernelLevel();
+    KernelLevel GetKernelLevel();
+    void SetKernelLevel(KernelLevel level);
+    const char* GetKernelLevelName(KernelLevel level);
+
+    // Walks a local copy of the scanned region and writes the element index of each element matching
+    // the predicate to pIndicesOut, in ascending order, stopping once maxIndices hits have been written.
+    // Only predicates that don't use the snapshot can be searched for. Returns the number of indices written.
+    size_t FindMatches(const uint8_t* pData, size_t numElements, ScanPredicate predicate,
+        const ScanOperand<uint8_t>& operand, uint32_t* pIndicesOut, size_t maxIndices);
+    size_t FindMatches(const uint16_t* pData, size_t numElements, ScanPredicate predicate,
+        const ScanOperand<uint16_t>& operand, uint32_t* pIndicesOut, size_t maxIndices);
+    size_t FindMatches(const uint32_t* pData, size_t numElements, ScanPredicate predicate,
+        const ScanOperand<uint32_t>& operand, uint32_t* pIndicesOut, size_t maxIndices);
+
+    // Clears the bit of every candidate in pCandidateBits (one bit per element, 64 elements per word)
+    // whose values fail the predicate, comparing pNew against the previous snapshot in pOld. pOld may
+    // be null for predicates which don't use the snapshot. Returns the number of candidates left.
+    size_t FilterCandidates(const uint8_t* pOld, const uint8_t* pNew, size_t numElements,
+        ScanPredicate predicate, const ScanOperand<uint8_t>& operand, uint64_t* pCandidateBits);
+    size_t FilterCandidates(const uint16_t* pOld, const uint16_t* pNew, size_t numElements,
+        ScanPredicate predicate, const ScanOperand<uint16_t>& operand, uint64_t* pCandidateBits);
+    size_t FilterCandidates(const uint32_t* pOld, const uint32_t* pNew, size_t numElements,
+        ScanPredicate predicate, const ScanOperand<uint32_t>& operand, uint64_t* pCandidateBits);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "scanpredicate.h"
+
+//----------------------------------------------------------------------------
+// Internal to the scan kernels. Each instruction set lives in its own
+// translation unit so it can be compiled for that target without leaking
+// wider instructions into code that runs on every CPU.
+//----------------------------------------------------------------------------
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SCANKERNELS_X86 1
+#else
+#define SCANKERNELS_X86 0
+#endif
+
+#if SCANKERNELS_X86
+namespace ScanKernels
+{
+    namespace Sse2
+    {
+        size_t FindMatches(const uint8_t* pData, size_t numElements, ScanPredicate predicate,
+            const ScanOperand<uint8_t>& operand, uint32_t* pIndicesOut, size_t maxIndices);
+        size_t FindMatches(const uint16_t* pData, size_t numElements, ScanPredicate predicate,
+            const ScanOperand<uint16_t>& operand, uint32_t* pIndicesOut, size_t maxIndices);
+        size_t FindMatches(const uint32_t* pData, size_t numElements, ScanPredicate predicate,
+            const ScanOperand<uint32_t>& operand, uint32_t* pIndicesOut, size_t maxIndices);
+
+        size_t FilterCandidates(const uint8_t* pOld, const uint8_t* pNew, size_t numElements,
+            ScanPredicate predicate, const ScanOperand<uint8_t>& operand, uint64_t* pCandidateBits);
+        size_t FilterCandidates(const uint16_t* pOld, const uint16_t* pNew, size_t numElements,
+            ScanPredicate predicate, const ScanOperand<uint16_t>& operand, uint64_t* pCandidateBits);
+        size_t FilterCandidates(const uint32_t* pOld, const uint32_t* pNew, size_t numElements,
+            ScanPredicate predicate, const ScanOperand<uint32_t>& operand, uint64_t* pCandidateBits);
+    }
+
+    namespace Avx2
+    {
+        size_t FindMatches(const uint8_t* pData, size_t numElements, ScanPredicate predicate,
+            const ScanOperand<uint8_t>& operand, uint32_t* pIndicesOut, size_t maxIndices);
+        size_t FindMatches(const uint16_t* pData, size_t numElements, ScanPredicate predicate,
+            const ScanOperand<uint16_t>& operand, uint32_t* pIndicesOut, size_t maxIndices);
+        size_t FindMatches(const uint32_t* pData, size_t numElements, ScanPredicate predicate,
+            const ScanOperand<uint32_t>& operand, uint32_t* pIndicesOut, size_t maxIndices);
+
+        size_t FilterCandidates(const uint8_t* pOld, const uint8_t* pNew, size_t numElements,
+            ScanPredicate predicate, const ScanOperand<uint8_t>& operand, uint64_t* pCandidateBits);
+        size_t FilterCandidates(const uint16_t* pOld, const uint16_t* pNew, size_t numElements,
+            ScanPredicate predicate, const ScanOperand<uint16_t>& operand, uint64_t* pCandidateBits);
+        size_t FilterCandidates(const uint32_t* pOld, const uint32_t* pNew, size_t numElements,
+            ScanPredicate predicate, const ScanOperand<uint32_t>& operand, uint64_t* pCandidateBits);
+    }
+}
+#endif // SCANKERNELS_X86
@@ -0,0 +1,241 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "bitutils.h"
+#include "scanpredicate.h"
+
+//----------------------------------------------------------------------------
+// Instruction set agnostic kernel bodies, included by each per-target
+// translation unit after it has defined its vector operations and switched
+// the compiler to that target.
+//
+// TOps must provide:
+//   Element, Vec, kLanes (a divisor of 64)
+//   Load, Splat, CmpEq, CmpGtUnsigned, Add, Sub, And, Or
+//   LaneMask - one bit per lane of a comparison result
+//
+// Everything here has internal linkage on purpose: each target gets its own
+// copy, so no instantiation compiled for a wide target can be picked by the
+// linker for code that runs on every CPU.
+//----------------------------------------------------------------------------
+
+namespace
+{
+    inline bool EmitLaneMask(uint32_t mask, size_t baseIndex, uint32_t* pIndicesOut, size_t* pNumFound, size_t maxIndices)
+    {
+        while (mask)
+        {
+            if (*pNumFound >= maxIndices)
+            {
+                return false;
+            }
+
+            pIndicesOut[(*pNumFound)++] = static_cast<uint32_t>(baseIndex + CountTrailingZeros32(mask));
+            mask &= mask - 1;
+        }
+
+        return true;
+    }
+
+    // The operand values splatted across vectors, once per call rather than per block
+    template<typename TOps>
+    struct OperandVecs
+    {
+        typename TOps::Vec Values[kMaxScanOperandValues];
+    };
+
+    template<typename TOps>
+    inline OperandVecs<TOps> SplatOperand(const ScanOperand<typename TOps::Element>& operand)
+    {
+        OperandVecs<TOps> vecs;
+        for (uint32_t i = 0; i < kMaxScanOperandValues; ++i)
+        {
+            vecs.Values[i] = TOps::Splat(operand.Values[i]);
+        }
+
+        return vecs;
+    }
+
+    // The predicate is a template parameter so each loop below compiles down to a
+    // couple of vector instructions with no per-element branching.
+    template<typename TOps, ScanPredicate kPredicate>
+    inline uint32_t MatchMask(typename TOps::Vec oldValues, typename TOps::Vec newValues, const OperandVecs<TOps>& operand)
+    {
+        typedef typename TOps::Vec Vec;
+        constexpr uint32_t AllLanes = TOps::kLanes == 32 ? 0xFFFFFFFFu : ((1u << TOps::kLanes) - 1);
+
+        switch (kPredicate)
+        {
+        case ScanPredicate::Equal:
+            return TOps::LaneMask(TOps::CmpEq(newValues, operand.Values[0]));
+        case ScanPredicate::Changed:
+            return ~TOps::LaneMask(TOps::CmpEq(newValues, oldValues)) & AllLanes;
+        case ScanPredicate::Unchanged:
+            return TOps::LaneMask(TOps::CmpEq(newValues, oldValues));
+        case ScanPredicate::Increased:
+            return TOps::LaneMask(TOps::CmpGtUnsigned(newValues, oldValues));
+        case ScanPredicate::Decreased:
+            return TOps::LaneMask(TOps::CmpGtUnsigned(oldValues, newValues));
+        case ScanPredicate::IncreasedBy:
+            return TOps::LaneMask(TOps::CmpEq(newValues, TOps::Add(oldValues, operand.Values[0])));
+        case ScanPredicate::DecreasedBy:
+            return TOps::LaneMask(TOps::CmpEq(newValues, TOps::Sub(oldValues, operand.Values[0])));
+        case ScanPredicate::InRange:
+        {
+            const Vec OutOfRange = TOps::Or(
+                TOps::CmpGtUnsigned(operand.Values[0], newValues),
+                TOps::CmpGtUnsigned(newValues, operand.Values[1]));
+            return ~TOps::LaneMask(OutOfRange) & AllLanes;
+        }
+        case ScanPredicate::MaskEqual:
+            return TOps::LaneMask(TOps::CmpEq(TOps::And(newValues, operand.Values[0]), operand.Values[1]));
+        case ScanPredicate::AnyOf:
+        {
+            // Unused values repeat the first, so always testing all of them keeps the trip count fixed
+            Vec matches = TOps::CmpEq(newValues, operand.Values[0]);
+            for (uint32_t i = 1; i < kMaxScanOperandValues; ++i)
+            {
+                matches = TOps::Or(matches, TOps::CmpEq(newValues, operand.Values[i]));
+            }
+            return TOps::LaneMask(matches);
+        }
+        }
+
+        return 0;
+    }
+
+    template<typename TOps, ScanPredicate kPredicate>
+    size_t FindMatchesSimd(const typename TOps::Element* pData, size_t numElements, const ScanOperand<typename TOps::Element>& operand,
+        uint32_t* pIndicesOut, size_t maxIndices)
+    {
+        typedef typename TOps::Vec Vec;
+
+        const OperandVecs<TOps> Operand = SplatOperand<TOps>(operand);
+        size_t numFound = 0;
+        size_t index = 0;
+        for (; index + TOps::kLanes <= numElements; index += TOps::kLanes)
+        {
+            // Value predicates never look at the old side
+            const Vec Values = TOps::Load(pData + index);
+            const uint32_t Mask = MatchMask<TOps, kPredicate>(Values, Values, Operand);
+            if (Mask && !EmitLaneMask(Mask, index, pIndicesOut, &numFound, maxIndices))
+            {
+                return numFound;
+            }
+        }
+
+        for (; index < numElements && numFound < maxIndices; ++index)
+        {
+            if (MatchesPredicate(kPredicate, pData[index], pData[index], operand))
+            {
+                pIndicesOut[numFound++] = static_cast<uint32_t>(index);
+            }
+        }
+
+        return numFound;
+    }
+
+    template<typename TOps>
+    size_t FindMatchesDispatch(const typename TOps::Element* pData, size_t numElements, ScanPredicate predicate,
+        const ScanOperand<typename TOps::Element>& operand, uint32_t* pIndicesOut, size_t maxIndices)
+    {
+        switch (predicate)
+        {
+        case ScanPredicate::Equal:
+            return FindMatchesSimd<TOps, ScanPredicate::Equal>(pData, numElements, operand, pIndicesOut, maxIndices);
+        case ScanPredicate::InRange:
+            return FindMatchesSimd<TOps, ScanPredicate::InRange>(pData, numElements, operand, pIndicesOut, maxIndices);
+        case ScanPredicate::MaskEqual:
+            return FindMatchesSimd<TOps, ScanPredicate::MaskEqual>(pData, numElements, operand, pIndicesOut, maxIndices);
+        case ScanPredicate::AnyOf:
+            return FindMatchesSimd<TOps, ScanPredicate::AnyOf>(pData, numElements, operand, pIndicesOut, maxIndices);
+        default:
+            // The others need a snapshot to compare against
+            return 0;
+        }
+    }
+
+    template<typename TOps, ScanPredicate kPredicate>
+    size_t FilterCandidatesSimd(const typename TOps::Element* pOld, const typename TOps::Element* pNew, size_t numElements,
+        const ScanOperand<typename TOps::Element>& operand, uint64_t* pCandidateBits)
+    {
+        const OperandVecs<TOps> Operand = SplatOperand<TOps>(operand);
+        const size_t NumFullWords = numElements / 64;
+        size_t numRemaining = 0;
+        for (size_t word = 0; word < NumFullWords; ++word)
+        {
+            uint64_t candidates = pCandidateBits[word];
+            if (candidates == 0)
+            {
+                // Nothing left to test in this block, don't even touch the data
+                continue;
+            }
+
+            uint64_t matches = 0;
+            for (size_t lane = 0; lane < 64; lane += TOps::kLanes)
+            {
+                const size_t Index = word * 64 + lane;
+                const uint32_t Mask = MatchMask<TOps, kPredicate>(TOps::Load(pOld + Index), TOps::Load(pNew + Index), Operand);
+                matches |= static_cast<uint64_t>(Mask) << lane;
+            }
+
+            candidates &= matches;
+            pCandidateBits[word] = candidates;
+            numRemaining += PopCount64(candidates);
+        }
+
+        for (size_t index = NumFullWords * 64; index < numElements; ++index)
+        {
+            const uint64_t Bit = 1ull << (index & 63);
+            uint64_t& candidates = pCandidateBits[index / 64];
+            if ((candidates & Bit) == 0)
+            {
+                continue;
+            }
+
+            if (MatchesPredicate(kPredicate, pOld[index], pNew[index], operand))
+            {
+                ++numRemaining;
+            }
+            else
+            {
+                candidates &= ~Bit;
+            }
+        }
+
+        return numRemaining;
+    }
+
+    template<typename TOps>
+    size_t FilterCandidatesDispatch(const typename TOps::Element* pOld, const typename TOps::Element* pNew, size_t numElements,
+        ScanPredicate predicate, const ScanOperand<typename TOps::Element>& operand, uint64_t* pCandidateBits)
+    {
+        switch (predicate)
+        {
+        case ScanPredicate::Equal:
+            return FilterCandidatesSimd<TOps, ScanPredicate::Equal>(pOld, pNew, numElements, operand, pCandidateBits);
+        case ScanPredicate::Changed:
+            return FilterCandidatesSimd<TOps, ScanPredicate::Changed>(pOld, pNew, numElements, operand, pCandidateBits);
+        case ScanPredicate::Unchanged:
+            return FilterCandidatesSimd<TOps, ScanPredicate::Unchanged>(pOld, pNew, numElements, operand, pCandidateBits);
+        case ScanPredicate::Increased:
+            return FilterCandidatesSimd<TOps, ScanPredicate::Increased>(pOld, pNew, numElements, operand, pCandidateBits);
+        case ScanPredicate::Decreased:
+            return FilterCandidatesSimd<TOps, ScanPredicate::Decreased>(pOld, pNew, numElements, operand, pCandidateBits);
+        case ScanPredicate::IncreasedBy:
+            return FilterCandidatesSimd<TOps, ScanPredicate::IncreasedBy>(pOld, pNew, numElements, operand, pCandidateBits);
+        case ScanPredicate::DecreasedBy:
+            return FilterCandidatesSimd<TOps, ScanPredicate::DecreasedBy>(pOld, pNew, numElements, operand, pCandidateBits);
+        case ScanPredicate::InRange:
+            return FilterCandidatesSimd<TOps, ScanPredicate::InRange>(pOld, pNew, numElements, operand, pCandidateBits);
+        case ScanPredicate::MaskEqual:
+            return FilterCandidatesSimd<TOps, ScanPredicate::MaskEqual>(pOld, pNew, numElements, operand, pCandidateBits);
+        case ScanPredicate::AnyOf:
+            return FilterCandidatesSimd<TOps, ScanPredicate::AnyOf>(pOld, pNew, numElements, operand, pCandidateBits);
+        }
+
+        return 0;
+    }
+}
@@ -0,0 +1,142 @@
+#include <cstddef>
+#include <cstdint>
+
+#include "bitutils.h"
+#include "scankernels_impl.h"
+
+#if SCANKERNELS_X86
+#include <emmintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("sse2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#endif
+
+namespace
+{
+    //------------------------------------------------------------------------
+    // SSE2 has no unsigned comparisons, so both sides are biased by the sign
+    // bit and compared signed instead.
+    //------------------------------------------------------------------------
+
+    struct Sse2Ops8
+    {
+        typedef uint8_t Element;
+        typedef __m128i Vec;
+        static constexpr size_t kLanes = 16;
+
+        static Vec Load(const Element* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+        static Vec Splat(Element value) { return _mm_set1_epi8(static_cast<char>(value)); }
+        static Vec CmpEq(Vec a, Vec b) { return _mm_cmpeq_epi8(a, b); }
+        static Vec CmpGtUnsigned(Vec a, Vec b)
+        {
+            const Vec Bias = _mm_set1_epi8(static_cast<char>(0x80));
+            return _mm_cmpgt_epi8(_mm_xor_si128(a, Bias), _mm_xor_si128(b, Bias));
+        }
+        static Vec Add(Vec a, Vec b) { return _mm_add_epi8(a, b); }
+        static Vec Sub(Vec a, Vec b) { return _mm_sub_epi8(a, b); }
+        static Vec And(Vec a, Vec b) { return _mm_and_si128(a, b); }
+        static Vec Or(Vec a, Vec b) { return _mm_or_si128(a, b); }
+        static uint32_t LaneMask(Vec cmp) { return static_cast<uint32_t>(_mm_movemask_epi8(cmp)); }
+    };
+
+    struct Sse2Ops16
+    {
+        typedef uint16_t Element;
+        typedef __m128i Vec;
+        static constexpr size_t kLanes = 8;
+
+        static Vec Load(const Element* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+        static Vec Splat(Element value) { return _mm_set1_epi16(static_cast<short>(value)); }
+        static Vec CmpEq(Vec a, Vec b) { return _mm_cmpeq_epi16(a, b); }
+        static Vec CmpGtUnsigned(Vec a, Vec b)
+        {
+            const Vec Bias = _mm_set1_epi16(static_cast<short>(0x8000));
+            return _mm_cmpgt_epi16(_mm_xor_si128(a, Bias), _mm_xor_si128(b, Bias));
+        }
+        static Vec Add(Vec a, Vec b) { return _mm_add_epi16(a, b); }
+        static Vec Sub(Vec a, Vec b) { return _mm_sub_epi16(a, b); }
+        static Vec And(Vec a, Vec b) { return _mm_and_si128(a, b); }
+        static Vec Or(Vec a, Vec b) { return _mm_or_si128(a, b); }
+        static uint32_t LaneMask(Vec cmp)
+        {
+            // Narrow each all-ones/all-zeroes lane to a byte first so the byte mask has one bit per lane
+            return static_cast<uint32_t>(_mm_movemask_epi8(_mm_packs_epi16(cmp, _mm_setzero_si128()))) & 0xFFu;
+        }
+    };
+
+    struct Sse2Ops32
+    {
+        typedef uint32_t Element;
+        typedef __m128i Vec;
+        static constexpr size_t kLanes = 4;
+
+        static Vec Load(const Element* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+        static Vec Splat(Element value) { return _mm_set1_epi32(static_cast<int>(value)); }
+        static Vec CmpEq(Vec a, Vec b) { return _mm_cmpeq_epi32(a, b); }
+        static Vec CmpGtUnsigned(Vec a, Vec b)
+        {
+            const Vec Bias = _mm_set1_epi32(static_cast<int>(0x80000000u));
+            return _mm_cmpgt_epi32(_mm_xor_si128(a, Bias), _mm_xor_si128(b, Bias));
+        }
+        static Vec Add(Vec a, Vec b) { return _mm_add_epi32(a, b); }
+        static Vec Sub(Vec a, Vec b) { return _mm_sub_epi32(a, b); }
+        static Vec And(Vec a, Vec b) { return _mm_and_si128(a, b); }
+        static Vec Or(Vec a, Vec b) { return _mm_or_si128(a, b); }
+        static uint32_t LaneMask(Vec cmp) { return static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(cmp))); }
+    };
+}
+
+#include "scankernels_simd.h"
+
+namespace ScanKernels
+{
+    namespace Sse2
+    {
+        size_t FindMatches(const uint8_t* pData, size_t numElements, ScanPredicate predicate,
+            const ScanOperand<uint8_t>& operand, uint32_t* pIndicesOut, size_t maxIndices)
+        {
+            return FindMatchesDispatch<Sse2Ops8>(pData, numElements, predicate, operand, pIndicesOut, maxIndices);
+        }
+
+        size_t FindMatches(const uint16_t* pData, size_t numElements, ScanPredicate predicate,
+            const ScanOperand<uint16_t>& operand, uint32_t* pIndicesOut, size_t maxIndices)
+        {
+            return FindMatchesDispatch<Sse2Ops16>(pData, numElements, predicate, operand, pIndicesOut, maxIndices);
+        }
+
+        size_t FindMatches(const uint32_t* pData, size_t numElements, ScanPredicate predicate,
+            const ScanOperand<uint32_t>& operand, uint32_t* pIndicesOut, size_t maxIndices)
+        {
+            return FindMatchesDispatch<Sse2Ops32>(pData, numElements, predicate, operand, pIndicesOut, maxIndices);
+        }
+
+        size_t FilterCandidates(const uint8_t* pOld, const uint8_t* pNew, size_t numElements,
+            ScanPredicate predicate, const ScanOperand<uint8_t>& operand, uint64_t* pCandidateBits)
+        {
+            return FilterCandidatesDispatch<Sse2Ops8>(pOld, pNew, numElements, predicate, operand, pCandidateBits);
+        }
+
+        size_t FilterCandidates(const uint16_t* pOld, const uint16_t* pNew, size_t numElements,
+            ScanPredicate predicate, const ScanOperand<uint16_t>& operand, uint64_t* pCandidateBits)
+        {
+            return FilterCandidatesDispatch<Sse2Ops16>(pOld, pNew, numElements, predicate, operand, pCandidateBits);
+        }
+
+        size_t FilterCandidates(const uint32_t* pOld, const uint32_t* pNew, size_t numElements,
+            ScanPredicate predicate, const ScanOperand<uint32_t>& operand, uint64_t* pCandidateBits)
+        {
+            return FilterCandidatesDispatch<Sse2Ops32>(pOld, pNew, numElements, predicate, operand, pCandidateBits);
+        }
+    }
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif // SCANKERNELS_X86
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstdint>
+
+//----------------------------------------------------------------------------
+// Predicates a scan can filter hits with. Equal, InRange, MaskEqual and AnyOf
+// only look at the current value of a hit, so they can start a new scan.
+// Everything else compares the current value against the value seen by the
+// previous scan of the same slot, which is what makes unknown-initial-value
+// searches possible.
+//----------------------------------------------------------------------------
+
+enum class ScanPredicate : uint8_t
+{
+    Equal,
+    Changed,
+    Unchanged,
+    Increased,
+    Decreased,
+    IncreasedBy,
+    DecreasedBy,
+    InRange,
+    MaskEqual,
+    AnyOf,
+};
+
+// The most values an AnyOf scan can match
+constexpr uint32_t kMaxScanOperandValues = 8;
+
+// The values a predicate compares against:
+//   Equal                     Values[0]
+//   IncreasedBy, DecreasedBy  Values[0] is the delta
+//   InRange                   Values[0] <= value <= Values[1]
+//   MaskEqual                 (value & Values[0]) == Values[1]
+//   AnyOf                     any of Values[0] to Values[NumValues - 1]
+// Values past NumValues repeat Values[0], so the vector kernels can always
+// test all of them without changing the result.
+template<typename TScanType>
+struct ScanOperand
+{
+    TScanType Values[kMaxScanOperandValues];
+    uint32_t NumValues;
+};
+
+template<typename TScanType>
+inline ScanOperand<TScanType> MakeScanOperand(const TScanType* pValues, uint32_t numValues)
+{
+    ScanOperand<TScanType> operand;
+    operand.NumValues = numValues;
+    for (uint32_t i = 0; i < kMaxScanOperandValues; ++i)
+    {
+        operand.Values[i] = i < numValues ? pValues[i] : pValues[0];
+    }
+
+    return operand;
+}
+
+template<typename TScanType>
+inline ScanOperand<TScanType> MakeScanOperand(TScanType value)
+{
+    return MakeScanOperand(&value, 1);
+}
+
+constexpr bool PredicateUsesSnapshot(ScanPredicate predicate)
+{
+    return predicate != ScanPredicate::Equal &&
+           predicate != ScanPredicate::InRange &&
+           predicate != ScanPredicate::MaskEqual &&
+           predicate != ScanPredicate::AnyOf;
+}
+
+// How many operand values a predicate needs at least
+constexpr uint32_t GetMinOperandValues(ScanPredicate predicate)
+{
+    return predicate == ScanPredicate::InRange || predicate == ScanPredicate::MaskEqual ? 2
+         : predicate == ScanPredicate::Equal ||
+           predicate == ScanPredicate::IncreasedBy ||
+           predicate == ScanPredicate::DecreasedBy ||
+           predicate == ScanPredicate::AnyOf ? 1
+         : 0;
+}
+
+// How many operand values a predicate takes at most
+constexpr uint32_t GetMaxOperandValues(ScanPredicate predicate)
+{
+    return predicate == ScanPredicate::AnyOf ? kMaxScanOperandValues : GetMinOperandValues(predicate);
+}
+
+// Scalar reference for the vectorized kernels. Values are compared unsigned and
+// the "by N" predicates wrap around like the 68K's own arithmetic does.
+template<typename TScanType>
+inline bool MatchesPredicate(ScanPredicate predicate, TScanType oldValue, TScanType newValue, const ScanOperand<TScanType>& operand)
+{
+    switch (predicate)
+    {
+    case ScanPredicate::Equal:
+        return newValue == operand.Values[0];
+    case ScanPredicate::Changed:
+        return newValue != oldValue;
+    case ScanPredicate::Unchanged:
+        return newValue == oldValue;
+    case ScanPredicate::Increased:
+        return newValue > oldValue;
+    case ScanPredicate::Decreased:
+        return newValue < oldValue;
+    case ScanPredicate::IncreasedBy:
+        return newValue == static_cast<TScanType>(oldValue + operand.Values[0]);
+    case ScanPredicate::DecreasedBy:
+        return newValue == static_cast<TScanType>(oldValue - operand.Values[0]);
+    case ScanPredicate::InRange:
+        return newValue >= operand.Values[0] && newValue <= operand.Values[1];
+    case ScanPredicate::MaskEqual:
+        return (newValue & operand.Values[0]) == operand.Values[1];
+    case ScanPredicate::AnyOf:
+        for (uint32_t i = 0; i < operand.NumValues; ++i)
+        {
+            if (newValue == operand.Values[i])
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    return false;
+}
@@ -0,0 +1,117 @@
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "symbolcache.h"
+
+SymbolCache::SymbolCache(ISymbolProvider& provider)
+    : m_provider(provider)
+{
+}
+
+bool SymbolCache::GetSymbolAddress(const char* pSymbol, uint64_t* pAddressOut)
+{
+    RevalidateIfRequested();
+
+    const std::string Key(pSymbol);
+    const auto It = m_symbolAddresses.find(Key);
+    if (It != m_symbolAddresses.end())
+    {
+        *pAddressOut = It->second;
+        return true;
+    }
+
+    uint64_t address;
+    if (!m_provider.GetSymbolAddress(pSymbol, &address))
+    {
+        return false;
+    }
+
+    // Unqualified symbols can't be tied to a module, so they're only dropped by Invalidate()
+    const char* pBang = strchr(pSymbol, '!');
+    if (pBang)
+    {
+        TrackModule(std::string(pSymbol, pBang));
+    }
+
+    m_symbolAddresses.emplace(Key, address);
+    *pAddressOut = address;
+    return true;
+}
+
+bool SymbolCache::GetFieldOffset(const char* pModule, const char* pType, const char* pField, uint32_t* pOffsetOut)
+{
+    RevalidateIfRequested();
+
+    std::string key(pModule);
+    key += '!';
+    key += pType;
+    key += '.';
+    key += pField;
+
+    const auto It = m_fieldOffsets.find(key);
+    if (It != m_fieldOffsets.end())
+    {
+        *pOffsetOut = It->second;
+        return true;
+    }
+
+    uint32_t offset;
+    if (!m_provider.GetFieldOffset(pModule, pType, pField, &offset))
+    {
+        return false;
+    }
+
+    TrackModule(pModule);
+    m_fieldOffsets.emplace(std::move(key), offset);
+    *pOffsetOut = offset;
+    return true;
+}
+
+void SymbolCache::Invalidate()
+{
+    m_symbolAddresses.clear();
+    m_fieldOffsets.clear();
+    m_moduleBases.clear();
+    m_revalidationRequested = false;
+}
+
+void SymbolCache::RequestRevalidation()
+{
+    m_revalidationRequested = true;
+}
+
+void SymbolCache::RevalidateIfRequested()
+{
+    if (!m_revalidationRequested)
+    {
+        return;
+    }
+
+    m_revalidationRequested = false;
+    for (const auto& Module : m_moduleBases)
+    {
+        uint64_t base;
+        if (!m_provider.GetModuleBase(Module.first.c_str(), &base) || base != Module.second)
+        {
+            Invalidate();
+            return;
+        }
+    }
+}
+
+void SymbolCache::TrackModule(const std::string& module)
+{
+    if (m_moduleBases.count(module))
+    {
+        return;
+    }
+
+    uint64_t base;
+    if (m_provider.GetModuleBase(module.c_str(), &base))
+    {
+        m_moduleBases.emplace(module, base);
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+//----------------------------------------------------------------------------
+// Where symbol and type information comes from. The extension answers these
+// through the debugger engine, anything else (tests, replays) can supply its
+// own answers.
+//----------------------------------------------------------------------------
+
+class ISymbolProvider
+{
+public:
+    virtual ~ISymbolProvider() = default;
+
+    virtual bool GetModuleBase(const char* pModule, uint64_t* pBaseOut) = 0;
+
+    // pSymbol is fully qualified, e.g. "module!name"
+    virtual bool GetSymbolAddress(const char* pSymbol, uint64_t* pAddressOut) = 0;
+    virtual bool GetFieldOffset(const char* pModule, const char* pType, const char* pField, uint32_t* pOffsetOut) = 0;
+};
+
+//----------------------------------------------------------------------------
+// Remembers what the provider resolved so commands don't go through the
+// symbol engine every time they run.
+//
+// Everything is dropped on Invalidate(). After RequestRevalidation() the next
+// lookup first checks that every module seen so far is still loaded at the
+// same base, and only drops the cache if one moved or went away. Failed
+// lookups aren't cached, so a symbol resolves as soon as its module loads.
+//----------------------------------------------------------------------------
+
+class SymbolCache
+{
+public:
+    explicit SymbolCache(ISymbolProvider& provider);
+
+    bool GetSymbolAddress(const char* pSymbol, uint64_t* pAddressOut);
+    bool GetFieldOffset(const char* pModule, const char* pType, const char* pField, uint32_t* pOffsetOut);
+
+    void Invalidate();
+    void RequestRevalidation();
+
+private:
+    void RevalidateIfRequested();
+    void TrackModule(const std::string& module);
+
+    ISymbolProvider& m_provider;
+
+    std::unordered_map<std::string, uint64_t> m_symbolAddresses;
+
+    // Keyed by "module!type.field"
+    std::unordered_map<std::string, uint32_t> m_fieldOffsets;
+
+    // Base of every module the cached entries came from, as of when they were resolved
+    std::unordered_map<std::string, uint64_t> m_moduleBases;
+
+    bool m_revalidationRequested = false;
+};
@@ -0,0 +1,358 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "tracesources.h"
+
+namespace
+{
+    // Finds the stretch of events between TargetRan markers that eventIndex lies in
+    void FindStretch(const std::vector<TraceEvent>& events, size_t eventIndex, size_t* pBeginOut, size_t* pEndOut)
+    {
+        size_t begin = std::min(eventIndex, events.size());
+        while (begin > 0 && events[begin - 1].Kind != TraceEventKind::TargetRan)
+        {
+            --begin;
+        }
+
+        size_t end = std::min(eventIndex, events.size());
+        while (end < events.size() && events[end].Kind != TraceEventKind::TargetRan)
+        {
+            ++end;
+        }
+
+        *pBeginOut = begin;
+        *pEndOut = end;
+    }
+}
+
+//----------------------------------------------------------------------------
+//
+// RecordingMemorySource
+//
+//----------------------------------------------------------------------------
+
+RecordingMemorySource::RecordingMemorySource(IMemorySource& inner)
+    : m_inner(inner)
+{
+}
+
+void RecordingMemorySource::SetWriter(TraceWriter* pWriter)
+{
+    m_pWriter = pWriter;
+}
+
+bool RecordingMemorySource::Read(uint64_t address, void* pBuffer, uint32_t size)
+{
+    const bool Succeeded = m_inner.Read(address, pBuffer, size);
+    if (m_pWriter)
+    {
+        m_pWriter->WriteRead(address, pBuffer, size, Succeeded);
+    }
+
+    return Succeeded;
+}
+
+bool RecordingMemorySource::ReadScatter(ScatterReadEntry* pEntries, size_t numEntries)
+{
+    const bool Succeeded = m_inner.ReadScatter(pEntries, numEntries);
+    if (m_pWriter)
+    {
+        m_pWriter->WriteScatterBatch(numEntries);
+        for (size_t i = 0; i < numEntries; ++i)
+        {
+            m_pWriter->WriteRead(pEntries[i].Address, pEntries[i].pBuffer, pEntries[i].Size, pEntries[i].Succeeded);
+        }
+    }
+
+    return Succeeded;
+}
+
+void RecordingMemorySource::EnumerateRegions(std::vector<MemoryRegionInfo>& regionsOut)
+{
+    m_inner.EnumerateRegions(regionsOut);
+    if (m_pWriter)
+    {
+        m_pWriter->WriteRegions(regionsOut);
+    }
+}
+
+// Bytes handed out in place never show up as reads, so none are while recording
+const uint8_t* RecordingMemorySource::GetDirectPointer(uint64_t address, uint32_t size)
+{
+    return m_pWriter ? nullptr : m_inner.GetDirectPointer(address, size);
+}
+
+//----------------------------------------------------------------------------
+//
+// RecordingSymbolProvider
+//
+//----------------------------------------------------------------------------
+
+RecordingSymbolProvider::RecordingSymbolProvider(ISymbolProvider& inner)
+    : m_inner(inner)
+{
+}
+
+void RecordingSymbolProvider::SetWriter(TraceWriter* pWriter)
+{
+    m_pWriter = pWriter;
+}
+
+bool RecordingSymbolProvider::GetModuleBase(const char* pModule, uint64_t* pBaseOut)
+{
+    const bool Found = m_inner.GetModuleBase(pModule, pBaseOut);
+    if (m_pWriter)
+    {
+        m_pWriter->WriteModuleBase(pModule, Found, Found ? *pBaseOut : 0);
+    }
+
+    return Found;
+}
+
+bool RecordingSymbolProvider::GetSymbolAddress(const char* pSymbol, uint64_t* pAddressOut)
+{
+    const bool Found = m_inner.GetSymbolAddress(pSymbol, pAddressOut);
+    if (m_pWriter)
+    {
+        m_pWriter->WriteSymbolAddress(pSymbol, Found, Found ? *pAddressOut : 0);
+    }
+
+    return Found;
+}
+
+bool RecordingSymbolProvider::GetFieldOffset(const char* pModule, const char* pType, const char* pField, uint32_t* pOffsetOut)
+{
+    const bool Found = m_inner.GetFieldOffset(pModule, pType, pField, pOffsetOut);
+    if (m_pWriter)
+    {
+        m_pWriter->WriteFieldOffset(pModule, pType, pField, Found, Found ? *pOffsetOut : 0);
+    }
+
+    return Found;
+}
+
+//----------------------------------------------------------------------------
+//
+// ReplayMemorySource
+//
+//----------------------------------------------------------------------------
+
+ReplayMemorySource::ReplayMemorySource(const MemoryTrace& trace)
+    : m_trace(trace)
+{
+}
+
+void ReplayMemorySource::SeekToEvent(size_t eventIndex)
+{
+    const std::vector<TraceEvent>& Events = m_trace.GetEvents();
+    size_t begin;
+    size_t end;
+    FindStretch(Events, eventIndex, &begin, &end);
+    if (begin == m_stretchBegin)
+    {
+        return;
+    }
+
+    m_stretchBegin = begin;
+    m_pages.clear();
+    m_regions.clear();
+    for (size_t i = begin; i < end; ++i)
+    {
+        const TraceEvent& Event = Events[i];
+        if (Event.Kind == TraceEventKind::Read && Event.Succeeded)
+        {
+            AddBytes(Event.Address, m_trace.GetReadData(Event), Event.Size);
+        }
+        else if (Event.Kind == TraceEventKind::Regions)
+        {
+            const MemoryRegionInfo* pRegions = m_trace.GetRegions(Event);
+            m_regions.assign(pRegions, pRegions + Event.Size);
+        }
+    }
+}
+
+const ReplayCounters& ReplayMemorySource::GetCounters() const
+{
+    return m_counters;
+}
+
+void ReplayMemorySource::ResetCounters()
+{
+    m_counters = {};
+}
+
+bool ReplayMemorySource::Read(uint64_t address, void* pBuffer, uint32_t size)
+{
+    ++m_counters.Reads;
+    m_counters.ReadBytes += size;
+    if (!CopyBytes(address, static_cast<uint8_t*>(pBuffer), size))
+    {
+        ++m_counters.MissingReads;
+        return false;
+    }
+
+    return true;
+}
+
+// A batch is a single request, however many entries it has
+bool ReplayMemorySource::ReadScatter(ScatterReadEntry* pEntries, size_t numEntries)
+{
+    ++m_counters.ScatterBatches;
+
+    bool allSucceeded = true;
+    for (size_t i = 0; i < numEntries; ++i)
+    {
+        ScatterReadEntry& entry = pEntries[i];
+        m_counters.ReadBytes += entry.Size;
+        entry.Succeeded = CopyBytes(entry.Address, static_cast<uint8_t*>(entry.pBuffer), entry.Size);
+        if (!entry.Succeeded)
+        {
+            ++m_counters.MissingReads;
+            allSucceeded = false;
+        }
+    }
+
+    return allSucceeded;
+}
+
+void ReplayMemorySource::EnumerateRegions(std::vector<MemoryRegionInfo>& regionsOut)
+{
+    regionsOut = m_regions;
+}
+
+void ReplayMemorySource::AddBytes(uint64_t address, const uint8_t* pBytes, uint32_t size)
+{
+    while (size > 0)
+    {
+        const uint32_t PageOffset = static_cast<uint32_t>(address % kPageSize);
+        const uint32_t ChunkSize = std::min(size, kPageSize - PageOffset);
+
+        // New pages come zeroed, so none of their bytes are valid yet
+        Page& page = m_pages[address / kPageSize];
+        memcpy(page.Bytes + PageOffset, pBytes, ChunkSize);
+        for (uint32_t i = PageOffset; i < PageOffset + ChunkSize; ++i)
+        {
+            page.Valid[i / 64] |= 1ull << (i % 64);
+        }
+
+        address += ChunkSize;
+        pBytes += ChunkSize;
+        size -= ChunkSize;
+    }
+}
+
+bool ReplayMemorySource::CopyBytes(uint64_t address, uint8_t* pBuffer, uint32_t size) const
+{
+    while (size > 0)
+    {
+        const uint32_t PageOffset = static_cast<uint32_t>(address % kPageSize);
+        const uint32_t ChunkSize = std::min(size, kPageSize - PageOffset);
+
+        const auto Found = m_pages.find(address / kPageSize);
+        if (Found == m_pages.end())
+        {
+            return false;
+        }
+
+        const Page& Stored = Found->second;
+        for (uint32_t i = PageOffset; i < PageOffset + ChunkSize; ++i)
+        {
+            if ((Stored.Valid[i / 64] & (1ull << (i % 64))) == 0)
+            {
+                return false;
+            }
+        }
+        memcpy(pBuffer, Stored.Bytes + PageOffset, ChunkSize);
+
+        address += ChunkSize;
+        pBuffer += ChunkSize;
+        size -= ChunkSize;
+    }
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+//
+// ReplaySymbolProvider
+//
+//----------------------------------------------------------------------------
+
+ReplaySymbolProvider::ReplaySymbolProvider(const MemoryTrace& trace)
+    : m_trace(trace)
+{
+}
+
+void ReplaySymbolProvider::SeekToEvent(size_t eventIndex)
+{
+    const std::vector<TraceEvent>& Events = m_trace.GetEvents();
+    size_t begin;
+    size_t end;
+    FindStretch(Events, eventIndex, &begin, &end);
+    if (end == m_stretchEnd)
+    {
+        return;
+    }
+
+    m_stretchEnd = end;
+    m_moduleBases.clear();
+    m_symbolAddresses.clear();
+    m_fieldOffsets.clear();
+    for (size_t i = 0; i < end; ++i)
+    {
+        const TraceEvent& Event = Events[i];
+        switch (Event.Kind)
+        {
+        case TraceEventKind::ModuleBase:
+            m_moduleBases[Event.Name] = { Event.Succeeded, Event.Address };
+            break;
+        case TraceEventKind::SymbolAddress:
+            m_symbolAddresses[Event.Name] = { Event.Succeeded, Event.Address };
+            break;
+        case TraceEventKind::FieldOffset:
+            m_fieldOffsets[Event.Name] = { Event.Succeeded, Event.Size };
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+bool ReplaySymbolProvider::GetModuleBase(const char* pModule, uint64_t* pBaseOut)
+{
+    return Lookup(m_moduleBases, pModule, pBaseOut);
+}
+
+bool ReplaySymbolProvider::GetSymbolAddress(const char* pSymbol, uint64_t* pAddressOut)
+{
+    return Lookup(m_symbolAddresses, pSymbol, pAddressOut);
+}
+
+bool ReplaySymbolProvider::GetFieldOffset(const char* pModule, const char* pType, const char* pField, uint32_t* pOffsetOut)
+{
+    uint64_t offset;
+    if (!Lookup(m_fieldOffsets, std::string(pModule) + "!" + pType + "." + pField, &offset))
+    {
+        return false;
+    }
+
+    *pOffsetOut = static_cast<uint32_t>(offset);
+    return true;
+}
+
+bool ReplaySymbolProvider::Lookup(const std::unordered_map<std::string, Answer>& answers, const std::string& key, uint64_t* pValueOut)
+{
+    const auto Found = answers.find(key);
+    if (Found == answers.end() || !Found->second.Found)
+    {
+        return false;
+    }
+
+    *pValueOut = Found->second.Value;
+    return true;
+}
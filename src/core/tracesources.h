@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "memorysource.h"
+#include "memorytrace.h"
+#include "symbolcache.h"
+
+//----------------------------------------------------------------------------
+// Memory source and symbol provider that pass everything through to another
+// one, writing each request and its answer to a trace while one is attached.
+//----------------------------------------------------------------------------
+
+class RecordingMemorySource : public IMemorySource
+{
+public:
+    explicit RecordingMemorySource(IMemorySource& inner);
+
+    // Null stops recording
+    void SetWriter(TraceWriter* pWriter);
+
+    bool Read(uint64_t address, void* pBuffer, uint32_t size) override;
+    bool ReadScatter(ScatterReadEntry* pEntries, size_t numEntries) override;
+    void EnumerateRegions(std::vector<MemoryRegionInfo>& regionsOut) override;
+    const uint8_t* GetDirectPointer(uint64_t address, uint32_t size) override;
+
+private:
+    IMemorySource& m_inner;
+    TraceWriter* m_pWriter = nullptr;
+};
+
+class RecordingSymbolProvider : public ISymbolProvider
+{
+public:
+    explicit RecordingSymbolProvider(ISymbolProvider& inner);
+
+    // Null stops recording
+    void SetWriter(TraceWriter* pWriter);
+
+    bool GetModuleBase(const char* pModule, uint64_t* pBaseOut) override;
+    bool GetSymbolAddress(const char* pSymbol, uint64_t* pAddressOut) override;
+    bool GetFieldOffset(const char* pModule, const char* pType, const char* pField, uint32_t* pOffsetOut) override;
+
+private:
+    ISymbolProvider& m_inner;
+    TraceWriter* m_pWriter = nullptr;
+};
+
+//----------------------------------------------------------------------------
+// Memory source and symbol provider answering from a recorded trace.
+//
+// The target only changes while it runs, so the trace is replayed one
+// stretch between TargetRan markers at a time. Within a stretch, any read
+// of bytes that some recorded read of the same stretch fetched succeeds,
+// whatever the shape of the original reads. That lets a command run against
+// a trace taken with older code, and how many requests it makes compared to
+// the recording is exactly what the replay is there to measure.
+//----------------------------------------------------------------------------
+
+// Requests made of a replay source since its counters were last reset
+struct ReplayCounters
+{
+    uint64_t Reads;
+    uint64_t ScatterBatches;
+    uint64_t ReadBytes;
+
+    // Reads of bytes the trace doesn't have, which fail. A command making any
+    // of these has changed what it reads since the trace was recorded.
+    uint64_t MissingReads;
+};
+
+class ReplayMemorySource : public IMemorySource
+{
+public:
+    explicit ReplayMemorySource(const MemoryTrace& trace);
+
+    // Serves memory as it was in the stretch of the trace containing event eventIndex
+    void SeekToEvent(size_t eventIndex);
+
+    const ReplayCounters& GetCounters() const;
+    void ResetCounters();
+
+    bool Read(uint64_t address, void* pBuffer, uint32_t size) override;
+    bool ReadScatter(ScatterReadEntry* pEntries, size_t numEntries) override;
+    void EnumerateRegions(std::vector<MemoryRegionInfo>& regionsOut) override;
+
+private:
+    static constexpr uint32_t kPageSize = 0x1000;
+
+    struct Page
+    {
+        uint8_t Bytes[kPageSize];
+        // One bit per byte of the page that the trace has
+        uint64_t Valid[kPageSize / 64];
+    };
+
+    void AddBytes(uint64_t address, const uint8_t* pBytes, uint32_t size);
+    bool CopyBytes(uint64_t address, uint8_t* pBuffer, uint32_t size) const;
+
+    const MemoryTrace& m_trace;
+    size_t m_stretchBegin = SIZE_MAX;
+    ReplayCounters m_counters = {};
+
+    // Every byte read during the current stretch, by page number
+    std::unordered_map<uint64_t, Page> m_pages;
+    std::vector<MemoryRegionInfo> m_regions;
+};
+
+class ReplaySymbolProvider : public ISymbolProvider
+{
+public:
+    explicit ReplaySymbolProvider(const MemoryTrace& trace);
+
+    // Answers with the latest answers recorded up to the end of the stretch containing eventIndex
+    void SeekToEvent(size_t eventIndex);
+
+    bool GetModuleBase(const char* pModule, uint64_t* pBaseOut) override;
+    bool GetSymbolAddress(const char* pSymbol, uint64_t* pAddressOut) override;
+    bool GetFieldOffset(const char* pModule, const char* pType, const char* pField, uint32_t* pOffsetOut) override;
+
+private:
+    struct Answer
+    {
+        bool Found;
+        uint64_t Value;
+    };
+
+    static bool Lookup(const std::unordered_map<std::string, Answer>& answers, const std::string& key, uint64_t* pValueOut);
+
+    const MemoryTrace& m_trace;
+    size_t m_stretchEnd = SIZE_MAX;
+
+    std::unordered_map<std::string, Answer> m_moduleBases;
+    std::unordered_map<std::string, Answer> m_symbolAddresses;
+    // Keyed by "module!type.field"
+    std::unordered_map<std::string, Answer> m_fieldOffsets;
+};
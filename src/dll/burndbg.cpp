@@ -9,45 +9,74 @@
 //
 //----------------------------------------------------------------------------
 
-#include <cassert>
+#include <cstdarg>
 #include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
 
 #include <engextcpp.hpp>
+#include "dbgengmemorysource.h"
+#include "dbgengsymbolprovider.h"
+#include "fbneosession.h"
+#include "memorytrace.h"
 #include "memscanslot.h"
-
-//----------------------------------------------------------------------------
-// Constants yoinked from FBNeo.
-//----------------------------------------------------------------------------
-constexpr unsigned int SEK_SHIFT = 10;
-constexpr unsigned int SEK_PAGE_SIZE = (1 << SEK_SHIFT);
-constexpr unsigned int SEK_PAGE_MASK = SEK_PAGE_SIZE - 1;
+#include "tracesources.h"
 
 //----------------------------------------------------------------------------
 // Base extension class.
 // Extensions derive from the provided ExtExtension class.
+//
+// The commands themselves live in FBNeoSession, which the extension feeds
+// with target memory and symbols from the engine and whose output it passes
+// on to the debugger.
 //----------------------------------------------------------------------------
 
-class EXT_CLASS : public ExtExtension
+class EXT_CLASS : public ExtExtension, private ICommandOutput
 {
 public:
     EXT_COMMAND_METHOD(membase);
     EXT_COMMAND_METHOD(readb);
+    EXT_COMMAND_METHOD(readw);
+    EXT_COMMAND_METHOD(readl);
+    EXT_COMMAND_METHOD(readrange);
     EXT_COMMAND_METHOD(memscan);
     EXT_COMMAND_METHOD(slotclear);
     EXT_COMMAND_METHOD(slotinfo);
     EXT_COMMAND_METHOD(slotls);
+    EXT_COMMAND_METHOD(readcache);
+    EXT_COMMAND_METHOD(bdstats);
+    EXT_COMMAND_METHOD(bdtrace);
+
+    HRESULT Initialize() override;
+    void OnSessionActive(ULONG64 Argument) override;
+    void OnSessionInactive(ULONG64 Argument) override;
+    void OnSessionAccessible(ULONG64 Argument) override;
 
 private:
-    // Helpers and such
-    ExtRemoteTyped GetM68KRAMBase() const;
-    ExtRemoteTyped GetM68KMemoryMap() const;
+    // ICommandOutput
+    void OutVa(const char* pFormat, va_list args) override;
+    void ErrVa(const char* pFormat, va_list args) override;
 
-    // Memory scan slot data
-    // A slot is either empty or contains some number of hits against a previous search
-    static constexpr uint8_t kMaxMemScanSlots = 4;
-    MemScanSlot m_scanSlots[kMaxMemScanSlots];
+    // Every command backed by the session starts with this
+    void BeginSessionCommand(const char* pName);
 
-    void PrintSlot(uint16_t slotIndex);
+    void StopTrace();
+
+    // Evaluates one memscan value, with plain numbers in decimal when decimal is set
+    ULONG64 EvalScanValue(const std::string& text, bool decimal);
+
+    // All target memory reads and symbol lookups go through here
+    DbgEngMemorySource m_engineMemory;
+    DbgEngSymbolProvider m_engineSymbols;
+    RecordingMemorySource m_memorySource{ m_engineMemory };
+    RecordingSymbolProvider m_symbolProvider{ m_engineSymbols };
+
+    // Open while !bdtrace is recording
+    TraceWriter m_traceWriter;
+    std::string m_tracePath;
+
+    FBNeoSession m_session{ m_memorySource, m_symbolProvider, *this };
 };
 
 // EXT_DECLARE_GLOBALS must be used to instantiate
@@ -57,60 +86,126 @@ EXT_DECLARE_GLOBALS();
 
 //----------------------------------------------------------------------------
 // 
-// Private helper functions
+// Initialization
 // 
 //----------------------------------------------------------------------------
 
-ExtRemoteTyped EXT_CLASS::GetM68KRAMBase() const
+// Commands tend to reread the same few pages of the emulator's memory many times
+// over, so target reads are cached for the length of each command.
+// Listings can run to thousands of lines, which the debugger UI takes far better
+// in a few large chunks.
+HRESULT EXT_CLASS::Initialize()
 {
-    ExtRemoteTyped RamBase("fbneo64d_vs!Neo68KRAM");
-    return RamBase;
+    m_ReadCache.Enable(true);
+    m_OutBuffered = true;
+    return ExtExtension::Initialize();
 }
 
-ExtRemoteTyped EXT_CLASS::GetM68KMemoryMap() const
+//----------------------------------------------------------------------------
+// 
+// Session notifications
+// 
+//----------------------------------------------------------------------------
+
+void EXT_CLASS::OnSessionActive(ULONG64 Argument)
 {
-    ExtRemoteTyped SekExt("fbneo64d_vs!pSekExt");
-    return SekExt.Dereference().Field("MemMap");
+    m_session.Invalidate();
+    ExtExtension::OnSessionActive(Argument);
 }
 
-void EXT_CLASS::PrintSlot(uint16_t slotIndex)
+void EXT_CLASS::OnSessionInactive(ULONG64 Argument)
 {
-    assert(slotIndex < kMaxMemScanSlots);
+    m_session.Invalidate();
+    ExtExtension::OnSessionInactive(Argument);
+}
 
-    MemScanSlot& Slot = m_scanSlots[slotIndex];
-    if (Slot.GetNumEntries() == 0)
+// The target has been running, so modules may have been loaded or unloaded and the
+// game may have remapped memory. Engine interfaces aren't available from here, so
+// any rereading waits for the next command.
+void EXT_CLASS::OnSessionAccessible(ULONG64 Argument)
+{
+    m_session.RequestRevalidation();
+    if (m_traceWriter.IsOpen())
     {
-        Out("Slot %d is clear\n", slotIndex);
+        m_traceWriter.WriteTargetRan();
     }
-    else
+    ExtExtension::OnSessionAccessible(Argument);
+}
+
+//----------------------------------------------------------------------------
+// 
+// Private helper functions
+// 
+//----------------------------------------------------------------------------
+
+// Session output only uses the C runtime's format specifiers, so it's formatted
+// here rather than by the engine
+void EXT_CLASS::OutVa(const char* pFormat, va_list args)
+{
+    va_list argsCopy;
+    va_copy(argsCopy, args);
+    char line[0x200];
+    const int Length = vsnprintf(line, sizeof(line), pFormat, args);
+    if (Length >= 0 && static_cast<size_t>(Length) < sizeof(line))
+    {
+        Out("%s", line);
+    }
+    else if (Length >= 0)
     {
-        Out("Slot %d:\n", slotIndex);
+        std::vector<char> longLine(static_cast<size_t>(Length) + 1);
+        vsnprintf(longLine.data(), longLine.size(), pFormat, argsCopy);
+        Out("%s", longLine.data());
+    }
+    va_end(argsCopy);
+}
 
-        const uint8_t SlotSize = Slot.GetSlotSize();
-        ScanHitEntry* pEntries = Slot.GetEntries();
-        for (uint16_t i = 0; i < Slot.GetNumEntries(); ++i)
-        {
-            const ScanHitEntry& Entry = pEntries[i];
-            assert(Entry.pHitAddress);
+void EXT_CLASS::ErrVa(const char* pFormat, va_list args)
+{
+    char message[0x200];
+    vsnprintf(message, sizeof(message), pFormat, args);
+    Err("%s", message);
+}
 
-            ExtRemoteData EntryData(reinterpret_cast<ULONG64>(Entry.pHitAddress), SlotSize);
-            if (SlotSize == 1)
-            {
-                Out("%d:\t0x%p\t0x%02X\n", i, Entry.pHitAddress, EntryData.GetUchar());
-            }
-            else if (SlotSize == 2)
-            {
-                Out("%d:\t0x%p\t0x%04X\n", i, Entry.pHitAddress, EntryData.GetUshort());
-            }
-            else if (SlotSize == 4)
-            {
-                Out("%d:\t0x%p\t0x%08X\n", i, Entry.pHitAddress, EntryData.GetUlong());
-            }
-        }
-        Out("Listed %d entries\n", Slot.GetNumEntries());
+void EXT_CLASS::BeginSessionCommand(const char* pName)
+{
+    // Memory can be edited from the debugger between commands without the target
+    // running, which the cache wouldn't otherwise hear about
+    m_ReadCache.Flush();
+    m_session.SetPointerSize(m_PtrSize);
+    if (m_traceWriter.IsOpen())
+    {
+        m_traceWriter.WriteCommand(pName, GetRawArgStr());
     }
 }
 
+void EXT_CLASS::StopTrace()
+{
+    if (!m_traceWriter.IsOpen())
+    {
+        return;
+    }
+
+    m_memorySource.SetWriter(nullptr);
+    m_symbolProvider.SetWriter(nullptr);
+    const uint64_t NumBytes = m_traceWriter.GetNumBytesWritten();
+    if (m_traceWriter.Close())
+    {
+        Out("Recorded %I64u KB to %s\n", (NumBytes + 1023) / 1024, m_tracePath.c_str());
+    }
+    else
+    {
+        Err("Failed to write the whole trace to %s\n", m_tracePath.c_str());
+    }
+    m_tracePath.clear();
+}
+
+// Anything with a prefix, a symbol or an operator is left to the debugger's evaluator
+ULONG64 EXT_CLASS::EvalScanValue(const std::string& text, bool decimal)
+{
+    const bool PlainNumber = !text.empty() && text.find_first_not_of("0123456789") == std::string::npos;
+    return EvalExprU64((decimal && PlainNumber ? "0n" + text : text).c_str());
+}
+
 //----------------------------------------------------------------------------
 //
 // membase extension command.
@@ -123,7 +218,8 @@ void EXT_CLASS::PrintSlot(uint16_t slotIndex)
 EXT_COMMAND(membase,
     "Get the base address in FBNeo for m68k RAM",NULL)
 {
-    Out("m68k RAM base: 0x%p\n", GetM68KRAMBase().GetPtr());
+    BeginSessionCommand("membase");
+    m_session.MemBase();
 }
 
 //----------------------------------------------------------------------------
@@ -136,139 +232,290 @@ EXT_COMMAND(membase,
 //
 //----------------------------------------------------------------------------
 EXT_COMMAND(readb,
-    "Read a memory value from emulated m68K address space",
+    "Read a byte from emulated m68K address space",
     "{;e,r;addr;Adress}")
 {
-    ExtRemoteTyped MemMap = GetM68KMemoryMap();
-    const ULONG64 Address = GetUnnamedArgU64(0);
+    BeginSessionCommand("readb");
+    m_session.ReadValue(GetUnnamedArgU64(0), sizeof(uint8_t));
+}
 
-    // This is modeled after the implementation in FBNeo's ReadByte() in
-    // m68000_intf.cpp.
-    ExtRemoteTyped PR = MemMap.ArrayElement(Address >> SEK_SHIFT);
-    const ULONG64 FlippedAddress = Address ^ 1;
-    ExtRemoteTyped Value = PR.ArrayElement(FlippedAddress & SEK_PAGE_MASK);
+EXT_COMMAND(readw,
+    "Read a word from emulated m68K address space",
+    "{;e,r;addr;Adress}")
+{
+    BeginSessionCommand("readw");
+    m_session.ReadValue(GetUnnamedArgU64(0), sizeof(uint16_t));
+}
 
-    // TODO: actually use the above computation instead of this hack
-    void* pProcAddress = reinterpret_cast<uint8_t*>(GetM68KRAMBase().GetPtr()) + (FlippedAddress & 0xFFFF);
+EXT_COMMAND(readl,
+    "Read a long from emulated m68K address space",
+    "{;e,r;addr;Adress}")
+{
+    BeginSessionCommand("readl");
+    m_session.ReadValue(GetUnnamedArgU64(0), sizeof(uint32_t));
+}
 
-    Out("$%06X (0x%p) = 0x%02X\n", Address, pProcAddress, Value.GetUchar());
+//----------------------------------------------------------------------------
+//
+// readrange extension command.
+//
+// Dumps a range of 68K address space in 68K byte order, 16 bytes a line.
+// Bytes on pages with no memory behind them show as ??.
+//
+//----------------------------------------------------------------------------
+EXT_COMMAND(readrange,
+    "Dump a range of emulated m68K address space",
+    "{;e,r;addr;Adress}{;e,r;len;Length in bytes}")
+{
+    BeginSessionCommand("readrange");
+    m_session.DumpRange(GetUnnamedArgU64(0), GetUnnamedArgU64(1));
 }
 
 //----------------------------------------------------------------------------
 //
 // memscan extension command.
 //
-// TODO
+// The first scan of a slot either looks for an exact value or, with -u,
+// snapshots the region for an unknown initial value. Scans of a slot that
+// already holds results refine them, optionally with -op comparing each
+// value against what the previous scan saw. With -bcd, plain numbers are
+// decimal whatever the debugger's radix, so a score of 1200 is found as the
+// bytes 00 12 00.
 //
 //----------------------------------------------------------------------------
 EXT_COMMAND(memscan,
     "Scan all of M68K Working RAM space and save the results to a slot, or scan against the resulting addresses already saved within a slot",
-    "{;e,r;slot;TargetSlot}{;e,r;size;ValueSize}{;e,r;value;SearchValue}")
+    "{u;b;;Start an unknown initial value scan, snapshotting the region without filtering}"
+    "{odd;b;;When starting a scan, also match words and longs at odd addresses}"
+    "{bcd;b;;Values are decimal numbers stored as packed BCD, for sizes 1 to 4}"
+    "{op;s,o;predicate;Scan predicate: eq (default), changed, unchanged, inc, dec, incby, decby, range, mask, any}"
+    "{;s,r;slot;TargetSlot name or number}{;e,r;size;ValueSize}"
+    "{;s,o;value;SearchValue, the delta for incby/decby, the low bound for range or the mask for mask}"
+    "{;x,o;values;The high bound for range, the masked value for mask, or up to 7 more values for any}")
 {
-    const uint16_t SlotIndex = static_cast<uint16_t>(GetUnnamedArgU64(0));
-    if (SlotIndex >= kMaxMemScanSlots)
+    BeginSessionCommand("memscan");
+
+    MemScanArgs args;
+    args.pSlot = GetUnnamedArgStr(0);
+    args.ValueSize = GetUnnamedArgU64(1);
+    args.UnknownScan = HasArg("u");
+    args.AnyAlignment = HasArg("odd");
+    args.Bcd = HasArg("bcd");
+    args.pPredicate = HasArg("op") ? GetArgStr("op") : nullptr;
+    if (HasUnnamedArg(2))
     {
-        Out("Target slot %d is out of bounds, only %d slots available\n",
-            SlotIndex, kMaxMemScanSlots);
-        return;
+        args.Values.push_back(EvalScanValue(GetUnnamedArgStr(2), args.Bcd));
     }
 
-    const uint8_t ValueSize = static_cast<uint8_t>(GetUnnamedArgU64(1));
-    if (ValueSize != 1 && ValueSize != 2 && ValueSize != 4)
+    // The rest of the line holds any further values, evaluated one at a time
+    if (HasUnnamedArg(3))
     {
-        Out("Invalid search value size %d. Must be 1, 2 or 4\n", ValueSize);
-        return;
+        const std::string Rest = GetUnnamedArgStr(3);
+        size_t position = 0;
+        while ((position = Rest.find_first_not_of(" \t", position)) != std::string::npos)
+        {
+            size_t end = Rest.find_first_of(" \t", position);
+            if (end == std::string::npos)
+            {
+                end = Rest.size();
+            }
+            args.Values.push_back(EvalScanValue(Rest.substr(position, end - position), args.Bcd));
+            position = end;
+        }
     }
+    m_session.MemScan(args);
+}
+
+EXT_COMMAND(slotclear,
+    "Clear a memory scan slot and free its memory",
+    "{;s,r;slot;TargetSlot name or number}")
+{
+    BeginSessionCommand("slotclear");
+    m_session.SlotClear(GetUnnamedArgStr(0));
+}
 
-    const ULONG64 Value = GetUnnamedArgU64(2);
-    MemScanSlot& targetSlot = m_scanSlots[SlotIndex];
+//----------------------------------------------------------------------------
+//
+// slotinfo extension command.
+//
+// Without a start, lists every hit of the slot if there aren't too many.
+// Given a start, lists up to count hits from that hit number on, whatever
+// the slot holds, so large result sets can be paged through.
+//
+//----------------------------------------------------------------------------
+EXT_COMMAND(slotinfo,
+    "Dump info about a target memory scan slot",
+    "{;s,r;slot;TargetSlot name or number}"
+    "{;en=(10),o;start;First hit number to list}"
+    "{;en=(10),o;count;Number of hits to list, all that fit by default}")
+{
+    BeginSessionCommand("slotinfo");
+
+    const bool HasStart = HasUnnamedArg(1);
+    const bool HasCount = HasUnnamedArg(2);
+    m_session.SlotInfo(
+        GetUnnamedArgStr(0),
+        HasStart,
+        HasStart ? GetUnnamedArgU64(1) : 0,
+        HasCount,
+        HasCount ? GetUnnamedArgU64(2) : 0);
+}
+
+EXT_COMMAND(slotls,
+    "List summary info about all memory scan slots",
+    NULL)
+{
+    BeginSessionCommand("slotls");
+    m_session.SlotLs();
+}
 
-    void* pMemStart = reinterpret_cast<void*>(GetM68KRAMBase().GetPtr());
-    void* pMemEnd = static_cast<uint8_t*>(pMemStart) + 0x20000;
-    bool success = true;
-    if (ValueSize == 1)
+//----------------------------------------------------------------------------
+//
+// readcache extension command.
+//
+// Shows or changes the state of the target read cache. Every command reading the
+// target starts with an empty cache, so it only serves reads made within a command.
+//
+//----------------------------------------------------------------------------
+EXT_COMMAND(readcache,
+    "Show, enable, disable or flush the target memory read cache",
+    "{on;b;;Enable the cache}"
+    "{off;b;;Disable the cache}"
+    "{f;b;;Flush the cache}")
+{
+    if (HasArg("on") && HasArg("off"))
     {
-        success = 
-            targetSlot.ScanForByte(
-                static_cast<uint8_t*>(pMemStart), 
-                static_cast<uint8_t*>(pMemEnd),
-                Value & 0xFF);
+        ThrowInvalidArg("Only one of -on and -off can be given");
     }
-    else if (ValueSize == 2)
+
+    if (HasArg("on"))
     {
-        success = 
-            targetSlot.ScanForHalfWord(
-                static_cast<uint16_t*>(pMemStart), 
-                static_cast<uint16_t*>(pMemEnd),
-                Value & 0xFFFF);
+        m_ReadCache.Enable(true);
     }
-    else if (ValueSize == 4)
+    else if (HasArg("off"))
     {
-        success = 
-            targetSlot.ScanForWord(
-                static_cast<uint32_t*>(pMemStart), 
-                static_cast<uint32_t*>(pMemEnd),
-                Value & 0xFFFFFFFF);
+        m_ReadCache.Enable(false);
     }
 
-    if (!success)
+    if (HasArg("f"))
     {
-        // TODO: more detailed info
-        Out("Failed to perform memory scan on slot %d\n", SlotIndex);
-    }
-    else
-    {
-        PrintSlot(SlotIndex);
+        m_ReadCache.Flush();
     }
+
+    Out("Read cache %s, %u pages of 0x%X bytes, %I64u hits, %I64u misses\n",
+        m_ReadCache.IsEnabled() ? "enabled" : "disabled",
+        ExtRemoteReadCache::s_NumPages, ExtRemoteReadCache::s_PageSize,
+        m_PerfCounters.CacheHits, m_PerfCounters.CacheMisses);
 }
 
-EXT_COMMAND(slotclear,
-    "Clear a memory scan slot",
-    "{;e,r;slot;TargetSlot}")
+//----------------------------------------------------------------------------
+//
+// bdstats extension command.
+//
+// Shows where commands have spent their time: per-command wall time and
+// debugger traffic since the last reset, followed by the time the scan loops
+// themselves took. A memscan whose time is mostly reads is bound by the
+// debugger transport rather than the scan kernels.
+//
+//----------------------------------------------------------------------------
+EXT_COMMAND(bdstats,
+    "Show per-command timings, debugger traffic and scan throughput",
+    "{r;b;;Reset all statistics after showing them}")
 {
-    const uint16_t SlotIndex = static_cast<uint16_t>(GetUnnamedArgU64(0));
-    if (SlotIndex >= kMaxMemScanSlots)
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+
+    Out("%-10s %8s %12s %8s %10s %10s %10s %8s %8s\n",
+        "Command", "Calls", "Time us", "Reads", "Read KB", "Cache hit", "Cache miss", "Out", "Engine");
+    for (const ExtCommandDesc* pDesc = m_Commands; pDesc; pDesc = pDesc->m_Next)
     {
-        Out("Target slot %d is out of bounds, only %d slots available\n",
-            SlotIndex, kMaxMemScanSlots);
-        return;
-    }
+        const ExtCommandStats& Stats = pDesc->m_Stats;
+        if (Stats.Calls == 0)
+        {
+            continue;
+        }
 
-    MemScanSlot& targetSlot = m_scanSlots[SlotIndex];
-    targetSlot.Clear();
-    PrintSlot(SlotIndex);
-}
+        Out("%-10s %8I64u %12I64u %8I64u %10I64u %10I64u %10I64u %8I64u %8I64u\n",
+            pDesc->m_Name, Stats.Calls, Stats.Ticks * 1000000 / frequency.QuadPart,
+            Stats.Counters.ReadCalls, (Stats.Counters.ReadBytes + 1023) / 1024,
+            Stats.Counters.CacheHits, Stats.Counters.CacheMisses,
+            Stats.Counters.OutCalls, Stats.Counters.OutEngineCalls);
+    }
 
-EXT_COMMAND(slotinfo,
-    "Dump info about a target memory scan slot",
-    "{;e,r;slot;TargetSlot}")
-{
-    const uint16_t SlotIndex = static_cast<uint16_t>(GetUnnamedArgU64(0));
-    if (SlotIndex >= kMaxMemScanSlots)
+    // Totals also take in reads made outside of commands
+    const ExtPerfCounters& Totals = m_PerfCounters;
+    Out("%-10s %8s %12s %8I64u %10I64u %10I64u %10I64u %8I64u %8I64u\n",
+        "Total", "", "", Totals.ReadCalls, (Totals.ReadBytes + 1023) / 1024,
+        Totals.CacheHits, Totals.CacheMisses, Totals.OutCalls, Totals.OutEngineCalls);
+
+    const ScanStats Scans = MemScanSlot::GetScanStats();
+    const uint64_t ScanMicroseconds = Scans.Nanoseconds / 1000;
+    Out("Scan kernels: %I64u passes over %I64u KB in %I64u us",
+        Scans.NumPasses, (Scans.BytesScanned + 1023) / 1024, ScanMicroseconds);
+    if (Scans.Nanoseconds != 0)
     {
-        Out("Target slot %d is out of bounds, only %d slots available\n",
-            SlotIndex, kMaxMemScanSlots);
-        return;
+        // Bytes per nanosecond is GB/s, so scale to MB/s
+        Out(", %I64u MB/s", Scans.BytesScanned * 1000 / Scans.Nanoseconds);
     }
+    Out("\n");
 
-    PrintSlot(SlotIndex);
+    if (HasArg("r"))
+    {
+        ResetPerfCounters();
+        MemScanSlot::ResetScanStats();
+        Out("Statistics reset\n");
+    }
 }
 
-EXT_COMMAND(slotls,
-    "List summary info about all memory scan slots",
-    NULL)
+//----------------------------------------------------------------------------
+//
+// bdtrace extension command.
+//
+// Records every target read and symbol lookup the other commands make, along
+// with the commands themselves, to a trace file. burndbg_replay runs the same
+// commands again from the trace without a debugger and reports how many
+// requests each one took. Lookups cached before recording started are
+// dropped so the trace has everything it needs.
+//
+//----------------------------------------------------------------------------
+EXT_COMMAND(bdtrace,
+    "Record the target reads and symbol lookups of the commands that follow to a trace file",
+    "{start;s,o;file;Start recording to this file, replacing it}"
+    "{stop;b;;Stop recording}")
 {
-    for (uint8_t i = 0; i < kMaxMemScanSlots; ++i)
+    if (HasArg("start") && HasArg("stop"))
     {
-        const MemScanSlot& Slot = m_scanSlots[i];
-        if (Slot.GetNumEntries() == 0)
-        {
-            Out("Slot %d: Clear\n", i);
-        }
-        else
+        ThrowInvalidArg("Only one of -start and -stop can be given");
+    }
+
+    if (HasArg("stop"))
+    {
+        StopTrace();
+    }
+    else if (HasArg("start"))
+    {
+        StopTrace();
+
+        const char* pPath = GetArgStr("start");
+        if (!m_traceWriter.Open(pPath, m_PtrSize))
         {
-            Out("Slot %d: Size %u, %d hits\n",
-                i, Slot.GetSlotSize(), Slot.GetNumEntries());
+            m_traceWriter.Close();
+            ThrowStatus(E_FAIL, "Unable to create trace file %s", pPath);
         }
+
+        m_tracePath = pPath;
+        m_session.Invalidate();
+        m_memorySource.SetWriter(&m_traceWriter);
+        m_symbolProvider.SetWriter(&m_traceWriter);
+    }
+
+    if (m_traceWriter.IsOpen())
+    {
+        Out("Recording to %s, %I64u KB so far\n",
+            m_tracePath.c_str(), (m_traceWriter.GetNumBytesWritten() + 1023) / 1024);
+    }
+    else
+    {
+        Out("Not recording\n");
     }
 }
@@ -0,0 +1,91 @@
+#include <windows.h>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <engextcpp.hpp>
+
+#include "dbgengmemorysource.h"
+#include "readplanner.h"
+
+bool DbgEngMemorySource::Read(uint64_t address, void* pBuffer, uint32_t size)
+{
+    if (size == 0)
+    {
+        return true;
+    }
+
+    // ExtRemoteData throws when memory can't be read, which callers here expect
+    // as a failed read rather than an aborted command. Interrupts still propagate.
+    try
+    {
+        // ExtRemoteData already fetches small ranges when it's constructed, so only
+        // larger ones need a ReadBuffer
+        ExtRemoteData RangeData("MemorySource", address, size);
+        if (size <= sizeof(RangeData.m_Data))
+        {
+            memcpy(pBuffer, &RangeData.m_Data, size);
+        }
+        else
+        {
+            constexpr bool MustReadAll = true;
+            RangeData.ReadBuffer(pBuffer, size, MustReadAll);
+        }
+    }
+    catch (const ExtRemoteException&)
+    {
+        return false;
+    }
+
+    return true;
+}
+
+// Handed to the engine's batched reader, which sorts the entries and merges neighbours
+// into as few ReadVirtual calls as it can. It merges across the same gaps the scan core
+// plans its reads with, so a gap the core chose to skip isn't read through here either.
+bool DbgEngMemorySource::ReadScatter(ScatterReadEntry* pEntries, size_t numEntries)
+{
+    ExtRemoteScatterRead batch(kDefaultMaxReadGap);
+    for (size_t i = 0; i < numEntries; ++i)
+    {
+        batch.Add(pEntries[i].Address, pEntries[i].Size);
+    }
+
+    const ULONG NumFailed = batch.Read();
+    for (size_t i = 0; i < numEntries; ++i)
+    {
+        const ULONG Index = static_cast<ULONG>(i);
+        pEntries[i].Succeeded = batch.Succeeded(Index);
+        if (pEntries[i].Succeeded)
+        {
+            memcpy(pEntries[i].pBuffer, batch.GetData(Index), pEntries[i].Size);
+        }
+    }
+
+    return NumFailed == 0;
+}
+
+void DbgEngMemorySource::EnumerateRegions(std::vector<MemoryRegionInfo>& regionsOut)
+{
+    regionsOut.clear();
+    if (!g_Ext->CanQueryVirtual())
+    {
+        return;
+    }
+
+    ULONG64 address = 0;
+    MEMORY_BASIC_INFORMATION64 info;
+    while (SUCCEEDED(g_Ext->m_Data2->QueryVirtual(address, &info)))
+    {
+        if (info.State == MEM_COMMIT && (info.Protect & (PAGE_NOACCESS | PAGE_GUARD)) == 0)
+        {
+            regionsOut.push_back({ info.BaseAddress, info.RegionSize });
+        }
+
+        const ULONG64 Next = info.BaseAddress + info.RegionSize;
+        if (Next <= address)
+        {
+            break;
+        }
+        address = Next;
+    }
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "memorysource.h"
+
+//----------------------------------------------------------------------------
+// Memory source backed by the debugger engine. Only usable from inside an
+// extension command, while g_Ext has its interfaces.
+//----------------------------------------------------------------------------
+
+class DbgEngMemorySource : public IMemorySource
+{
+public:
+    bool Read(uint64_t address, void* pBuffer, uint32_t size) override;
+    bool ReadScatter(ScatterReadEntry* pEntries, size_t numEntries) override;
+    void EnumerateRegions(std::vector<MemoryRegionInfo>& regionsOut) override;
+};
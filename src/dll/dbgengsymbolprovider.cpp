@@ -0,0 +1,46 @@
+#include <windows.h>
+#include <cstdint>
+#include <engextcpp.hpp>
+
+#include "dbgengsymbolprovider.h"
+
+bool DbgEngSymbolProvider::GetModuleBase(const char* pModule, uint64_t* pBaseOut)
+{
+    ULONG64 base;
+    if (FAILED(g_Ext->m_Symbols->GetModuleByModuleName(pModule, 0, nullptr, &base)))
+    {
+        return false;
+    }
+
+    *pBaseOut = base;
+    return true;
+}
+
+bool DbgEngSymbolProvider::GetSymbolAddress(const char* pSymbol, uint64_t* pAddressOut)
+{
+    // S_FALSE means the name is ambiguous, which is no better than not found
+    ULONG64 address;
+    if (g_Ext->m_Symbols->GetOffsetByName(pSymbol, &address) != S_OK)
+    {
+        return false;
+    }
+
+    *pAddressOut = address;
+    return true;
+}
+
+bool DbgEngSymbolProvider::GetFieldOffset(const char* pModule, const char* pType, const char* pField, uint32_t* pOffsetOut)
+{
+    ULONG64 moduleBase;
+    ULONG typeId;
+    ULONG offset;
+    if (!GetModuleBase(pModule, &moduleBase) ||
+        FAILED(g_Ext->m_Symbols->GetTypeId(moduleBase, pType, &typeId)) ||
+        FAILED(g_Ext->m_Symbols->GetFieldOffset(moduleBase, typeId, pField, &offset)))
+    {
+        return false;
+    }
+
+    *pOffsetOut = offset;
+    return true;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+
+#include "symbolcache.h"
+
+//----------------------------------------------------------------------------
+// Symbol provider backed by the debugger engine's IDebugSymbols. Only usable
+// from inside an extension command, while g_Ext has its interfaces.
+//----------------------------------------------------------------------------
+
+class DbgEngSymbolProvider : public ISymbolProvider
+{
+public:
+    bool GetModuleBase(const char* pModule, uint64_t* pBaseOut) override;
+    bool GetSymbolAddress(const char* pSymbol, uint64_t* pAddressOut) override;
+    bool GetFieldOffset(const char* pModule, const char* pType, const char* pField, uint32_t* pOffsetOut) override;
+};
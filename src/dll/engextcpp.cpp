@@ -9,6 +9,7 @@
 #ifndef DBG_ENGEXTCPP_SKIP_HEADERS
 
 #include <engextcpp.hpp>
+#include <stdlib.h>
 #include <strsafe.h>
 #include <dbghelp.h>
 
@@ -196,6 +197,7 @@ ExtCommandDesc::ExtCommandDesc(_In_ PCSTR Name,
     m_Method = Method;
     m_Desc = Desc;
     m_ArgDescStr = Args;
+    ZeroMemory(&m_Stats, sizeof(m_Stats));
 
     ClearArgs();
 
@@ -916,6 +918,8 @@ ExtExtension::ExtExtension(void)
     
     m_ExInitialized = false;
     m_OutMask = DEBUG_OUTPUT_NORMAL;
+    m_OutBuffered = false;
+    m_OutBufferMask = DEBUG_OUTPUT_NORMAL;
     m_CurChar = 0;
     m_LeftIndent = 0;
     m_AllowWrap = true;
@@ -929,6 +933,9 @@ ExtExtension::ExtExtension(void)
 
     m_DbgHelp = NULL;
     m_SymMatchStringA = NULL;
+
+    ZeroMemory(&m_PerfCounters, sizeof(m_PerfCounters));
+    m_PerfCounterResets = 0;
 }
 
 HRESULT WINAPI
@@ -1005,14 +1012,199 @@ ExtExtension::OnSessionInaccessible(_In_ ULONG64 Argument)
     // Empty.
 }
 
+//
+// Conversions the engine handles itself rather than the CRT.
+// Only the character after any flags, width, precision and
+// length modifier needs to be looked at, so %I64p and %lp
+// go to the engine too.
+//
+
+static bool
+FormatNeedsEngine(_In_ PCSTR Format)
+{
+    while ((Format = strchr(Format, '%')) != NULL)
+    {
+        Format++;
+        if (*Format == '%')
+        {
+            Format++;
+            continue;
+        }
+
+        Format += strspn(Format, "-+ #0123456789.*");
+        Format += strspn(Format, "hlLIwz0123456789");
+        if (*Format == 'p' || *Format == 'm' ||
+            *Format == 'y' || *Format == 'N')
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool
+FormatNeedsEngine(_In_ PCWSTR Format)
+{
+    while ((Format = wcschr(Format, L'%')) != NULL)
+    {
+        Format++;
+        if (*Format == L'%')
+        {
+            Format++;
+            continue;
+        }
+
+        Format += wcsspn(Format, L"-+ #0123456789.*");
+        Format += wcsspn(Format, L"hlLIwz0123456789");
+        if (*Format == L'p' || *Format == L'm' ||
+            *Format == L'y' || *Format == L'N')
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool WINAPI
+ExtExtension::BufferOutVa(_In_ PCSTR Format,
+                          _In_ va_list Args)
+{
+    if (!m_OutBuffered ||
+        FormatNeedsEngine(Format))
+    {
+        FlushOut();
+        return false;
+    }
+
+    if (m_OutBufferWide.GetEltsUsed() ||
+        (m_OutBuffer.GetEltsUsed() && m_OutBufferMask != m_OutMask))
+    {
+        FlushOut();
+    }
+
+    va_list LenArgs;
+    va_copy(LenArgs, Args);
+    int Chars = _vscprintf(Format, LenArgs);
+    va_end(LenArgs);
+    if (Chars < 0)
+    {
+        FlushOut();
+        return false;
+    }
+
+    //
+    // Keep room for the terminator, which isn't
+    // counted as used.
+    //
+
+    ULONG Used = m_OutBuffer.GetEltsUsed();
+    if (Used + Chars + 1 > m_OutBuffer.GetEltsAlloc())
+    {
+        m_OutBuffer.RequireRounded(Used + Chars + 1,
+                                   s_OutBufferFlushChars);
+    }
+    PSTR Dest = m_OutBuffer.GetRawBuffer() + Used;
+    vsprintf_s(Dest, Chars + 1, Format, Args);
+    m_OutBuffer.SetEltsUsed(Used + Chars);
+    m_OutBufferMask = m_OutMask;
+
+    if (m_OutBuffer.GetEltsUsed() >= s_OutBufferFlushChars)
+    {
+        FlushOut();
+    }
+    return true;
+}
+
+bool WINAPI
+ExtExtension::BufferOutVa(_In_ PCWSTR Format,
+                          _In_ va_list Args)
+{
+    if (!m_OutBuffered ||
+        FormatNeedsEngine(Format))
+    {
+        FlushOut();
+        return false;
+    }
+
+    if (m_OutBuffer.GetEltsUsed() ||
+        (m_OutBufferWide.GetEltsUsed() && m_OutBufferMask != m_OutMask))
+    {
+        FlushOut();
+    }
+
+    va_list LenArgs;
+    va_copy(LenArgs, Args);
+    int Chars = _vscwprintf(Format, LenArgs);
+    va_end(LenArgs);
+    if (Chars < 0)
+    {
+        FlushOut();
+        return false;
+    }
+
+    ULONG Used = m_OutBufferWide.GetEltsUsed();
+    if (Used + Chars + 1 > m_OutBufferWide.GetEltsAlloc())
+    {
+        m_OutBufferWide.RequireRounded(Used + Chars + 1,
+                                       s_OutBufferFlushChars);
+    }
+    PWSTR Dest = m_OutBufferWide.GetRawBuffer() + Used;
+    vswprintf_s(Dest, Chars + 1, Format, Args);
+    m_OutBufferWide.SetEltsUsed(Used + Chars);
+    m_OutBufferMask = m_OutMask;
+
+    if (m_OutBufferWide.GetEltsUsed() >= s_OutBufferFlushChars)
+    {
+        FlushOut();
+    }
+    return true;
+}
+
+void WINAPI
+ExtExtension::FlushOut(void)
+{
+    //
+    // The text is passed as an argument so that
+    // the engine doesn't try to interpret it.
+    //
+
+    if (m_OutBuffer.GetEltsUsed())
+    {
+        m_OutBuffer.SetEltsUsed(0);
+        if (*&m_Control != NULL)
+        {
+            m_PerfCounters.OutEngineCalls++;
+            m_Control->Output(m_OutBufferMask, "%s",
+                              m_OutBuffer.GetRawBuffer());
+        }
+    }
+    if (m_OutBufferWide.GetEltsUsed())
+    {
+        m_OutBufferWide.SetEltsUsed(0);
+        if (*&m_Control4 != NULL)
+        {
+            m_PerfCounters.OutEngineCalls++;
+            m_Control4->OutputWide(m_OutBufferMask, L"%s",
+                                   m_OutBufferWide.GetRawBuffer());
+        }
+    }
+}
+
 void WINAPIV
 ExtExtension::Out(_In_ PCSTR Format,
                   ...)
 {
     va_list Args;
 
+    m_PerfCounters.OutCalls++;
     va_start(Args, Format);
-    m_Control->OutputVaList(m_OutMask, Format, Args);
+    if (!BufferOutVa(Format, Args))
+    {
+        m_PerfCounters.OutEngineCalls++;
+        m_Control->OutputVaList(m_OutMask, Format, Args);
+    }
     va_end(Args);
 }
 
@@ -1022,6 +1214,7 @@ ExtExtension::Warn(_In_ PCSTR Format,
 {
     va_list Args;
 
+    FlushOut();
     va_start(Args, Format);
     m_Control->OutputVaList(DEBUG_OUTPUT_WARNING, Format, Args);
     va_end(Args);
@@ -1033,6 +1226,7 @@ ExtExtension::Err(_In_ PCSTR Format,
 {
     va_list Args;
 
+    FlushOut();
     va_start(Args, Format);
     m_Control->OutputVaList(DEBUG_OUTPUT_ERROR, Format, Args);
     va_end(Args);
@@ -1044,6 +1238,7 @@ ExtExtension::Verb(_In_ PCSTR Format,
 {
     va_list Args;
 
+    FlushOut();
     va_start(Args, Format);
     m_Control->OutputVaList(DEBUG_OUTPUT_VERBOSE, Format, Args);
     va_end(Args);
@@ -1055,8 +1250,13 @@ ExtExtension::Out(_In_ PCWSTR Format,
 {
     va_list Args;
 
+    m_PerfCounters.OutCalls++;
     va_start(Args, Format);
-    m_Control4->OutputVaListWide(m_OutMask, Format, Args);
+    if (!BufferOutVa(Format, Args))
+    {
+        m_PerfCounters.OutEngineCalls++;
+        m_Control4->OutputVaListWide(m_OutMask, Format, Args);
+    }
     va_end(Args);
 }
 
@@ -1066,6 +1266,7 @@ ExtExtension::Warn(_In_ PCWSTR Format,
 {
     va_list Args;
 
+    FlushOut();
     va_start(Args, Format);
     m_Control4->OutputVaListWide(DEBUG_OUTPUT_WARNING, Format, Args);
     va_end(Args);
@@ -1077,6 +1278,7 @@ ExtExtension::Err(_In_ PCWSTR Format,
 {
     va_list Args;
 
+    FlushOut();
     va_start(Args, Format);
     m_Control4->OutputVaListWide(DEBUG_OUTPUT_ERROR, Format, Args);
     va_end(Args);
@@ -1088,6 +1290,7 @@ ExtExtension::Verb(_In_ PCWSTR Format,
 {
     va_list Args;
 
+    FlushOut();
     va_start(Args, Format);
     m_Control4->OutputVaListWide(DEBUG_OUTPUT_VERBOSE, Format, Args);
     va_end(Args);
@@ -1099,6 +1302,7 @@ ExtExtension::Dml(_In_ PCSTR Format,
 {
     va_list Args;
 
+    FlushOut();
     va_start(Args, Format);
     m_Control->ControlledOutputVaList(DEBUG_OUTCTL_AMBIENT_DML,
                                       m_OutMask, Format, Args);
@@ -1111,6 +1315,7 @@ ExtExtension::DmlWarn(_In_ PCSTR Format,
 {
     va_list Args;
 
+    FlushOut();
     va_start(Args, Format);
     m_Control->ControlledOutputVaList(DEBUG_OUTCTL_AMBIENT_DML,
                                       DEBUG_OUTPUT_WARNING, Format, Args);
@@ -1123,6 +1328,7 @@ ExtExtension::DmlErr(_In_ PCSTR Format,
 {
     va_list Args;
 
+    FlushOut();
     va_start(Args, Format);
     m_Control->ControlledOutputVaList(DEBUG_OUTCTL_AMBIENT_DML,
                                       DEBUG_OUTPUT_ERROR, Format, Args);
@@ -1135,6 +1341,7 @@ ExtExtension::DmlVerb(_In_ PCSTR Format,
 {
     va_list Args;
 
+    FlushOut();
     va_start(Args, Format);
     m_Control->ControlledOutputVaList(DEBUG_OUTCTL_AMBIENT_DML,
                                       DEBUG_OUTPUT_VERBOSE, Format, Args);
@@ -1147,6 +1354,7 @@ ExtExtension::Dml(_In_ PCWSTR Format,
 {
     va_list Args;
 
+    FlushOut();
     va_start(Args, Format);
     m_Control4->ControlledOutputVaListWide(DEBUG_OUTCTL_AMBIENT_DML,
                                            m_OutMask,
@@ -1161,6 +1369,7 @@ ExtExtension::DmlWarn(_In_ PCWSTR Format,
 {
     va_list Args;
 
+    FlushOut();
     va_start(Args, Format);
     m_Control4->ControlledOutputVaListWide(DEBUG_OUTCTL_AMBIENT_DML,
                                            DEBUG_OUTPUT_WARNING,
@@ -1175,6 +1384,7 @@ ExtExtension::DmlErr(_In_ PCWSTR Format,
 {
     va_list Args;
 
+    FlushOut();
     va_start(Args, Format);
     m_Control4->ControlledOutputVaListWide(DEBUG_OUTCTL_AMBIENT_DML,
                                            DEBUG_OUTPUT_ERROR,
@@ -1189,6 +1399,7 @@ ExtExtension::DmlVerb(_In_ PCWSTR Format,
 {
     va_list Args;
 
+    FlushOut();
     va_start(Args, Format);
     m_Control4->ControlledOutputVaListWide(DEBUG_OUTCTL_AMBIENT_DML,
                                            DEBUG_OUTPUT_VERBOSE,
@@ -1200,6 +1411,7 @@ ExtExtension::DmlVerb(_In_ PCWSTR Format,
 void WINAPI
 ExtExtension::WrapLine(void)
 {
+    FlushOut();
     if (m_LeftIndent)
     {
         m_Control->Output(m_OutMask, "\n%*c", m_LeftIndent, ' ');
@@ -1214,6 +1426,8 @@ ExtExtension::WrapLine(void)
 void WINAPI
 ExtExtension::OutWrapStr(_In_ PCSTR String)
 {
+    FlushOut();
+
     if (m_TestWrap)
     {
         m_TestWrapChars += static_cast<ULONG>(strlen(String));
@@ -1582,6 +1796,28 @@ ExtExtension::GetCachedFieldOffset(_Inout_ PULONG64 Cookie,
     return Info.Arg3;
 }
 
+void WINAPI
+ExtExtension::ResetPerfCounters(void)
+{
+    ZeroMemory(&m_PerfCounters, sizeof(m_PerfCounters));
+    for (ExtCommandDesc* Desc = m_Commands; Desc; Desc = Desc->m_Next)
+    {
+        ZeroMemory(&Desc->m_Stats, sizeof(Desc->m_Stats));
+    }
+    m_PerfCounterResets++;
+}
+
+HRESULT WINAPI
+ExtExtension::CountedReadVirtual(_In_ ULONG64 Offset,
+                                 _Out_writes_bytes_(Bytes) PVOID Buffer,
+                                 _In_ ULONG Bytes,
+                                 _Out_opt_ PULONG Done)
+{
+    m_PerfCounters.ReadCalls++;
+    m_PerfCounters.ReadBytes += Bytes;
+    return m_Data->ReadVirtual(Offset, Buffer, Bytes, Done);
+}
+
 bool WINAPI
 ExtExtension::GetCachedSymbolInfo(_In_ ULONG64 Cookie,
                                   _Out_ PDEBUG_CACHED_SYMBOL_INFO Info)
@@ -2391,6 +2627,10 @@ ExtExtension::Query(_In_ PDEBUG_CLIENT Start)
 void WINAPI
 ExtExtension::Release(void)
 {
+    // Anything a call left buffered has to go out
+    // before the client it goes to is released.
+    FlushOut();
+
     EXT_RELEASE(m_Advanced);
     EXT_RELEASE(m_Client);
     EXT_RELEASE(m_Control);
@@ -2435,7 +2675,12 @@ ExtExtension::CallExtCodeCEH(_In_opt_ ExtCommandDesc* Desc,
     HRESULT Status;
     PCSTR PreName;
     PCSTR Name;
+    ExtPerfCounters Before = m_PerfCounters;
+    ULONG Resets = m_PerfCounterResets;
+    LARGE_INTEGER Start;
+    LARGE_INTEGER End;
 
+    QueryPerformanceCounter(&Start);
     PreName = "";
 
     if (RawName)
@@ -2484,9 +2729,12 @@ ExtExtension::CallExtCodeCEH(_In_opt_ ExtCommandDesc* Desc,
             // This should never happen.
             Status = E_INVALIDARG;
         }
+
+        FlushOut();
     }
     catch(ExtInterruptException Ex)
     {
+        FlushOut();
         if (Name)
         {
             m_Control->Output(DEBUG_OUTPUT_ERROR, "%s%s: %s.\n",
@@ -2496,6 +2744,7 @@ ExtExtension::CallExtCodeCEH(_In_opt_ ExtCommandDesc* Desc,
     }
     catch(ExtException Ex)
     {
+        FlushOut();
         if (Name &&
             Ex.GetMessage())
         {
@@ -2527,6 +2776,34 @@ ExtExtension::CallExtCodeCEH(_In_opt_ ExtCommandDesc* Desc,
         
         Status = Ex.GetStatus();
     }
+    catch(...)
+    {
+        // Keep the output ahead of whatever reports
+        // the exception.
+        FlushOut();
+        throw;
+    }
+
+    if (Desc && Resets == m_PerfCounterResets)
+    {
+        ExtCommandStats* Stats = &Desc->m_Stats;
+
+        QueryPerformanceCounter(&End);
+        Stats->Calls++;
+        Stats->Ticks += End.QuadPart - Start.QuadPart;
+        Stats->Counters.ReadCalls +=
+            m_PerfCounters.ReadCalls - Before.ReadCalls;
+        Stats->Counters.ReadBytes +=
+            m_PerfCounters.ReadBytes - Before.ReadBytes;
+        Stats->Counters.CacheHits +=
+            m_PerfCounters.CacheHits - Before.CacheHits;
+        Stats->Counters.CacheMisses +=
+            m_PerfCounters.CacheMisses - Before.CacheMisses;
+        Stats->Counters.OutCalls +=
+            m_PerfCounters.OutCalls - Before.OutCalls;
+        Stats->Counters.OutEngineCalls +=
+            m_PerfCounters.OutEngineCalls - Before.OutEngineCalls;
+    }
 
     return Status;
 }
@@ -3840,6 +4117,148 @@ ExtRemoteData::SetData(_In_ ULONG64 Data,
     }
 }
 
+//----------------------------------------------------------------------------
+//
+// ExtRemoteReadCache.
+//
+//----------------------------------------------------------------------------
+
+void WINAPI
+ExtRemoteReadCache::Enable(_In_ bool Enable)
+{
+    if (Enable == IsEnabled())
+    {
+        return;
+    }
+
+    if (Enable)
+    {
+        m_Pages = new CachedPage[s_NumPages];
+        Flush();
+    }
+    else
+    {
+        delete [] m_Pages;
+        m_Pages = NULL;
+    }
+}
+
+void WINAPI
+ExtRemoteReadCache::Flush(void)
+{
+    if (!m_Pages)
+    {
+        return;
+    }
+
+    for (ULONG i = 0; i < s_NumPages; i++)
+    {
+        m_Pages[i].Valid = false;
+    }
+}
+
+void WINAPI
+ExtRemoteReadCache::Invalidate(_In_ ULONG64 Offset,
+                               _In_ ULONG Bytes)
+{
+    if (!m_Pages || !Bytes)
+    {
+        return;
+    }
+
+    ULONG64 Base = Offset & ~(ULONG64)(s_PageSize - 1);
+    ULONG64 End = Offset + Bytes;
+    for (; Base < End; Base += s_PageSize)
+    {
+        CachedPage* Page = Lookup(Base);
+        if (Page)
+        {
+            Page->Valid = false;
+        }
+    }
+}
+
+HRESULT WINAPI
+ExtRemoteReadCache::ReadVirtual(_In_ ULONG64 Offset,
+                                _Out_writes_bytes_(Bytes) PVOID Buffer,
+                                _In_ ULONG Bytes,
+                                _Out_ PULONG Done)
+{
+    HRESULT Status;
+    ULONG64 First = Offset & ~(ULONG64)(s_PageSize - 1);
+    ULONG64 End = (Offset + Bytes + s_PageSize - 1) & ~(ULONG64)(s_PageSize - 1);
+    ULONG64 Base;
+    bool AllCached = true;
+
+    if (!m_Pages || End <= First)
+    {
+        return g_Ext->CountedReadVirtual(Offset, Buffer, Bytes, Done);
+    }
+
+    for (Base = First; Base < End && AllCached; Base += s_PageSize)
+    {
+        AllCached = Lookup(Base) != NULL;
+    }
+
+    if (!AllCached)
+    {
+        //
+        // Fetch everything the read touches in one go.  Pages
+        // beyond what the cache holds simply replace earlier ones.
+        //
+
+        ULONG SpanBytes = (ULONG)(End - First);
+        PUCHAR Span = new UCHAR[SpanBytes];
+        ULONG SpanDone;
+
+        g_Ext->m_PerfCounters.CacheMisses++;
+        Status = g_Ext->
+            CountedReadVirtual(First, Span, SpanBytes, &SpanDone);
+        if (Status != S_OK || SpanDone != SpanBytes)
+        {
+            delete [] Span;
+            return g_Ext->CountedReadVirtual(Offset, Buffer, Bytes, Done);
+        }
+
+        for (Base = First; Base < End; Base += s_PageSize)
+        {
+            CachedPage* Page = &m_Pages[(Base / s_PageSize) % s_NumPages];
+            Page->Base = Base;
+            Page->Valid = true;
+            memcpy(Page->Data, Span + (Base - First), s_PageSize);
+        }
+
+        memcpy(Buffer, Span + (Offset - First), Bytes);
+        delete [] Span;
+        *Done = Bytes;
+        return S_OK;
+    }
+
+    PUCHAR Out = (PUCHAR)Buffer;
+    ULONG64 Cur = Offset;
+    ULONG Left = Bytes;
+    while (Left)
+    {
+        CachedPage* Page = Lookup(Cur & ~(ULONG64)(s_PageSize - 1));
+        ULONG PageOffset = (ULONG)(Cur & (s_PageSize - 1));
+        ULONG Chunk = s_PageSize - PageOffset;
+
+        if (Chunk > Left)
+        {
+            Chunk = Left;
+        }
+
+        memcpy(Out, Page->Data + PageOffset, Chunk);
+        Out += Chunk;
+        Cur += Chunk;
+        Left -= Chunk;
+    }
+
+    g_Ext->m_PerfCounters.CacheHits++;
+    *Done = Bytes;
+    return S_OK;
+}
+
 ULONG WINAPI
 ExtRemoteData::ReadBuffer(_Out_writes_bytes_(Bytes) PVOID Buffer,
                           _In_ ULONG Bytes,
@@ -3866,11 +4285,16 @@ ExtRemoteData::ReadBuffer(_Out_writes_bytes_(Bytes) PVOID Buffer,
         Status = g_Ext->m_Data4->
             ReadPhysical2(m_Offset, m_SpaceFlags, Buffer, Bytes, &Done);
     }
-    else
+    else if (g_Ext->m_ReadCache.IsEnabled())
     {
-        Status = g_Ext->m_Data->
+        Status = g_Ext->m_ReadCache.
             ReadVirtual(m_Offset, Buffer, Bytes, &Done);
     }
+    else
+    {
+        Status = g_Ext->
+            CountedReadVirtual(m_Offset, Buffer, Bytes, &Done);
+    }
     if (Status == S_OK && Done != Bytes && MustReadAll)
     {
         Status = HRESULT_FROM_WIN32(ERROR_READ_FAULT);
@@ -3924,6 +4348,7 @@ ExtRemoteData::WriteBuffer(_In_reads_bytes_(Bytes) PVOID Buffer,
     {
         Status = g_Ext->m_Data->
             WriteVirtual(m_Offset, Buffer, Bytes, &Done);
+        g_Ext->m_ReadCache.Invalidate(m_Offset, Bytes);
     }
     if (Status == S_OK && Done != Bytes && MustWriteAll)
     {
@@ -4091,6 +4516,264 @@ ExtRemoteData::GetString(_Inout_ ExtBuffer<WCHAR>* Buffer,
                        m_Offset);
 }
 
+//----------------------------------------------------------------------------
+//
+// ExtRemoteScatterRead.
+//
+//----------------------------------------------------------------------------
+
+struct ScatterSortEntry
+{
+    ULONG64 Offset;
+    ULONG Index;
+};
+
+static int __cdecl
+CompareScatterSortEntries(_In_ const void* A,
+                          _In_ const void* B)
+{
+    const ScatterSortEntry* EntryA = (const ScatterSortEntry*)A;
+    const ScatterSortEntry* EntryB = (const ScatterSortEntry*)B;
+
+    if (EntryA->Offset != EntryB->Offset)
+    {
+        return EntryA->Offset < EntryB->Offset ? -1 : 1;
+    }
+    return EntryA->Index < EntryB->Index ? -1 :
+        (EntryA->Index > EntryB->Index ? 1 : 0);
+}
+
+// ExtBuffer::Require grows to exactly the size asked for,
+// which makes appending one element at a time quadratic.
+template<typename _T>
+static void
+RequireGrowing(_Inout_ ExtBuffer<_T>* Buffer,
+               _In_ ULONG Extra)
+{
+    ULONG Used = Buffer->GetEltsUsed();
+
+    if (Used > (ULONG)-1 - Extra)
+    {
+        throw ExtStatusException
+            (HRESULT_FROM_WIN32(ERROR_ARITHMETIC_OVERFLOW),
+             "ExtRemoteScatterRead too many requests");
+    }
+    if (Used + Extra > Buffer->GetEltsAlloc())
+    {
+        ULONG Alloc = Buffer->GetEltsAlloc();
+        Alloc = Alloc > (ULONG)-1 / 2 ? (ULONG)-1 : Alloc * 2;
+        if (Alloc < Used + Extra)
+        {
+            Alloc = Used + Extra;
+        }
+        if (Alloc < 16)
+        {
+            Alloc = 16;
+        }
+        Buffer->Resize(Alloc);
+    }
+}
+
+static HRESULT
+ReadVirtualThroughCache(_In_ ULONG64 Offset,
+                        _Out_writes_bytes_(Bytes) PVOID Buffer,
+                        _In_ ULONG Bytes,
+                        _Out_ PULONG Done)
+{
+    if (g_Ext->m_ReadCache.IsEnabled())
+    {
+        return g_Ext->m_ReadCache.ReadVirtual(Offset, Buffer, Bytes, Done);
+    }
+    return g_Ext->CountedReadVirtual(Offset, Buffer, Bytes, Done);
+}
+
+ULONG WINAPI
+ExtRemoteScatterRead::Add(_In_ ULONG64 Offset,
+                          _In_ ULONG Bytes)
+{
+    if (Offset + Bytes < Offset)
+    {
+        throw ExtStatusException(E_INVALIDARG,
+                                 "ExtRemoteScatterRead::Add "
+                                 "request wraps the address space");
+    }
+
+    RequireGrowing(&m_Requests, 1);
+    RequireGrowing(&m_Data, Bytes);
+
+    ULONG Index = m_Requests.GetEltsUsed();
+    Request* Req = &m_Requests.GetRawBuffer()[Index];
+    Req->Offset = Offset;
+    Req->Bytes = Bytes;
+    Req->DataOffset = m_Data.GetEltsUsed();
+    Req->Succeeded = false;
+
+    m_Requests.SetEltsUsed(Index + 1);
+    m_Data.SetEltsUsed(Req->DataOffset + Bytes);
+    return Index;
+}
+
+ULONG WINAPI
+ExtRemoteScatterRead::Read(void)
+{
+    ULONG Count = m_Requests.GetEltsUsed();
+    ULONG i;
+
+    g_Ext->ThrowInterrupt();
+
+    m_NumReads = 0;
+    if (!Count)
+    {
+        return 0;
+    }
+
+    Request* Reqs = m_Requests.GetBuffer();
+    ExtBuffer<ScatterSortEntry> Sorted;
+    ExtBuffer<ULONG> Order;
+    ScatterSortEntry* SortedPtr = Sorted.Get(Count);
+    ULONG* OrderPtr = Order.Get(Count);
+
+    for (i = 0; i < Count; i++)
+    {
+        SortedPtr[i].Offset = Reqs[i].Offset;
+        SortedPtr[i].Index = i;
+    }
+    qsort(SortedPtr, Count, sizeof(*SortedPtr), CompareScatterSortEntries);
+    for (i = 0; i < Count; i++)
+    {
+        OrderPtr[i] = SortedPtr[i].Index;
+    }
+
+    //
+    // Walk the requests in address order, extending the
+    // current range while the next request starts within
+    // the gap threshold of its end.
+    //
+
+    ULONG First = 0;
+    while (First < Count)
+    {
+        ULONG64 Start = Reqs[OrderPtr[First]].Offset;
+        ULONG64 End = Start + Reqs[OrderPtr[First]].Bytes;
+        ULONG Next = First + 1;
+
+        while (Next < Count)
+        {
+            const Request* Req = &Reqs[OrderPtr[Next]];
+            ULONG64 ReqEnd = Req->Offset + Req->Bytes;
+
+            if (ReqEnd < End)
+            {
+                ReqEnd = End;
+            }
+            if (Req->Offset > End && Req->Offset - End > m_MaxGap)
+            {
+                break;
+            }
+            if (ReqEnd - Start > s_MaxMergedBytes)
+            {
+                break;
+            }
+
+            End = ReqEnd;
+            Next++;
+        }
+
+        ReadRequests(OrderPtr + First, Next - First);
+        First = Next;
+    }
+
+    ULONG Failed = 0;
+    for (i = 0; i < Count; i++)
+    {
+        if (!Reqs[i].Succeeded)
+        {
+            Failed++;
+        }
+    }
+
+    return Failed;
+}
+
+void WINAPI
+ExtRemoteScatterRead::ReadRequests(_In_reads_(Count) const ULONG* Order,
+                                   _In_ ULONG Count)
+{
+    HRESULT Status;
+    ULONG Done;
+    Request* Reqs = m_Requests.GetBuffer();
+    PUCHAR Data = m_Data.GetRawBuffer();
+    ULONG i;
+
+    if (Count == 1)
+    {
+        Request* Req = &Reqs[Order[0]];
+
+        if (!Req->Bytes)
+        {
+            Req->Succeeded = true;
+            return;
+        }
+
+        m_NumReads++;
+        Status = ReadVirtualThroughCache(Req->Offset,
+                                         Data + Req->DataOffset,
+                                         Req->Bytes,
+                                         &Done);
+        Req->Succeeded = Status == S_OK && Done == Req->Bytes;
+        return;
+    }
+
+    ULONG64 Start = Reqs[Order[0]].Offset;
+    ULONG64 End = Start;
+    for (i = 0; i < Count; i++)
+    {
+        ULONG64 ReqEnd = Reqs[Order[i]].Offset + Reqs[Order[i]].Bytes;
+        if (ReqEnd > End)
+        {
+            End = ReqEnd;
+        }
+    }
+
+    ULONG SpanBytes = (ULONG)(End - Start);
+    PUCHAR Span = m_Span.Get(SpanBytes);
+
+    m_NumReads++;
+    Status = ReadVirtualThroughCache(Start, Span, SpanBytes, &Done);
+    if (Status != S_OK || Done != SpanBytes)
+    {
+        for (i = 0; i < Count; i++)
+        {
+            ReadRequests(&Order[i], 1);
+        }
+        return;
+    }
+
+    for (i = 0; i < Count; i++)
+    {
+        Request* Req = &Reqs[Order[i]];
+        memcpy(Data + Req->DataOffset,
+               Span + (ULONG)(Req->Offset - Start),
+               Req->Bytes);
+        Req->Succeeded = true;
+    }
+}
+
+PVOID WINAPI
+ExtRemoteScatterRead::GetData(_In_ ULONG Index)
+{
+    Request* Req = GetRequest(Index);
+
+    if (!Req->Succeeded)
+    {
+        g_Ext->ThrowRemote(HRESULT_FROM_WIN32(ERROR_READ_FAULT),
+                           "Unable to read 0x%x bytes at %p",
+                           Req->Bytes, Req->Offset);
+    }
+
+    return m_Data.GetRawBuffer() + Req->DataOffset;
+}
+
 //----------------------------------------------------------------------------
 //
 // ExtRemoteTyped.
@@ -5071,6 +5754,13 @@ DebugExtensionNotify(_In_ ULONG Notify,
 
     ExtExtension* Inst = g_Ext;
 
+    //
+    // Any change in session state may mean the target ran,
+    // so nothing cached from its memory can be trusted.
+    //
+
+    Inst->m_ReadCache.Flush();
+
     switch(Notify)
     {
     case DEBUG_NOTIFY_SESSION_ACTIVE:
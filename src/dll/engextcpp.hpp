@@ -961,6 +961,38 @@ protected:
                    sizeof(ULONG64)];
 };
 
+//----------------------------------------------------------------------------
+//
+// Counters for the engine traffic an extension generates.
+// ExtExtension keeps running totals and each command
+// accumulates what its invocations added, along with the
+// time they took.
+//
+//----------------------------------------------------------------------------
+
+struct ExtPerfCounters
+{
+    // Virtual memory reads sent to the engine.
+    ULONG64 ReadCalls;
+    ULONG64 ReadBytes;
+    // Reads served by the read cache and reads it
+    // had to pass on to the engine.
+    ULONG64 CacheHits;
+    ULONG64 CacheMisses;
+    // Out calls made and the engine output calls
+    // they turned into, which buffering reduces.
+    ULONG64 OutCalls;
+    ULONG64 OutEngineCalls;
+};
+
+struct ExtCommandStats
+{
+    ULONG64 Calls;
+    // QueryPerformanceCounter ticks.
+    ULONG64 Ticks;
+    ExtPerfCounters Counters;
+};
+
 //----------------------------------------------------------------------------
 //
 // Descriptive information kept for all extension commands.
@@ -992,6 +1024,9 @@ public:
     PCSTR m_ArgDescStr;
     bool m_ArgsInitialized;
 
+    // Accumulated over every invocation.
+    ExtCommandStats m_Stats;
+
     //
     // Derived by parsing the argument description string.
     //
@@ -1108,6 +1143,71 @@ struct ExtProvidedValue
     ExtProvideValueMethod Method;
 };
 
+//----------------------------------------------------------------------------
+//
+// Optional page-granular cache for virtual reads made through
+// ExtRemoteData.  Memory can only be trusted to stay the same
+// while the target is stopped, so the cache is flushed on every
+// session state change and writes through ExtRemoteData
+// invalidate the pages they touch.  Changes made to target memory
+// by other means while stopped, such as the debugger's own edit
+// commands, are not seen until the cache is flushed.
+//
+// Reads that miss fetch every page they cover with a single
+// ReadVirtual.  If that fails, for example because part of the
+// range isn't mapped, the read is passed through uncached so
+// partial read behavior is unchanged.
+//
+//----------------------------------------------------------------------------
+
+class ExtRemoteReadCache
+{
+public:
+    static const ULONG s_PageSize = 0x1000;
+    static const ULONG s_NumPages = 0x100;
+
+    ExtRemoteReadCache(void)
+    {
+        m_Pages = NULL;
+    }
+    ~ExtRemoteReadCache(void)
+    {
+        Enable(false);
+    }
+
+    void WINAPI Enable(_In_ bool Enable);
+    bool IsEnabled(void)
+    {
+        return m_Pages != NULL;
+    }
+
+    void WINAPI Flush(void);
+    void WINAPI Invalidate(_In_ ULONG64 Offset,
+                           _In_ ULONG Bytes);
+
+    HRESULT WINAPI ReadVirtual(_In_ ULONG64 Offset,
+                               _Out_writes_bytes_(Bytes) PVOID Buffer,
+                               _In_ ULONG Bytes,
+                               _Out_ PULONG Done);
+
+protected:
+    // Direct-mapped on the page number.
+    struct CachedPage
+    {
+        ULONG64 Base;
+        bool Valid;
+        UCHAR Data[s_PageSize];
+    };
+
+    CachedPage* Lookup(_In_ ULONG64 Base)
+    {
+        CachedPage* Page = &m_Pages[(Base / s_PageSize) % s_NumPages];
+        return Page->Valid && Page->Base == Base ? Page : NULL;
+    }
+
+    CachedPage* m_Pages;
+};
+
 //----------------------------------------------------------------------------
 //
 // Base class for all extensions.  An extension DLL will
@@ -1229,6 +1329,23 @@ public:
 
     bool m_IsRemote;
     bool m_OutCallbacksDmlAware;
+
+    // Optional cache for virtual reads made through ExtRemoteData,
+    // disabled unless the extension turns it on.
+    ExtRemoteReadCache m_ReadCache;
+
+    // Running totals, see ExtPerfCounters.  Resetting also
+    // clears the statistics kept for every command.
+    ExtPerfCounters m_PerfCounters;
+
+    void WINAPI ResetPerfCounters(void);
+
+    // All virtual reads EngExtCpp makes go through here
+    // so that they are counted.
+    HRESULT WINAPI CountedReadVirtual(_In_ ULONG64 Offset,
+                                      _Out_writes_bytes_(Bytes) PVOID Buffer,
+                                      _In_ ULONG Bytes,
+                                      _Out_opt_ PULONG Done);
     
     bool IsUserMode(void)
     {
@@ -1368,6 +1485,27 @@ public:
     void WINAPIV DmlVerb(_In_ PCWSTR Format,
                          ...);
 
+    //
+    // Output buffering.  While m_OutBuffered is set, Out
+    // formats into a local buffer and hands the text to the
+    // engine in large chunks rather than with one call per
+    // line.  Buffered text is flushed once it passes
+    // s_OutBufferFlushChars, when the output mask or character
+    // width changes, before any other kind of output and at
+    // the end of every command.  FlushOut can be used for
+    // explicit flush points, such as before a long wait.
+    //
+    // Formatting is done by the CRT, so formats relying on
+    // the engine's own %p, %m, %y and %N conversions are
+    // passed through unbuffered.
+    //
+
+    static const ULONG s_OutBufferFlushChars = 0x4000;
+
+    bool m_OutBuffered;
+
+    void WINAPI FlushOut(void);
+
     void DmlCmdLink(_In_ PCSTR Text,
                     _In_ PCSTR Cmd)
     {
@@ -1985,6 +2123,20 @@ public:
                                                _In_ BOOL fCase);
     HMODULE m_DbgHelp;
     PFN_SymMatchStringA m_SymMatchStringA;
+
+    bool WINAPI BufferOutVa(_In_ PCSTR Format,
+                            _In_ va_list Args);
+    bool WINAPI BufferOutVa(_In_ PCWSTR Format,
+                            _In_ va_list Args);
+
+    // At most one of these holds text at a time.
+    ExtBuffer<char> m_OutBuffer;
+    ExtBuffer<WCHAR> m_OutBufferWide;
+    ULONG m_OutBufferMask;
+
+    // Bumped by ResetPerfCounters so a command
+    // spanning a reset doesn't record a negative delta.
+    ULONG m_PerfCounterResets;
     
     struct ArgVal
     {
@@ -2572,6 +2724,127 @@ protected:
     }
 };
 
+//----------------------------------------------------------------------------
+//
+// ExtRemoteScatterRead batches many small reads of debuggee
+// memory.  Requests are queued with Add, then Read sorts them by
+// address, merges those that overlap, touch or are separated by
+// no more than the gap threshold and fetches each merged range
+// with a single ReadVirtual.  A merged range that can't be read
+// as a whole falls back to reading its requests one at a time,
+// so an unreadable page only fails the requests that touch it.
+//
+// Results are looked up by the index Add returned.  Reading a
+// request that failed throws like ExtRemoteData does.
+//
+// s_DefaultMaxGap suits requests for a few values each.  Callers
+// that already coalesce their requests should pass the gap they
+// coalesced with, so merging here agrees with their plan.
+//
+//----------------------------------------------------------------------------
+
+class ExtRemoteScatterRead
+{
+public:
+    static const ULONG s_DefaultMaxGap = 0x100;
+    static const ULONG s_MaxMergedBytes = 0x100000;
+
+    ExtRemoteScatterRead(_In_ ULONG MaxGap = s_DefaultMaxGap)
+    {
+        m_MaxGap = MaxGap;
+        m_NumReads = 0;
+    }
+
+    // Queues a request and returns its index.
+    ULONG WINAPI Add(_In_ ULONG64 Offset,
+                     _In_ ULONG Bytes);
+    void Clear(void)
+    {
+        m_Requests.Empty();
+        m_Data.Empty();
+        m_NumReads = 0;
+    }
+
+    // Reads every queued request.  Returns the
+    // number of requests that couldn't be read.
+    ULONG WINAPI Read(void);
+
+    ULONG GetNumRequests(void) const
+    {
+        return m_Requests.GetEltsUsed();
+    }
+    // ReadVirtual calls issued by the last Read.
+    ULONG GetNumReads(void) const
+    {
+        return m_NumReads;
+    }
+
+    bool Succeeded(_In_ ULONG Index)
+    {
+        return GetRequest(Index)->Succeeded;
+    }
+    PVOID WINAPI GetData(_In_ ULONG Index);
+
+    template<typename _T>
+    _T GetValue(_In_ ULONG Index)
+    {
+        _T Value;
+        if (GetRequest(Index)->Bytes != sizeof(Value))
+        {
+            throw ExtStatusException(E_INVALIDARG,
+                                     "ExtRemoteScatterRead::GetValue "
+                                     "size mismatch");
+        }
+        memcpy(&Value, GetData(Index), sizeof(Value));
+        return Value;
+    }
+    UCHAR GetUchar(_In_ ULONG Index)
+    {
+        return GetValue<UCHAR>(Index);
+    }
+    USHORT GetUshort(_In_ ULONG Index)
+    {
+        return GetValue<USHORT>(Index);
+    }
+    ULONG GetUlong(_In_ ULONG Index)
+    {
+        return GetValue<ULONG>(Index);
+    }
+    ULONG64 GetUlong64(_In_ ULONG Index)
+    {
+        return GetValue<ULONG64>(Index);
+    }
+
+protected:
+    struct Request
+    {
+        ULONG64 Offset;
+        ULONG Bytes;
+        ULONG DataOffset;
+        bool Succeeded;
+    };
+
+    Request* GetRequest(_In_ ULONG Index)
+    {
+        if (Index >= m_Requests.GetEltsUsed())
+        {
+            throw ExtStatusException(E_INVALIDARG,
+                                     "ExtRemoteScatterRead "
+                                     "invalid request index");
+        }
+        return &m_Requests.GetBuffer()[Index];
+    }
+
+    void WINAPI ReadRequests(_In_reads_(Count) const ULONG* Order,
+                             _In_ ULONG Count);
+
+    ExtBuffer<Request> m_Requests;
+    ExtBuffer<UCHAR> m_Data;
+    ExtBuffer<UCHAR> m_Span;
+    ULONG m_MaxGap;
+    ULONG m_NumReads;
+};
+
 //----------------------------------------------------------------------------
 //
 // ExtRemoteTyped is an enhanced remote data object that understands
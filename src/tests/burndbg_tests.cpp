@@ -0,0 +1,1467 @@
+//----------------------------------------------------------------------------
+// Tests for the memory sources that read targets from outside the debugger:
+// minidumps, savestates when built with zlib, and on Linux, live processes.
+// The symbol cache is tested against a provider that counts its lookups, and
+// the read planner on its own and under the sparse refine that uses it.
+//
+// Each source is pointed at something built here with known contents, down
+// to the malformed cases its parser has to turn away, and what it reads back
+// is checked byte for byte. Files are written to the working directory and
+// removed again afterwards.
+//----------------------------------------------------------------------------
+
+#if defined(_WIN32)
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+#include <climits>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#if defined(BURNDBG_SAVESTATES)
+#include <zlib.h>
+#endif
+
+#include "buffermemorysource.h"
+#include "fbneosavestate.h"
+#include "linuxprocessmemorysource.h"
+#include "m68kregion.h"
+#include "memorysource.h"
+#include "memscanslot.h"
+#include "minidumpmemorysource.h"
+#include "readplanner.h"
+#include "symbolcache.h"
+
+namespace
+{
+    int s_numFailures = 0;
+
+    void Fail(const char* pFormat, ...)
+    {
+        va_list args;
+        va_start(args, pFormat);
+        fprintf(stderr, "FAILED: ");
+        vfprintf(stderr, pFormat, args);
+        fprintf(stderr, "\n");
+        va_end(args);
+        ++s_numFailures;
+    }
+
+    // Bytes that differ from one address to the next, so a read from the wrong place shows
+    uint8_t PatternByte(uint64_t address)
+    {
+        return static_cast<uint8_t>((address >> 8) * 7 + address * 13 + 1);
+    }
+
+    std::vector<uint8_t> MakePattern(uint64_t address, size_t size)
+    {
+        std::vector<uint8_t> bytes(size);
+        for (size_t i = 0; i < size; ++i)
+        {
+            bytes[i] = PatternByte(address + i);
+        }
+
+        return bytes;
+    }
+
+    bool WriteFile(const char* pPath, const std::vector<uint8_t>& bytes)
+    {
+        FILE* pFile = fopen(pPath, "wb");
+        if (!pFile)
+        {
+            Fail("unable to create %s", pPath);
+            return false;
+        }
+
+        const bool Written = fwrite(bytes.data(), 1, bytes.size(), pFile) == bytes.size();
+        if (fclose(pFile) != 0 || !Written)
+        {
+            Fail("unable to write %s", pPath);
+            return false;
+        }
+
+        return true;
+    }
+
+    // Checks that size bytes at address read back as the pattern, both through Read and,
+    // when expectDirect is set, in place
+    void CheckPatternRead(IMemorySource& memory, const char* pCase, uint64_t address, uint32_t size, bool expectDirect)
+    {
+        const std::vector<uint8_t> Expected = MakePattern(address, size);
+        std::vector<uint8_t> buffer(size);
+        if (!memory.Read(address, buffer.data(), size) || buffer != Expected)
+        {
+            Fail("%s: read of 0x%llx bytes at 0x%llx", pCase, static_cast<unsigned long long>(size),
+                static_cast<unsigned long long>(address));
+        }
+
+        const uint8_t* pDirect = memory.GetDirectPointer(address, size);
+        if (expectDirect && (!pDirect || memcmp(pDirect, Expected.data(), size) != 0))
+        {
+            Fail("%s: direct pointer to 0x%llx bytes at 0x%llx", pCase, static_cast<unsigned long long>(size),
+                static_cast<unsigned long long>(address));
+        }
+        else if (!expectDirect && pDirect)
+        {
+            Fail("%s: direct pointer to 0x%llx bytes at 0x%llx spans captured ranges", pCase,
+                static_cast<unsigned long long>(size), static_cast<unsigned long long>(address));
+        }
+    }
+
+    void CheckReadFails(IMemorySource& memory, const char* pCase, uint64_t address, uint32_t size)
+    {
+        std::vector<uint8_t> buffer(size);
+        if (memory.Read(address, buffer.data(), size) || memory.GetDirectPointer(address, size))
+        {
+            Fail("%s: 0x%llx bytes at 0x%llx should be unreadable", pCase, static_cast<unsigned long long>(size),
+                static_cast<unsigned long long>(address));
+        }
+    }
+
+    void CheckRegions(IMemorySource& memory, const char* pCase, const std::vector<MemoryRegionInfo>& expected)
+    {
+        std::vector<MemoryRegionInfo> regions;
+        memory.EnumerateRegions(regions);
+        bool same = regions.size() == expected.size();
+        for (size_t i = 0; same && i < regions.size(); ++i)
+        {
+            same = regions[i].Address == expected[i].Address && regions[i].Size == expected[i].Size;
+        }
+
+        if (!same)
+        {
+            Fail("%s: %zu regions, expected %zu", pCase, regions.size(), expected.size());
+        }
+    }
+
+    //------------------------------------------------------------------------
+    // Minidumps
+    //
+    // Dumps are laid out the way dbghelp writes them: the header, the stream
+    // directory, then streams and memory wherever they were appended.
+    //------------------------------------------------------------------------
+
+    constexpr char kMinidumpPath[] = "burndbg_tests.dmp";
+
+    constexpr uint32_t kMemoryListStream = 5;
+    constexpr uint32_t kMemory64ListStream = 9;
+    constexpr uint32_t kUnusedStream = 0;
+
+    class MinidumpBuilder
+    {
+    public:
+        explicit MinidumpBuilder(uint32_t numStreams)
+        {
+            m_bytes.reserve(32 + numStreams * 12);
+            Append32(0x504D444D);
+            Append32(0xA793);
+            Append32(numStreams);
+            Append32(32);
+            m_bytes.resize(32 + numStreams * 12, 0);
+        }
+
+        uint32_t GetRva() const
+        {
+            return static_cast<uint32_t>(m_bytes.size());
+        }
+
+        void Append(const std::vector<uint8_t>& bytes)
+        {
+            m_bytes.insert(m_bytes.end(), bytes.begin(), bytes.end());
+        }
+
+        void Append32(uint32_t value)
+        {
+            AppendBytes(&value, sizeof(value));
+        }
+
+        void Append64(uint64_t value)
+        {
+            AppendBytes(&value, sizeof(value));
+        }
+
+        // Overwrites bytes already appended, for breaking a dump after the fact
+        template<typename T>
+        void Patch(uint32_t rva, T value)
+        {
+            memcpy(&m_bytes[rva], &value, sizeof(value));
+        }
+
+        void SetStream(uint32_t index, uint32_t type, uint32_t rva, uint32_t size)
+        {
+            const uint32_t Entry[3] = { type, size, rva };
+            memcpy(&m_bytes[32 + index * 12], Entry, sizeof(Entry));
+        }
+
+        // Where a stream's size and RVA live in the directory
+        static uint32_t GetStreamSizeRva(uint32_t index)
+        {
+            return 32 + index * 12 + 4;
+        }
+
+        uint32_t GetStreamRva(uint32_t index) const
+        {
+            uint32_t rva;
+            memcpy(&rva, &m_bytes[GetStreamSizeRva(index) + 4], sizeof(rva));
+            return rva;
+        }
+
+        // Memory captured as a MemoryListStream, with each range's bytes appended
+        // ahead of the list
+        void AddMemoryList(uint32_t index, const std::vector<MemoryRegionInfo>& ranges)
+        {
+            std::vector<uint32_t> rvas;
+            for (const MemoryRegionInfo& Range : ranges)
+            {
+                rvas.push_back(GetRva());
+                Append(MakePattern(Range.Address, static_cast<size_t>(Range.Size)));
+            }
+
+            const uint32_t ListRva = GetRva();
+            Append32(static_cast<uint32_t>(ranges.size()));
+            for (size_t i = 0; i < ranges.size(); ++i)
+            {
+                Append64(ranges[i].Address);
+                Append32(static_cast<uint32_t>(ranges[i].Size));
+                Append32(rvas[i]);
+            }
+            SetStream(index, kMemoryListStream, ListRva, GetRva() - ListRva);
+        }
+
+        // Memory captured as a Memory64ListStream, with all of the bytes back to back
+        // after the list
+        void AddMemory64List(uint32_t index, const std::vector<MemoryRegionInfo>& ranges)
+        {
+            const uint32_t ListRva = GetRva();
+            const uint32_t ListSize = static_cast<uint32_t>(16 + ranges.size() * 16);
+            Append64(ranges.size());
+            Append64(ListRva + ListSize);
+            for (const MemoryRegionInfo& Range : ranges)
+            {
+                Append64(Range.Address);
+                Append64(Range.Size);
+            }
+            SetStream(index, kMemory64ListStream, ListRva, ListSize);
+
+            for (const MemoryRegionInfo& Range : ranges)
+            {
+                Append(MakePattern(Range.Address, static_cast<size_t>(Range.Size)));
+            }
+        }
+
+        std::vector<uint8_t>& GetBytes()
+        {
+            return m_bytes;
+        }
+
+    private:
+        void AppendBytes(const void* pData, size_t size)
+        {
+            const uint8_t* pBytes = static_cast<const uint8_t*>(pData);
+            m_bytes.insert(m_bytes.end(), pBytes, pBytes + size);
+        }
+
+        std::vector<uint8_t> m_bytes;
+    };
+
+    bool OpenMinidump(MinidumpMemorySource& dump, const std::vector<uint8_t>& bytes)
+    {
+        return WriteFile(kMinidumpPath, bytes) && dump.Open(kMinidumpPath);
+    }
+
+    // A full dump: the Memory64ListStream wins over the MemoryListStream that comes
+    // before it, and reads carry on across adjacent ranges but stop at gaps
+    void TestMinidumpMemory64List()
+    {
+        const char* pCase = "minidump Memory64List";
+        MinidumpBuilder builder(3);
+        builder.AddMemoryList(0, { { 0x70000, 0x100 } });
+        builder.SetStream(1, kUnusedStream, 0, 0);
+        builder.AddMemory64List(2, { { 0x20000, 0x1000 }, { 0x10000, 0x200 }, { 0x10200, 0x80 }, { 0x30000, 0 } });
+
+        MinidumpMemorySource dump;
+        if (!OpenMinidump(dump, builder.GetBytes()))
+        {
+            Fail("%s: didn't open", pCase);
+            return;
+        }
+
+        CheckRegions(dump, pCase, { { 0x10000, 0x200 }, { 0x10200, 0x80 }, { 0x20000, 0x1000 } });
+        CheckPatternRead(dump, pCase, 0x10000, 0x200, true);
+        CheckPatternRead(dump, pCase, 0x101F0, 0x10, true);
+        CheckPatternRead(dump, pCase, 0x101F0, 0x20, false);
+        CheckPatternRead(dump, pCase, 0x10000, 0x280, false);
+        CheckPatternRead(dump, pCase, 0x20FFF, 1, true);
+        CheckReadFails(dump, pCase, 0x70000, 0x10);
+        CheckReadFails(dump, pCase, 0x10270, 0x20);
+        CheckReadFails(dump, pCase, 0x20FFF, 2);
+        CheckReadFails(dump, pCase, 0xFFFF, 2);
+        CheckReadFails(dump, pCase, 0x30000, 1);
+    }
+
+    // A small dump: ranges come out sorted, and empty ones are dropped
+    void TestMinidumpMemoryList()
+    {
+        const char* pCase = "minidump MemoryList";
+        MinidumpBuilder builder(1);
+        builder.AddMemoryList(0, { { 0x50000, 0x40 }, { 0x40000, 0x100 }, { 0x40100, 0x20 }, { 0x60000, 0 } });
+
+        MinidumpMemorySource dump;
+        if (!OpenMinidump(dump, builder.GetBytes()))
+        {
+            Fail("%s: didn't open", pCase);
+            return;
+        }
+
+        CheckRegions(dump, pCase, { { 0x40000, 0x100 }, { 0x40100, 0x20 }, { 0x50000, 0x40 } });
+        CheckPatternRead(dump, pCase, 0x40000, 0x100, true);
+        CheckPatternRead(dump, pCase, 0x400F8, 0x28, false);
+        CheckPatternRead(dump, pCase, 0x50000, 0x40, true);
+        CheckReadFails(dump, pCase, 0x40110, 0x20);
+        CheckReadFails(dump, pCase, 0x60000, 1);
+
+        dump.Close();
+        CheckReadFails(dump, "closed minidump", 0x40000, 1);
+    }
+
+    // Every way a dump can claim more than the file holds is turned away
+    void TestMinidumpBounds()
+    {
+        struct BadDump
+        {
+            const char* pCase;
+            std::vector<uint8_t> Bytes;
+        };
+        std::vector<BadDump> badDumps;
+
+        {
+            MinidumpBuilder builder(1);
+            builder.AddMemoryList(0, { { 0x10000, 0x10 } });
+            builder.GetBytes()[0] = 'X';
+            badDumps.push_back({ "bad signature", builder.GetBytes() });
+        }
+        {
+            MinidumpBuilder builder(1);
+            builder.GetBytes().resize(31);
+            badDumps.push_back({ "short header", builder.GetBytes() });
+        }
+        {
+            MinidumpBuilder builder(1);
+            builder.AddMemoryList(0, { { 0x10000, 0x10 } });
+            builder.Patch<uint32_t>(8, 0x10000000);
+            badDumps.push_back({ "directory past the end", builder.GetBytes() });
+        }
+        {
+            MinidumpBuilder builder(1);
+            builder.AddMemoryList(0, { { 0x10000, 0x10 } });
+            builder.SetStream(0, kMemoryListStream, 0x100000, 4);
+            badDumps.push_back({ "MemoryList past the end", builder.GetBytes() });
+        }
+        {
+            // The count claims two descriptors, the stream only has room for one and a half
+            MinidumpBuilder builder(1);
+            builder.AddMemoryList(0, { { 0x10000, 0x10 }, { 0x20000, 0x10 } });
+            builder.Patch<uint32_t>(MinidumpBuilder::GetStreamSizeRva(0), 4 + 16 + 8);
+            badDumps.push_back({ "truncated MemoryList descriptor", builder.GetBytes() });
+        }
+        {
+            // The second descriptor's memory RVA
+            MinidumpBuilder builder(1);
+            builder.AddMemoryList(0, { { 0x10000, 0x10 }, { 0x20000, 0x10 } });
+            builder.Patch<uint32_t>(builder.GetStreamRva(0) + 4 + 16 + 12, builder.GetRva() - 8);
+            badDumps.push_back({ "MemoryList range past the end", builder.GetBytes() });
+        }
+        {
+            MinidumpBuilder builder(1);
+            builder.AddMemory64List(0, { { 0x10000, 0x10 }, { 0x20000, 0x10 } });
+            builder.Patch<uint32_t>(MinidumpBuilder::GetStreamSizeRva(0), 16 + 16 + 8);
+            badDumps.push_back({ "truncated Memory64List descriptor", builder.GetBytes() });
+        }
+        {
+            MinidumpBuilder builder(1);
+            builder.AddMemory64List(0, { { 0x10000, 0x10 }, { 0x20000, 0x10 } });
+            builder.GetBytes().pop_back();
+            badDumps.push_back({ "Memory64List range past the end", builder.GetBytes() });
+        }
+        {
+            // Large enough that the running file offset would wrap back into the file
+            MinidumpBuilder builder(1);
+            builder.AddMemory64List(0, { { 0x10000, 0x10 }, { 0x20000, 0x10 } });
+            builder.Patch<uint64_t>(builder.GetStreamRva(0) + 16 + 8, ~0ull - 0xF);
+            badDumps.push_back({ "Memory64List range wrapping around", builder.GetBytes() });
+        }
+        {
+            MinidumpBuilder builder(1);
+            builder.SetStream(0, kUnusedStream, 0, 0);
+            badDumps.push_back({ "no memory", builder.GetBytes() });
+        }
+
+        for (const BadDump& Dump : badDumps)
+        {
+            MinidumpMemorySource dump;
+            if (OpenMinidump(dump, Dump.Bytes))
+            {
+                Fail("minidump with %s opened", Dump.pCase);
+            }
+        }
+    }
+
+    // Two dumps of the same work RAM a frame apart, scanned offline the way !memscan
+    // scans a live target: an unknown-value scan of the first, then refines against the
+    // second, through both the dense path that filters the mapping in place and the
+    // sparse one that reads just the hits
+    void TestMinidumpScan()
+    {
+        const char* pCase = "minidump scan";
+        const M68KRegion Region = { "test RAM", 0x100000, 0x2000 };
+        const uint64_t HostBase = 0x20000;
+
+        std::vector<uint8_t> before = MakePattern(HostBase, Region.Size);
+        std::vector<uint8_t> after = before;
+        for (size_t i = 0; i < after.size(); i += 97)
+        {
+            after[i] -= 3;
+        }
+        for (size_t i = 0; i < after.size(); i += 89)
+        {
+            after[i] += 5;
+        }
+
+        MinidumpMemorySource dumps[2];
+        const std::vector<uint8_t>* const Images[2] = { &before, &after };
+        for (size_t i = 0; i < 2; ++i)
+        {
+            MinidumpBuilder builder(1);
+            const uint32_t MemoryRva = builder.GetRva() + 16 + 16;
+            builder.AddMemory64List(0, { { HostBase, Region.Size } });
+            memcpy(&builder.GetBytes()[MemoryRva], Images[i]->data(), Region.Size);
+
+            // Each dump needs its own file, as the first one stays mapped
+            char path[64];
+            snprintf(path, sizeof(path), "%s.%zu", kMinidumpPath, i);
+            if (!WriteFile(path, builder.GetBytes()) || !dumps[i].Open(path))
+            {
+                Fail("%s: dump %zu didn't open", pCase, i);
+                return;
+            }
+        }
+
+        std::vector<uint32_t> expected;
+        for (uint32_t offset = 0; offset < Region.Size; ++offset)
+        {
+            if (after[offset] < before[offset])
+            {
+                expected.push_back(offset);
+            }
+        }
+
+        MemScanSlot slot;
+        if (!slot.BeginUnknownScan(dumps[0], Region, HostBase, 1) || slot.GetNumEntries() != Region.Size ||
+            !slot.ScanForByte(dumps[1], Region, HostBase, 0, ScanPredicate::Decreased) ||
+            !slot.ScanForByte(dumps[1], Region, HostBase, 0, ScanPredicate::Unchanged))
+        {
+            Fail("%s: scans failed", pCase);
+            return;
+        }
+
+        std::vector<uint32_t> hits;
+        slot.GetHits().ForEach([&hits](uint32_t index)
+        {
+            hits.push_back(index);
+        });
+        if (hits != expected)
+        {
+            Fail("%s: %zu hits, expected %zu", pCase, hits.size(), expected.size());
+        }
+        else if (!hits.empty() && slot.GetHitM68KAddress(hits[0]) != Region.M68KBase + (hits[0] ^ 1))
+        {
+            Fail("%s: hit at 0x%x", pCase, slot.GetHitM68KAddress(hits[0]));
+        }
+
+        // Memory the dump didn't capture can't be scanned, and trying leaves the hits alone
+        const M68KRegion Missing = { "missing RAM", 0x200000, 0x2000 };
+        if (slot.BeginUnknownScan(dumps[0], Missing, 0x80000, 1) || slot.GetNumEntries() != expected.size())
+        {
+            Fail("%s: scan of memory the dump doesn't hold", pCase);
+        }
+
+        for (size_t i = 0; i < 2; ++i)
+        {
+            char path[64];
+            snprintf(path, sizeof(path), "%s.%zu", kMinidumpPath, i);
+            dumps[i].Close();
+            remove(path);
+        }
+    }
+
+    void TestMinidumps()
+    {
+        TestMinidumpMemory64List();
+        TestMinidumpMemoryList();
+        TestMinidumpBounds();
+        TestMinidumpScan();
+        remove(kMinidumpPath);
+    }
+
+#if defined(BURNDBG_SAVESTATES)
+    //------------------------------------------------------------------------
+    // Savestates
+    //
+    // States are made the way FBNeo writes them: the "FB1 " file id, then an
+    // "FS1 " chunk whose header ends in the length of the deflated driver
+    // state that follows it. Where that length sits varies, so the tests move
+    // it around the range the loader searches and put a length that looks
+    // right, but isn't followed by a zlib stream, ahead of it.
+    //------------------------------------------------------------------------
+
+    constexpr char kSavestateDirectory[] = "burndbg_tests_states";
+    constexpr char kSavestatePath[] = "burndbg_tests.fs";
+
+    // Longer than the loader's discard buffer and not a multiple of it, so skipping
+    // to the RAM takes several partial passes
+    constexpr SavestateLayout kTestLayout = { 0x18123, 0x20000, 0x10000000 };
+    constexpr uint32_t kTestStateTailSize = 0x3000;
+
+    // A driver state with the RAM at kTestLayout.RamOffset, filled from ramSeed
+    std::vector<uint8_t> MakeDriverState(uint64_t ramSeed, std::vector<uint8_t>& ramOut)
+    {
+        ramOut = MakePattern(ramSeed, kTestLayout.RamSize);
+        std::vector<uint8_t> state(static_cast<size_t>(kTestLayout.RamOffset), 0);
+        for (size_t i = 0; i < state.size(); i += 0x101)
+        {
+            state[i] = static_cast<uint8_t>(i >> 8);
+        }
+
+        state.insert(state.end(), ramOut.begin(), ramOut.end());
+        state.resize(state.size() + kTestStateTailSize, 0x5A);
+        return state;
+    }
+
+    // The chunk starts at chunkOffset, which is 4 in a plain savestate, with the length at
+    // lengthOffset within it
+    std::vector<uint8_t> MakeSavestate(const std::vector<uint8_t>& driverState, size_t chunkOffset, size_t lengthOffset)
+    {
+        uLongf compressedSize = compressBound(static_cast<uLong>(driverState.size()));
+        std::vector<uint8_t> compressed(compressedSize);
+        if (compress2(compressed.data(), &compressedSize, driverState.data(), static_cast<uLong>(driverState.size()), 6) != Z_OK)
+        {
+            Fail("unable to deflate a driver state");
+            return {};
+        }
+        compressed.resize(compressedSize);
+
+        std::vector<uint8_t> file(chunkOffset + lengthOffset, 0xFF);
+        memcpy(&file[0], "FB1 ", 4);
+        memcpy(&file[chunkOffset], "FS1 ", 4);
+        if (lengthOffset > 0x40)
+        {
+            const uint32_t Decoy = 0x10;
+            memcpy(&file[chunkOffset + 0x40], &Decoy, sizeof(Decoy));
+            file[chunkOffset + 0x44] = 0;
+            file[chunkOffset + 0x45] = 0;
+        }
+
+        const uint32_t Length = static_cast<uint32_t>(compressed.size());
+        file.insert(file.end(), reinterpret_cast<const uint8_t*>(&Length), reinterpret_cast<const uint8_t*>(&Length + 1));
+        file.insert(file.end(), compressed.begin(), compressed.end());
+        file.resize(file.size() + 0x20, 0);
+        return file;
+    }
+
+    void CheckSavestateRam(const char* pCase, const std::vector<uint8_t>& file, const std::vector<uint8_t>& expectedRam)
+    {
+        std::vector<uint8_t> ram;
+        if (!WriteFile(kSavestatePath, file))
+        {
+            return;
+        }
+
+        const bool Loaded = LoadSavestateRam(kSavestatePath, kTestLayout, ram);
+        if (expectedRam.empty() && Loaded)
+        {
+            Fail("savestate %s loaded", pCase);
+        }
+        else if (!expectedRam.empty() && (!Loaded || ram != expectedRam))
+        {
+            Fail("savestate %s: RAM %s", pCase, Loaded ? "differs" : "didn't load");
+        }
+    }
+
+    void TestSavestateRam()
+    {
+        std::vector<uint8_t> ram;
+        const std::vector<uint8_t> DriverState = MakeDriverState(0x100000, ram);
+
+        const size_t ChunkOffsets[] = { 4, 0x30 };
+        const size_t LengthOffsets[] = { 0x40, 0x5C, 0x80 };
+        for (const size_t ChunkOffset : ChunkOffsets)
+        {
+            for (const size_t LengthOffset : LengthOffsets)
+            {
+                char name[64];
+                snprintf(name, sizeof(name), "with its chunk at 0x%zx and length at 0x%zx", ChunkOffset, LengthOffset);
+                CheckSavestateRam(name, MakeSavestate(DriverState, ChunkOffset, LengthOffset), ram);
+            }
+        }
+
+        std::vector<uint8_t> file = MakeSavestate(DriverState, 4, 0x5C);
+        uint64_t offset = 0;
+        if (!WriteFile(kSavestatePath, file) || !FindSavestateRamOffset(kSavestatePath, ram, &offset) || offset != kTestLayout.RamOffset)
+        {
+            Fail("savestate RAM offset found at 0x%llx, expected 0x%llx", static_cast<unsigned long long>(offset),
+                static_cast<unsigned long long>(kTestLayout.RamOffset));
+        }
+        if (FindSavestateRamOffset(kSavestatePath, MakePattern(0x200000, 0x100), &offset))
+        {
+            Fail("savestate RAM offset found for RAM that isn't in the state");
+        }
+
+        // The state ends before the whole RAM
+        std::vector<uint8_t> shortRam;
+        std::vector<uint8_t> shortState = MakeDriverState(0x100000, shortRam);
+        shortState.resize(static_cast<size_t>(kTestLayout.RamOffset + kTestLayout.RamSize - 1));
+        CheckSavestateRam("with a short state", MakeSavestate(shortState, 4, 0x5C), {});
+
+        CheckSavestateRam("with its length past the search", MakeSavestate(DriverState, 4, 0x84), {});
+        CheckSavestateRam("with its chunk past the search", MakeSavestate(DriverState, 0x100, 0x40), {});
+
+        std::vector<uint8_t> truncated = file;
+        truncated.resize(truncated.size() / 2);
+        CheckSavestateRam("cut in half", truncated, {});
+
+        std::vector<uint8_t> corrupt = file;
+        for (size_t i = corrupt.size() / 4; i < corrupt.size() / 2; ++i)
+        {
+            corrupt[i] ^= 0x55;
+        }
+        CheckSavestateRam("with a corrupt stream", corrupt, {});
+
+        remove(kSavestatePath);
+    }
+
+    bool MakeDirectory(const char* pPath)
+    {
+#if defined(_WIN32)
+        return _mkdir(pPath) == 0;
+#else
+        return mkdir(pPath, 0755) == 0;
+#endif
+    }
+
+    void RemoveDirectory(const char* pPath)
+    {
+#if defined(_WIN32)
+        _rmdir(pPath);
+#else
+        rmdir(pPath);
+#endif
+    }
+
+    std::string GetSavestatePath(const char* pName)
+    {
+#if defined(_WIN32)
+        return std::string(kSavestateDirectory) + "\\" + pName;
+#else
+        return std::string(kSavestateDirectory) + "/" + pName;
+#endif
+    }
+
+    // A directory of states, one of which isn't, and a file that isn't one at all, loaded
+    // in parallel
+    void TestSavestateDirectory()
+    {
+        if (!MakeDirectory(kSavestateDirectory))
+        {
+            Fail("unable to create %s", kSavestateDirectory);
+            return;
+        }
+
+        const char* const Names[] = { "c.fs", "a.fs", "b.fs", "notes.txt", "d.fs" };
+        std::vector<std::vector<uint8_t>> rams(4);
+        for (size_t i = 0; i < 5; ++i)
+        {
+            std::vector<uint8_t> ram;
+            std::vector<uint8_t> file = MakeSavestate(MakeDriverState(0x100000 * (i + 1), ram), 4, 0x40);
+            if (Names[i][0] == 'd')
+            {
+                file[4] = 'X';
+            }
+            else if (Names[i][0] != 'n')
+            {
+                rams[Names[i][0] - 'a'] = ram;
+            }
+            WriteFile(GetSavestatePath(Names[i]).c_str(), file);
+        }
+
+        std::vector<std::string> paths;
+        if (!ListSavestates(kSavestateDirectory, paths) || paths.size() != 4 ||
+            paths[0] != GetSavestatePath("a.fs") || paths[3] != GetSavestatePath("d.fs"))
+        {
+            Fail("savestate directory listed %zu states", paths.size());
+        }
+        else
+        {
+            std::vector<LoadedSavestate> states;
+            LoadSavestates(paths, kTestLayout, 3, states);
+            for (size_t i = 0; i < states.size(); ++i)
+            {
+                const bool ShouldLoad = i < 3;
+                const uint8_t* pRam = states[i].Memory.GetDirectPointer(kTestLayout.RamAddress, kTestLayout.RamSize);
+                if (states[i].Path != paths[i] || states[i].Loaded != ShouldLoad ||
+                    (ShouldLoad && (!pRam || memcmp(pRam, rams[i].data(), kTestLayout.RamSize) != 0)))
+                {
+                    Fail("savestate %s from the directory %s", paths[i].c_str(), ShouldLoad ? "didn't load" : "loaded");
+                }
+            }
+        }
+
+        for (const char* pName : Names)
+        {
+            remove(GetSavestatePath(pName).c_str());
+        }
+        RemoveDirectory(kSavestateDirectory);
+
+        if (ListSavestates(kSavestateDirectory, paths))
+        {
+            Fail("listed savestates in a directory that doesn't exist");
+        }
+    }
+
+    // A lives counter going down by one from each state to the next, found by scanning
+    // the first state for its value and refining across the rest, then again starting
+    // from an unknown-value scan
+    void TestSavestateScan()
+    {
+        const uint32_t CounterOffset = 0x4567;
+        const char* const Names[] = { "1.fs", "2.fs", "3.fs" };
+        if (!MakeDirectory(kSavestateDirectory))
+        {
+            Fail("unable to create %s", kSavestateDirectory);
+            return;
+        }
+
+        std::vector<uint8_t> ram;
+        std::vector<uint8_t> driverState = MakeDriverState(0x100000, ram);
+        for (size_t i = 0; i < 3; ++i)
+        {
+            driverState[static_cast<size_t>(kTestLayout.RamOffset) + CounterOffset] = static_cast<uint8_t>(3 - i);
+            WriteFile(GetSavestatePath(Names[i]).c_str(), MakeSavestate(driverState, 4, 0x40));
+        }
+
+        std::vector<std::string> paths;
+        std::vector<LoadedSavestate> states;
+        if (ListSavestates(kSavestateDirectory, paths))
+        {
+            LoadSavestates(paths, kTestLayout, 0, states);
+        }
+
+        const M68KRegion Region = { "test RAM", 0x100000, kTestLayout.RamSize };
+        for (const bool Unknown : { false, true })
+        {
+            const char* pCase = Unknown ? "savestate unknown-value scan" : "savestate scan";
+            bool scanned = states.size() == 3;
+            MemScanSlot slot;
+            for (size_t i = 0; scanned && i < states.size(); ++i)
+            {
+                if (i == 0)
+                {
+                    scanned = Unknown ? slot.BeginUnknownScan(states[i].Memory, Region, kTestLayout.RamAddress, 1) :
+                        slot.ScanForByte(states[i].Memory, Region, kTestLayout.RamAddress, 3);
+                }
+                else
+                {
+                    scanned = slot.ScanForByte(states[i].Memory, Region, kTestLayout.RamAddress, 1, ScanPredicate::DecreasedBy);
+                }
+            }
+
+            std::vector<uint32_t> hits;
+            slot.GetHits().ForEach([&hits](uint32_t index)
+            {
+                hits.push_back(index);
+            });
+            if (!scanned)
+            {
+                Fail("%s: scans failed", pCase);
+            }
+            else if (hits.size() != 1 || hits[0] != CounterOffset)
+            {
+                Fail("%s: %zu hits, expected just the counter at 0x%x", pCase, hits.size(), CounterOffset);
+            }
+        }
+
+        for (const char* pName : Names)
+        {
+            remove(GetSavestatePath(pName).c_str());
+        }
+        RemoveDirectory(kSavestateDirectory);
+    }
+
+    void TestSavestates()
+    {
+        TestSavestateRam();
+        TestSavestateDirectory();
+        TestSavestateScan();
+    }
+#endif // BURNDBG_SAVESTATES
+
+#if defined(__linux__)
+    //------------------------------------------------------------------------
+    // Live processes
+    //
+    // The test reads its own memory through the same calls it would use on
+    // FBNeo: three pages with the middle one unmapped again, so batches have
+    // entries the kernel refuses partway through.
+    //------------------------------------------------------------------------
+
+    class ProcessPages
+    {
+    public:
+        ProcessPages()
+        {
+            m_pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+            void* pPages = mmap(nullptr, m_pageSize * 3, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (pPages == MAP_FAILED)
+            {
+                return;
+            }
+
+            m_pPages = static_cast<uint8_t*>(pPages);
+            munmap(m_pPages + m_pageSize, m_pageSize);
+            for (const size_t Page : { 0, 2 })
+            {
+                const std::vector<uint8_t> Pattern = MakePattern(GetAddress(Page, 0), m_pageSize);
+                memcpy(m_pPages + Page * m_pageSize, Pattern.data(), m_pageSize);
+            }
+        }
+
+        ~ProcessPages()
+        {
+            if (m_pPages)
+            {
+                munmap(m_pPages, m_pageSize);
+                munmap(m_pPages + m_pageSize * 2, m_pageSize);
+            }
+        }
+
+        bool IsMapped() const
+        {
+            return m_pPages != nullptr;
+        }
+
+        size_t GetPageSize() const
+        {
+            return m_pageSize;
+        }
+
+        uint64_t GetAddress(size_t page, size_t offset) const
+        {
+            return reinterpret_cast<uintptr_t>(m_pPages) + page * m_pageSize + offset;
+        }
+
+    private:
+        uint8_t* m_pPages = nullptr;
+        size_t m_pageSize = 0;
+    };
+
+    // A scatter read of one batch mixing readable entries with ones in the hole, or running
+    // into it, then one with more entries than a single process_vm_readv takes
+    void CheckProcessScatter(LinuxProcessMemorySource& process, const char* pCase, const ProcessPages& pages)
+    {
+        const size_t PageSize = pages.GetPageSize();
+        struct ScatterCase
+        {
+            uint64_t Address;
+            uint32_t Size;
+            bool Readable;
+        };
+        const ScatterCase Cases[] =
+        {
+            { pages.GetAddress(0, 0x10), 0x40, true },
+            { pages.GetAddress(1, 0x100), 0x20, false },
+            { pages.GetAddress(2, 0x80), 0x100, true },
+            { pages.GetAddress(0, PageSize - 0x10), 0x20, false },
+            { pages.GetAddress(0, PageSize - 0x10), 0x10, true },
+            { pages.GetAddress(2, 0), 0, true },
+            { pages.GetAddress(2, PageSize - 0x8), 0x8, true },
+        };
+
+        std::vector<std::vector<uint8_t>> buffers;
+        std::vector<ScatterReadEntry> entries;
+        for (const ScatterCase& Case : Cases)
+        {
+            buffers.emplace_back(Case.Size, 0xEE);
+        }
+        for (size_t i = 0; i < buffers.size(); ++i)
+        {
+            entries.push_back({ Cases[i].Address, buffers[i].data(), Cases[i].Size, !Cases[i].Readable });
+        }
+
+        if (process.ReadScatter(entries.data(), entries.size()))
+        {
+            Fail("%s: scatter read with unreadable entries succeeded", pCase);
+        }
+
+        for (size_t i = 0; i < entries.size(); ++i)
+        {
+            if (entries[i].Succeeded != Cases[i].Readable)
+            {
+                Fail("%s: scatter entry %zu %s", pCase, i, Cases[i].Readable ? "failed" : "succeeded");
+            }
+            else if (Cases[i].Readable && buffers[i] != MakePattern(Cases[i].Address, Cases[i].Size))
+            {
+                Fail("%s: scatter entry %zu read the wrong bytes", pCase, i);
+            }
+        }
+
+        const size_t NumSmallEntries = IOV_MAX * 2 + 3;
+        std::vector<uint8_t> smallBuffers(NumSmallEntries * 4);
+        entries.clear();
+        for (size_t i = 0; i < NumSmallEntries; ++i)
+        {
+            const size_t Page = i % 2 ? 2 : 0;
+            entries.push_back({ pages.GetAddress(Page, (i * 4) % PageSize), &smallBuffers[i * 4], 4, false });
+        }
+
+        if (!process.ReadScatter(entries.data(), entries.size()))
+        {
+            Fail("%s: scatter read of %zu entries failed", pCase, NumSmallEntries);
+        }
+        for (size_t i = 0; i < NumSmallEntries; ++i)
+        {
+            if (!entries[i].Succeeded || memcmp(&smallBuffers[i * 4], MakePattern(entries[i].Address, 4).data(), 4) != 0)
+            {
+                Fail("%s: entry %zu of %zu read the wrong bytes", pCase, i, NumSmallEntries);
+                break;
+            }
+        }
+    }
+
+    void CheckProcessHits(const MemScanSlot& slot, const char* pCase, const char* pScan, const std::vector<uint32_t>& expected)
+    {
+        std::vector<uint32_t> hits;
+        slot.GetHits().ForEach([&hits](uint32_t index)
+        {
+            hits.push_back(index);
+        });
+        if (hits != expected)
+        {
+            Fail("%s: %s left %zu hits, expected %zu", pCase, pScan, hits.size(), expected.size());
+        }
+    }
+
+    // MemScanSlot scanning the test's own stand-in for work RAM while the test changes
+    // it, as !memscan does between frames of a running game
+    void CheckProcessScan(LinuxProcessMemorySource& process, const char* pCase)
+    {
+        const M68KRegion Region = { "test RAM", 0x100000, 0x2000 };
+        std::vector<uint8_t> ram = MakePattern(0x100000, Region.Size);
+        const uint64_t HostBase = reinterpret_cast<uintptr_t>(ram.data());
+
+        const uint8_t Value = ram[0x123];
+        std::vector<uint32_t> expected;
+        for (uint32_t offset = 0; offset < Region.Size; ++offset)
+        {
+            if (ram[offset] == Value)
+            {
+                expected.push_back(offset);
+            }
+        }
+
+        MemScanSlot slot;
+        if (!slot.ScanForByte(process, Region, HostBase, Value))
+        {
+            Fail("%s: scan failed", pCase);
+            return;
+        }
+        CheckProcessHits(slot, pCase, "scan", expected);
+
+        // Every other hit goes up by one
+        std::vector<uint32_t> increased;
+        for (size_t i = 0; i < expected.size(); i += 2)
+        {
+            ++ram[expected[i]];
+            increased.push_back(expected[i]);
+        }
+        if (!slot.ScanForByte(process, Region, HostBase, 1, ScanPredicate::IncreasedBy))
+        {
+            Fail("%s: refine failed", pCase);
+            return;
+        }
+        CheckProcessHits(slot, pCase, "sparse refine", increased);
+        if (!increased.empty() && slot.GetHitM68KAddress(increased[0]) != Region.M68KBase + (increased[0] ^ 1))
+        {
+            Fail("%s: hit at 0x%x", pCase, slot.GetHitM68KAddress(increased[0]));
+        }
+
+        std::vector<uint32_t> changed;
+        if (!slot.BeginUnknownScan(process, Region, HostBase, 1))
+        {
+            Fail("%s: unknown scan failed", pCase);
+            return;
+        }
+        for (uint32_t offset = 5; offset < Region.Size; offset += 97)
+        {
+            ram[offset] ^= 0x80;
+            changed.push_back(offset);
+        }
+        if (!slot.ScanForByte(process, Region, HostBase, 0, ScanPredicate::Changed))
+        {
+            Fail("%s: dense refine failed", pCase);
+            return;
+        }
+        CheckProcessHits(slot, pCase, "dense refine", changed);
+    }
+
+    void TestProcess(bool forcePread)
+    {
+        const char* pCase = forcePread ? "process through /proc/pid/mem" : "process";
+        ProcessPages pages;
+        if (!pages.IsMapped())
+        {
+            Fail("%s: unable to map test pages", pCase);
+            return;
+        }
+
+        LinuxProcessMemorySource process;
+        if (!process.Attach(getpid()))
+        {
+            Fail("%s: unable to attach to self", pCase);
+            return;
+        }
+        if (forcePread)
+        {
+            process.DisableVmReadv();
+        }
+
+        const uint32_t PageSize = static_cast<uint32_t>(pages.GetPageSize());
+        CheckPatternRead(process, pCase, pages.GetAddress(0, 0), PageSize, false);
+        CheckPatternRead(process, pCase, pages.GetAddress(2, 3), PageSize - 3, false);
+        CheckReadFails(process, pCase, pages.GetAddress(1, 0), 1);
+        CheckReadFails(process, pCase, pages.GetAddress(0, PageSize - 1), 2);
+        CheckProcessScatter(process, pCase, pages);
+        CheckProcessScan(process, pCase);
+
+        // The hole must not show up as readable
+        std::vector<MemoryRegionInfo> regions;
+        process.EnumerateRegions(regions);
+        bool foundPages = false;
+        for (const MemoryRegionInfo& Region : regions)
+        {
+            const uint64_t Hole = pages.GetAddress(1, 0);
+            if (Hole - Region.Address < Region.Size)
+            {
+                Fail("%s: region at 0x%llx covers the unmapped page", pCase, static_cast<unsigned long long>(Region.Address));
+            }
+            foundPages |= pages.GetAddress(0, 0) - Region.Address < Region.Size;
+        }
+        if (!foundPages)
+        {
+            Fail("%s: no region covers the mapped pages", pCase);
+        }
+
+        if (LinuxProcessMemorySource().Attach(-1))
+        {
+            Fail("%s: attached to pid -1", pCase);
+        }
+    }
+
+    void TestProcesses()
+    {
+        TestProcess(false);
+        TestProcess(true);
+    }
+#endif // __linux__
+
+    //------------------------------------------------------------------------
+    // Symbol cache
+    //
+    // The provider answers from tables the test fills in, and counts what it
+    // was asked, so the test can tell a cached answer from a fresh lookup.
+    //------------------------------------------------------------------------
+
+    class FakeSymbolProvider : public ISymbolProvider
+    {
+    public:
+        bool GetModuleBase(const char* pModule, uint64_t* pBaseOut) override
+        {
+            ++NumModuleLookups;
+            const auto It = ModuleBases.find(pModule);
+            if (It == ModuleBases.end())
+            {
+                return false;
+            }
+
+            *pBaseOut = It->second;
+            return true;
+        }
+
+        bool GetSymbolAddress(const char* pSymbol, uint64_t* pAddressOut) override
+        {
+            ++NumSymbolLookups;
+            const auto It = SymbolAddresses.find(pSymbol);
+            if (It == SymbolAddresses.end())
+            {
+                return false;
+            }
+
+            *pAddressOut = It->second;
+            return true;
+        }
+
+        bool GetFieldOffset(const char* pModule, const char* pType, const char* pField, uint32_t* pOffsetOut) override
+        {
+            ++NumFieldLookups;
+            const auto It = FieldOffsets.find(std::string(pModule) + '!' + pType + '.' + pField);
+            if (It == FieldOffsets.end())
+            {
+                return false;
+            }
+
+            *pOffsetOut = It->second;
+            return true;
+        }
+
+        std::map<std::string, uint64_t> ModuleBases;
+        std::map<std::string, uint64_t> SymbolAddresses;
+        std::map<std::string, uint32_t> FieldOffsets;
+
+        int NumModuleLookups = 0;
+        int NumSymbolLookups = 0;
+        int NumFieldLookups = 0;
+    };
+
+    // Looks pSymbol up through the cache and checks both the answer and whether the
+    // provider had to be asked for it
+    void CheckSymbol(SymbolCache& cache, FakeSymbolProvider& provider, const char* pCase, const char* pSymbol,
+        uint64_t expected, bool expectLookup)
+    {
+        const int NumLookups = provider.NumSymbolLookups;
+        uint64_t address = 0;
+        if (!cache.GetSymbolAddress(pSymbol, &address) || address != expected)
+        {
+            Fail("%s: %s at 0x%llx, expected 0x%llx", pCase, pSymbol, static_cast<unsigned long long>(address),
+                static_cast<unsigned long long>(expected));
+        }
+
+        const bool LookedUp = provider.NumSymbolLookups != NumLookups;
+        if (LookedUp != expectLookup)
+        {
+            Fail("%s: %s %s the provider", pCase, pSymbol, LookedUp ? "went to" : "didn't go to");
+        }
+    }
+
+    void CheckField(SymbolCache& cache, FakeSymbolProvider& provider, const char* pCase, uint32_t expected, bool expectLookup)
+    {
+        const int NumLookups = provider.NumFieldLookups;
+        uint32_t offset = 0;
+        if (!cache.GetFieldOffset("fbneo", "SekExt", "MemMap", &offset) || offset != expected)
+        {
+            Fail("%s: SekExt.MemMap at 0x%x, expected 0x%x", pCase, offset, expected);
+        }
+
+        const bool LookedUp = provider.NumFieldLookups != NumLookups;
+        if (LookedUp != expectLookup)
+        {
+            Fail("%s: SekExt.MemMap %s the provider", pCase, LookedUp ? "went to" : "didn't go to");
+        }
+    }
+
+    void TestSymbolCacheHits()
+    {
+        FakeSymbolProvider provider;
+        provider.ModuleBases["fbneo"] = 0x140000000;
+        provider.SymbolAddresses["fbneo!Neo68KRAM"] = 0x140123000;
+        provider.FieldOffsets["fbneo!SekExt.MemMap"] = 0x18;
+        SymbolCache cache(provider);
+
+        CheckSymbol(cache, provider, "first lookup", "fbneo!Neo68KRAM", 0x140123000, true);
+        CheckSymbol(cache, provider, "repeated lookup", "fbneo!Neo68KRAM", 0x140123000, false);
+        CheckField(cache, provider, "first lookup", 0x18, true);
+        CheckField(cache, provider, "repeated lookup", 0x18, false);
+
+        // Answers come from the cache even once the provider would say otherwise
+        provider.SymbolAddresses["fbneo!Neo68KRAM"] = 0x140456000;
+        CheckSymbol(cache, provider, "stale provider", "fbneo!Neo68KRAM", 0x140123000, false);
+
+        cache.Invalidate();
+        CheckSymbol(cache, provider, "after Invalidate", "fbneo!Neo68KRAM", 0x140456000, true);
+        CheckField(cache, provider, "after Invalidate", 0x18, true);
+    }
+
+    void TestSymbolCacheRevalidation()
+    {
+        FakeSymbolProvider provider;
+        provider.ModuleBases["fbneo"] = 0x140000000;
+        provider.SymbolAddresses["fbneo!Neo68KRAM"] = 0x140123000;
+        SymbolCache cache(provider);
+        CheckSymbol(cache, provider, "before revalidation", "fbneo!Neo68KRAM", 0x140123000, true);
+
+        // Modules are only checked on the first lookup after a request, and staying put
+        // keeps the cache
+        const int NumModuleLookups = provider.NumModuleLookups;
+        cache.RequestRevalidation();
+        CheckSymbol(cache, provider, "module in place", "fbneo!Neo68KRAM", 0x140123000, false);
+        CheckSymbol(cache, provider, "module in place", "fbneo!Neo68KRAM", 0x140123000, false);
+        if (provider.NumModuleLookups != NumModuleLookups + 1)
+        {
+            Fail("revalidation: %d module lookups, expected 1", provider.NumModuleLookups - NumModuleLookups);
+        }
+
+        // A module that moved drops what was resolved against it
+        provider.ModuleBases["fbneo"] = 0x7FF600000000;
+        provider.SymbolAddresses["fbneo!Neo68KRAM"] = 0x7FF600123000;
+        CheckSymbol(cache, provider, "module moved, no request", "fbneo!Neo68KRAM", 0x140123000, false);
+        cache.RequestRevalidation();
+        CheckSymbol(cache, provider, "module moved", "fbneo!Neo68KRAM", 0x7FF600123000, true);
+        CheckSymbol(cache, provider, "module moved", "fbneo!Neo68KRAM", 0x7FF600123000, false);
+
+        // So does one that went away
+        provider.ModuleBases.clear();
+        provider.SymbolAddresses["fbneo!Neo68KRAM"] = 0x150123000;
+        cache.RequestRevalidation();
+        CheckSymbol(cache, provider, "module unloaded", "fbneo!Neo68KRAM", 0x150123000, true);
+    }
+
+    void TestSymbolCacheFailures()
+    {
+        FakeSymbolProvider provider;
+        SymbolCache cache(provider);
+
+        // Failures go back to the provider every time, so a symbol resolves as soon as
+        // its module loads
+        uint64_t address;
+        uint32_t offset;
+        for (int i = 0; i < 2; ++i)
+        {
+            if (cache.GetSymbolAddress("fbneo!Neo68KRAM", &address) || cache.GetFieldOffset("fbneo", "SekExt", "MemMap", &offset))
+            {
+                Fail("lookup of a symbol the provider doesn't have");
+            }
+        }
+        if (provider.NumSymbolLookups != 2 || provider.NumFieldLookups != 2)
+        {
+            Fail("failed lookups: %d symbol and %d field lookups, expected 2 each", provider.NumSymbolLookups,
+                provider.NumFieldLookups);
+        }
+
+        provider.ModuleBases["fbneo"] = 0x140000000;
+        provider.SymbolAddresses["fbneo!Neo68KRAM"] = 0x140123000;
+        provider.FieldOffsets["fbneo!SekExt.MemMap"] = 0x18;
+        CheckSymbol(cache, provider, "after load", "fbneo!Neo68KRAM", 0x140123000, true);
+        CheckField(cache, provider, "after load", 0x18, true);
+    }
+
+    void TestSymbolCache()
+    {
+        TestSymbolCacheHits();
+        TestSymbolCacheRevalidation();
+        TestSymbolCacheFailures();
+    }
+
+    //------------------------------------------------------------------------
+    // Read planning
+    //
+    // The planner on its own, then the sparse refine that reads through it,
+    // checked hit for hit against the same refine done one hit at a time.
+    //------------------------------------------------------------------------
+
+    void CheckReadPlan(const char* pCase, const std::vector<uint64_t>& addresses, uint32_t elementSize, uint32_t maxGap,
+        const std::vector<ReadRange>& expected)
+    {
+        // Ranges are appended after whatever the caller already has
+        std::vector<ReadRange> ranges(1, ReadRange{ 0xFFFF0000, 1 });
+        const size_t NumRanges = PlanCoalescedReads(addresses.data(), addresses.size(), elementSize, maxGap, ranges);
+        bool same = NumRanges == expected.size() && ranges.size() == expected.size() + 1 && ranges[0].Address == 0xFFFF0000;
+        for (size_t i = 0; same && i < expected.size(); ++i)
+        {
+            same = ranges[i + 1].Address == expected[i].Address && ranges[i + 1].Size == expected[i].Size;
+        }
+
+        if (!same)
+        {
+            Fail("%s: %zu ranges, expected %zu", pCase, NumRanges, expected.size());
+        }
+    }
+
+    void TestReadPlanner()
+    {
+        CheckReadPlan("no addresses", {}, 4, kDefaultMaxReadGap, {});
+        CheckReadPlan("one address", { 0x1001 }, 2, kDefaultMaxReadGap, { { 0x1001, 2 } });
+
+        // Gaps are the unused bytes between one value's end and the next one's start
+        CheckReadPlan("gap of kDefaultMaxReadGap", { 0x1000, 0x1004 + kDefaultMaxReadGap }, 4, kDefaultMaxReadGap,
+            { { 0x1000, 8 + kDefaultMaxReadGap } });
+        CheckReadPlan("gap past kDefaultMaxReadGap", { 0x1000, 0x1005 + kDefaultMaxReadGap }, 4, kDefaultMaxReadGap,
+            { { 0x1000, 4 }, { 0x1005 + kDefaultMaxReadGap, 4 } });
+        CheckReadPlan("one byte gap, no gaps allowed", { 0x1000, 0x1005 }, 4, 0, { { 0x1000, 4 }, { 0x1005, 4 } });
+
+        CheckReadPlan("adjacent", { 0x1000, 0x1004, 0x1008 }, 4, 0, { { 0x1000, 12 } });
+        CheckReadPlan("overlapping", { 0x1000, 0x1002, 0x1002, 0x1003 }, 4, 0, { { 0x1000, 7 } });
+        CheckReadPlan("contained", { 0x1000, 0x1001 }, 4, 0, { { 0x1000, 5 } });
+        // Ranges start where the values do, it's up to callers to widen them to host words
+        CheckReadPlan("odd start", { 0x1001, 0x1003, 0x2000, 0x2001 }, 2, kDefaultMaxReadGap,
+            { { 0x1001, 4 }, { 0x2000, 3 } });
+    }
+
+    // FBNeo keeps 68K memory as host-endian words
+    uint8_t ReadM68KByte(const uint8_t* pHost, uint32_t offset)
+    {
+        return pHost[offset ^ 1];
+    }
+
+    void WriteM68KByte(uint8_t* pHost, uint32_t offset, uint8_t value)
+    {
+        pHost[offset ^ 1] = value;
+    }
+
+    std::vector<uint32_t> GetHitM68KOffsets(const MemScanSlot& slot)
+    {
+        std::vector<uint32_t> offsets;
+        slot.GetHits().ForEach([&slot, &offsets](uint32_t index)
+        {
+            offsets.push_back(slot.GetHitM68KOffset(index));
+        });
+
+        return offsets;
+    }
+
+    // Refines a sparse slot with Changed and checks that the hits left are the ones a
+    // plain loop over the previous and current values keeps
+    void CheckSparseRefine(MemScanSlot& slot, BufferMemorySource& memory, const M68KRegion& region, uint64_t hostBase,
+        const char* pCase, const std::vector<uint8_t>& previous, const uint8_t* pCurrent)
+    {
+        if (slot.GetHits().IsDense())
+        {
+            Fail("%s: %u hits are dense", pCase, slot.GetNumEntries());
+            return;
+        }
+
+        std::vector<uint32_t> expected;
+        slot.GetHits().ForEach([&](uint32_t index)
+        {
+            const uint32_t Offset = slot.GetHitM68KOffset(index);
+            for (uint32_t i = 0; i < slot.GetSlotSize(); ++i)
+            {
+                if (ReadM68KByte(previous.data(), Offset + i) != ReadM68KByte(pCurrent, Offset + i))
+                {
+                    expected.push_back(index);
+                    break;
+                }
+            }
+        });
+
+        const bool Refined = slot.GetSlotSize() == 1
+            ? slot.ScanForByte(memory, region, hostBase, 0, ScanPredicate::Changed)
+            : slot.ScanForHalfWord(memory, region, hostBase, MakeScanOperand<uint16_t>(0), ScanPredicate::Changed, ScanAlignment::Any);
+        if (!Refined)
+        {
+            Fail("%s: refine failed", pCase);
+            return;
+        }
+
+        std::vector<uint32_t> hits;
+        slot.GetHits().ForEach([&hits](uint32_t index)
+        {
+            hits.push_back(index);
+        });
+        if (hits != expected)
+        {
+            Fail("%s: %zu hits, expected %zu", pCase, hits.size(), expected.size());
+        }
+    }
+
+    // Words are planted at odd 68K addresses, spread so that some are read together
+    // and some apart. Their low bytes are at even 68K addresses, which are odd host
+    // addresses, so the byte refine's read span has to start on the host word before
+    // the first one.
+    void TestSparseRefine()
+    {
+        const M68KRegion Region = { "test RAM", 0x100000, 0x4000 };
+        const uint64_t HostBase = 0x20000;
+        const uint32_t HitOffsets[] = { 0x101, 0x106, 0x10B, 0x520, 0x925 + kDefaultMaxReadGap, 0x2001, 0x3FFD };
+
+        // Planted values are the only bytes with the top bit set, so nothing else matches
+        BufferMemorySource memory;
+        uint8_t* pRam = memory.AddRegion(HostBase, Region.Size);
+        for (uint32_t i = 0; i < Region.Size; ++i)
+        {
+            pRam[i] = PatternByte(HostBase + i) & 0x7F;
+        }
+        for (const uint32_t Offset : HitOffsets)
+        {
+            WriteM68KByte(pRam, Offset, 0xA5);
+            WriteM68KByte(pRam, Offset + 1, 0xC3);
+        }
+
+        MemScanSlot bytes;
+        MemScanSlot words;
+        if (!bytes.ScanForByte(memory, Region, HostBase, 0xC3) ||
+            !words.ScanForHalfWord(memory, Region, HostBase, MakeScanOperand<uint16_t>(0xA5C3), ScanPredicate::Equal, ScanAlignment::Any))
+        {
+            Fail("sparse refine: first scan failed");
+            return;
+        }
+        const std::vector<uint32_t> Planted(HitOffsets, HitOffsets + sizeof(HitOffsets) / sizeof(HitOffsets[0]));
+        std::vector<uint32_t> lowBytes;
+        for (const uint32_t Offset : Planted)
+        {
+            lowBytes.push_back(Offset + 1);
+        }
+        if (GetHitM68KOffsets(bytes) != lowBytes || GetHitM68KOffsets(words) != Planted)
+        {
+            Fail("sparse refine: %u byte and %u word hits, expected %zu", bytes.GetNumEntries(), words.GetNumEntries(),
+                Planted.size());
+            return;
+        }
+
+        // Change every other word, the first one included, in alternate bytes of it
+        const std::vector<uint8_t> Previous(pRam, pRam + Region.Size);
+        for (size_t i = 0; i < Planted.size(); i += 2)
+        {
+            const uint32_t Changed = Planted[i] + 1 - (i / 2) % 2;
+            WriteM68KByte(pRam, Changed, ReadM68KByte(pRam, Changed) + 1);
+        }
+
+        CheckSparseRefine(bytes, memory, Region, HostBase, "sparse byte refine", Previous, pRam);
+        CheckSparseRefine(words, memory, Region, HostBase, "sparse odd word refine", Previous, pRam);
+        const std::vector<uint32_t> Refined = GetHitM68KOffsets(words);
+        if (Refined.empty() || Refined[0] != Planted[0])
+        {
+            Fail("sparse odd word refine: lost the hit at the start of the span");
+        }
+    }
+}
+
+int main()
+{
+    TestMinidumps();
+#if defined(BURNDBG_SAVESTATES)
+    TestSavestates();
+#endif
+#if defined(__linux__)
+    TestProcesses();
+#endif
+    TestSymbolCache();
+    TestReadPlanner();
+    TestSparseRefine();
+
+    if (s_numFailures)
+    {
+        fprintf(stderr, "%d check(s) failed\n", s_numFailures);
+        return 1;
+    }
+
+    printf("burndbg_tests: all passed\n");
+    return 0;
+}